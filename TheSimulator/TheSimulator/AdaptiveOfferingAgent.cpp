@@ -49,24 +49,20 @@ void AdaptiveOfferingAgent::receiveMessage(const MessagePtr& msg) {
 	} else if (msg->type == "WAKEUP_FOR_CANCELLATION") {
 		auto pptr = std::dynamic_pointer_cast<WakeupForCancellationPayload>(msg->payload);
 		if (pptr->orderToCancelId == m_currentOrder.id && m_currentOrder.id != 0) {
-			auto cpptr = std::make_shared<CancelOrdersPayload>();
-			cpptr->cancellations.push_back(CancelOrdersCancellation(m_currentOrder.id, m_currentOrder.offeredVolume));
-			simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "CANCEL_ORDERS", cpptr);
+			if (currentTimestamp >= m_currentOrder.timeOfPlacement + m_currentOrder.lifeTime) {
+				// the order is GTD, the exchange has cancelled it already
+				recordFulfillment(currentTimestamp);
+				simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+			} else {
+				auto cpptr = std::make_shared<CancelOrdersPayload>();
+				cpptr->cancellations.push_back(CancelOrdersCancellation(m_currentOrder.id, m_currentOrder.offeredVolume));
+				simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "CANCEL_ORDERS", cpptr);
+			}
 		} else {
 			simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
 		}
 	} else if (msg->type == "RESPONSE_CANCEL_ORDERS") {
-		const Volume tradedDelta = m_currentOrder.offeredVolume - m_currentOrder.currentVolume;
-		const Timestamp timeDelta = currentTimestamp - m_currentOrder.timeOfPlacement;
-		if(timeDelta > 0) {
-			auto& ffr = m_fulfillmentRates[m_currentOrder.centDeltaFromBestPrice];
-			ffr.push_back(std::make_pair(timeDelta, (double)tradedDelta / m_currentOrder.offeredVolume));
-			if (ffr.size() > m_memorySize) {
-				ffr.pop_front();
-			}
-		}
-
-		m_currentOrder.id = 0;
+		recordFulfillment(currentTimestamp);
 		simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
 	} else if (msg->type == "RESPONSE_RETRIEVE_L1") {
 		auto l1ptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
@@ -96,7 +92,8 @@ void AdaptiveOfferingAgent::receiveMessage(const MessagePtr& msg) {
 			auto delay = computeOrderCancellationDelay();
 			m_currentOrder.lifeTime = delay;
 			const Volume volumeToOrder = computeVolumeToOrder(inCents.cents(), delay);
-			auto pptr = std::make_shared<PlaceOrderLimitPayload>(direction, volumeToOrder, price);
+			// expires no later than the wakeup scheduled for it on the response
+			auto pptr = std::make_shared<PlaceOrderLimitPayload>(direction, volumeToOrder, price, TimeInForce::GTD, currentTimestamp + delay);
 			simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
 		}
 	} else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
@@ -134,6 +131,20 @@ void AdaptiveOfferingAgent::receiveMessage(const MessagePtr& msg) {
 	}
 }
 
+void AdaptiveOfferingAgent::recordFulfillment(Timestamp currentTimestamp) {
+	const Volume tradedDelta = m_currentOrder.offeredVolume - m_currentOrder.currentVolume;
+	const Timestamp timeDelta = currentTimestamp - m_currentOrder.timeOfPlacement;
+	if(timeDelta > 0) {
+		auto& ffr = m_fulfillmentRates[m_currentOrder.centDeltaFromBestPrice];
+		ffr.push_back(std::make_pair(timeDelta, (double)tradedDelta / m_currentOrder.offeredVolume));
+		if (ffr.size() > m_memorySize) {
+			ffr.pop_front();
+		}
+	}
+
+	m_currentOrder.id = 0;
+}
+
 Timestamp AdaptiveOfferingAgent::computeOrderCancellationDelay() {
 	Timestamp adjustedMeanOrderLifetime = (Timestamp)(m_orderMeanLifeTime * (1 + m_marketOrderFraction));
 	double nextCancellationRate = 1.0 / adjustedMeanOrderLifetime;
@@ -45,6 +45,8 @@ private:
 
 	AdaptiveOfferingAgentOrder m_currentOrder;
 
+	// once the current order is gone, learns how much of it was traded in how long
+	void recordFulfillment(Timestamp currentTimestamp);
 	Timestamp computeOrderCancellationDelay();
 	double computeTradingRateObservation(unsigned int priceCentsDeltaFromBest);
 	Volume computeVolumeToOrder(unsigned int priceCentsDeltaFromBest, Timestamp lifeTime);
@@ -2,10 +2,26 @@
 #include "ParameterStorage.h"
 
 #include "Simulation.h"
+#include "SimulationException.h"
 
 void Agent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
 	pugi::xml_attribute att;
 	if (!(att = node.attribute("name")).empty()) {
 		setName(simulation()->parameters().processString(att.as_string()) + configurationPath);
 	}
+
+	if (!(att = node.attribute("latencyGroup")).empty()) {
+		m_latencyGroup = simulation()->parameters().processString(att.as_string());
+	} else {
+		m_latencyGroup = node.name();
+	}
+}
+
+std::string Agent::branchOutputPath(const std::string& pathTemplate, const std::string& prefixPath) const {
+	const std::string path = simulation()->parameters().processString(pathTemplate);
+	if (path == prefixPath && simulation()->parameters().get("branchIndex") != "0") {
+		throw SimulationException("Agent::branchOutputPath(): every branch of '" + name() + "' would write to '" + path
+			+ "', make the path depend on ${branchIndex}");
+	}
+	return path;
 }
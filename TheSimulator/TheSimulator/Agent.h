@@ -3,17 +3,52 @@
 #include "Timestamp.h"
 #include "IMessageable.h"
 #include "IConfigurable.h"
+#include <cstdint>
 #include <string>
 
+// tells apart the wakeups an agent schedules for different purposes
+using WakeupTag = uint32_t;
+
 class Agent : public IMessageable, public IConfigurable {
 public:
 	virtual ~Agent() = default;
 
 	// Inherited via IConfigurable
 	virtual void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	// called once all the messages of the current timestamp have been delivered, if requested through Simulation::deferToEndOfTimestamp
+	virtual void endOfTimestamp() { }
+
+	// called at the time of a wakeup scheduled through Simulation::scheduleWakeup, with its tag
+	virtual void receiveWakeup(WakeupTag /*tag*/) { }
+
+	// prints a summary of the agent's internal state, for the 'agent' command of the interactive mode
+	virtual void printState() const { }
+
+	// a run forking into branches (see Simulation::reseedBranch): prepareBranching() is called before the fork, for the
+	// agent to write out what it buffers itself; beginBranch() in the process of every branch once its parameters and
+	// seeds are set, for the agent to drop the random numbers it drew ahead and move its outputs to the branch's own files
+	virtual void prepareBranching() { }
+	virtual void beginBranch() { }
+
+	// AGENTHANDLE_INVALID until the simulation has configured all of its agents
+	AgentHandle handle() const { return m_handle; }
+	// the group of the agent for the latency models of the simulation, the name of its node unless 'latencyGroup' is set
+	const std::string& latencyGroup() const { return m_latencyGroup; }
 protected:
 	Agent(const Simulation* simulation)
 		: Agent(simulation, "") { }
 	Agent(const Simulation* simulation, const std::string& name)
-		: IMessageable(simulation, name) { }
+		: IMessageable(simulation, name), m_handle(AGENTHANDLE_INVALID), m_latencyGroup() { }
+
+	// the path of an output file in a branch's process, the path template processed with the branch's parameters; the
+	// first branch may go on with the common prefix's file, for any other branch it would be shared and that throws
+	std::string branchOutputPath(const std::string& pathTemplate, const std::string& prefixPath) const;
+
+	friend class AgentFactory;
+private:
+	AgentHandle m_handle;
+	std::string m_latencyGroup;
+
+	friend class Simulation;
 };
\ No newline at end of file
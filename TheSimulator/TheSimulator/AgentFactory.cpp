@@ -0,0 +1,92 @@
+#include "AgentFactory.h"
+
+#include "ExchangeAgent.h"
+#include "TradeLogAgent.h"
+#include "OrderLogAgent.h"
+#include "L1LogAgent.h"
+#include "CaptureAgent.h"
+#include "StatsAgent.h"
+#include "BarAgent.h"
+#include "DepthSnapshotAgent.h"
+#include "BouchaudAgent.h"
+#include "ImpactAgent.h"
+#include "SetupAgent.h"
+#include "AdaptiveOfferingAgent.h"
+#include "RandomWalkMarketMakerAgent.h"
+#include "DoobAgent.h"
+#include "AngusAgents/Noise.h"
+#include "AngusAgents/ExchangePopulator.h"
+#include "AngusAgents/DownwardShock.h"
+#include "AngusAgents/Fundamental.h"
+#include "AngusAgents/MarketMaker.h"
+#include "AngusAgents/Momentum.h"
+#include "AngusAgents/NoisePopulation.h"
+#include "AngusAgents/MomentumPopulation.h"
+#include "AngusAgents/FundamentalPopulation.h"
+#include "AngusAgents/MarketMakerPopulation.h"
+
+#include "SimulationException.h"
+
+AgentFactory& AgentFactory::instance() {
+	static AgentFactory factory;
+	return factory;
+}
+
+AgentFactory::AgentFactory() {
+	// the exchange owns its books, a copy would share them
+	registerAgent<ExchangeAgent>("ExchangeAgent");
+
+	// the observers own their output file, buffers, estimators or book journal
+	registerAgent<L1LogAgent>("L1LogAgent");
+	registerAgent<CaptureAgent>("CaptureAgent");
+	registerAgent<StatsAgent>("StatsAgent");
+	registerAgent<BarAgent>("BarAgent");
+	registerAgent<DepthSnapshotAgent>("DepthSnapshotAgent");
+
+	// the logs hold their stream by a shared pointer, the copies of one write to the same file
+	registerClonableAgent<TradeLogAgent>("TradeLogAgent");
+	registerClonableAgent<OrderLogAgent>("OrderLogAgent");
+
+	// the traders, a count of them is copied from one configured prototype
+	registerClonableAgent<BouchaudAgent>("BouchaudAgent");
+	registerClonableAgent<ImpactAgent>("ImpactAgent");
+	registerClonableAgent<SetupAgent>("SetupAgent");
+	registerClonableAgent<AdaptiveOfferingAgent>("AdaptiveOfferingAgent");
+	registerClonableAgent<RandomWalkMarketMakerAgent>("RandomWalkMarketMakerAgent");
+	registerClonableAgent<DoobAgent>("DoobAgent");
+	registerClonableAgent<NoiseAgent>("NoiseAgent");
+	registerClonableAgent<DownwardShockAgent>("DownwardShockAgent");
+	registerClonableAgent<FundamentalAgent>("FundamentalAgent");
+	registerClonableAgent<MarketMakerAgent>("MarketMakerAgent");
+	registerClonableAgent<MomentumAgent>("MomentumAgent");
+	registerClonableAgent<ExchangePopulator>("ExchangePopulator");
+
+	// the populations, each copy holding its whole population
+	registerClonableAgent<NoisePopulationAgent>("NoisePopulationAgent");
+	registerClonableAgent<MomentumPopulationAgent>("MomentumPopulationAgent");
+	registerClonableAgent<FundamentalPopulationAgent>("FundamentalPopulationAgent");
+	registerClonableAgent<MarketMakerPopulationAgent>("MarketMakerPopulationAgent");
+}
+
+bool AgentFactory::isClonable(const std::string& nodeName) const {
+	auto it = m_entries.find(nodeName);
+	return it != m_entries.end() && it->second.cloner != nullptr;
+}
+
+std::unique_ptr<Agent> AgentFactory::create(const std::string& nodeName, const Simulation* simulation) const {
+	auto it = m_entries.find(nodeName);
+	if (it == m_entries.end()) {
+		throw SimulationException("AgentFactory::create(): no agent is registered for the node '" + nodeName + "'");
+	}
+
+	return it->second.creator(simulation);
+}
+
+std::unique_ptr<Agent> AgentFactory::clone(const std::string& nodeName, const Agent& prototype, const std::string& name) const {
+	auto it = m_entries.find(nodeName);
+	if (it == m_entries.end() || it->second.cloner == nullptr) {
+		throw SimulationException("AgentFactory::clone(): agents of the node '" + nodeName + "' can not be cloned");
+	}
+
+	return it->second.cloner(prototype, name);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Agent.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+class Simulation;
+
+using AgentCreator = std::function<std::unique_ptr<Agent>(const Simulation*)>;
+using AgentCloner = std::function<std::unique_ptr<Agent>(const Agent&, const std::string&)>;
+
+class AgentFactory {
+public:
+	static AgentFactory& instance();
+
+	// agents configured from scratch for every instance
+	template<class AgentType>
+	void registerAgent(const std::string& nodeName);
+	// agents whose configured state can be copied, a population of N parses its node once and copies the result N times
+	template<class AgentType>
+	void registerClonableAgent(const std::string& nodeName);
+
+	bool isRegistered(const std::string& nodeName) const { return m_entries.count(nodeName) > 0; }
+	bool isClonable(const std::string& nodeName) const;
+
+	std::unique_ptr<Agent> create(const std::string& nodeName, const Simulation* simulation) const;
+	std::unique_ptr<Agent> clone(const std::string& nodeName, const Agent& prototype, const std::string& name) const;
+private:
+	AgentFactory();
+
+	struct AgentFactoryEntry {
+		AgentCreator creator;
+		AgentCloner cloner;
+	};
+
+	std::unordered_map<std::string, AgentFactoryEntry> m_entries;
+
+	static void renameAgent(Agent& agent, const std::string& name) { agent.setName(name); }
+};
+
+template<class AgentType>
+inline void AgentFactory::registerAgent(const std::string& nodeName) {
+	m_entries[nodeName] = AgentFactoryEntry{
+		[](const Simulation* simulation) { return std::unique_ptr<Agent>(std::make_unique<AgentType>(simulation)); },
+		nullptr
+	};
+}
+
+template<class AgentType>
+inline void AgentFactory::registerClonableAgent(const std::string& nodeName) {
+	static_assert(std::is_copy_constructible<AgentType>::value, "AgentFactory::registerClonableAgent(): the agent type has to be copy constructible");
+
+	m_entries[nodeName] = AgentFactoryEntry{
+		[](const Simulation* simulation) { return std::unique_ptr<Agent>(std::make_unique<AgentType>(simulation)); },
+		[](const Agent& prototype, const std::string& name) {
+			auto clonePtr = std::make_unique<AgentType>(static_cast<const AgentType&>(prototype));
+			renameAgent(*clonePtr, name);
+			return std::unique_ptr<Agent>(std::move(clonePtr));
+		}
+	};
+}
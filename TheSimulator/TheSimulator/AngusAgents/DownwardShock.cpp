@@ -6,10 +6,10 @@
 
 
 DownwardShockAgent::DownwardShockAgent(const Simulation* simulation)
-    : Agent(simulation), spike_probability(0.0), volume_per_order(0) {}
+    : Agent(simulation), shock_topic(TOPICID_INVALID), spike_probability(0.0), volume_per_order(0) {}
 
 DownwardShockAgent::DownwardShockAgent(const Simulation* simulation, const std::string& name)
-    : Agent(simulation, name), spike_probability(0.0), volume_per_order(0) {}
+    : Agent(simulation, name), shock_topic(TOPICID_INVALID), spike_probability(0.0), volume_per_order(0) {}
 
 void DownwardShockAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
     Agent::configure(node, configurationPath);
@@ -42,22 +42,37 @@ void DownwardShockAgent::configure(const pugi::xml_node& node, const std::string
 
 }
 
+void DownwardShockAgent::receiveWakeup(WakeupTag /*tag*/) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    // Spike the price with probability spike_probability
+    if (uniform_dist(simulation()->randomGenerator()) < spike_probability) {
+        auto marketpayload = std::make_shared<PlaceOrderMarketPayload>(OrderDirection::Sell, volume_per_order);
+        simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDER_MARKET", marketpayload);
+        if (shock_topic != TOPICID_INVALID) {
+            simulation()->publish(currentTimestamp, 0, name(), shock_topic, "EVENT_SHOCK", marketpayload);
+        }
+    }
+
+    if (currentTimestamp < end_tick) {
+        simulation()->scheduleWakeup(this, currentTimestamp + 1);
+    } 
+}
+
 void DownwardShockAgent::receiveMessage(const MessagePtr& msg) {
     const Timestamp currentTimestamp = simulation()->currentTimestamp();
 
     if (msg->type == "EVENT_SIMULATION_START") {
-        simulation()->dispatchMessage(currentTimestamp, start_tick, name(), name(), "WAKEUP_FOR_DOWNWARD_SHOCK", std::make_shared<EmptyPayload>());
-    } else if (msg->type == "WAKEUP_FOR_DOWNWARD_SHOCK") {
-        auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
-
-        // Spike the price with probability spike_probability
-        if (uniform_dist(simulation()->randomGenerator()) < spike_probability) {
-            auto marketpayload = std::make_shared<PlaceOrderMarketPayload>(OrderDirection::Sell, volume_per_order);
-            simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDER_MARKET", marketpayload);
+        simulation()->scheduleWakeup(this, currentTimestamp + start_tick);
+    } else if (msg->type == "SUBSCRIBE_EVENT_SHOCK") {
+        const AgentHandle subscriber = simulation()->findAgentHandle(msg->source);
+        if (subscriber == AGENTHANDLE_INVALID) {
+            throw SimulationException("DownwardShockAgent::receiveMessage(): only agents can subscribe to the shocks of '" + name() + "': " + msg->source);
         }
-
-        if (currentTimestamp < end_tick) {
-            simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "WAKEUP_FOR_DOWNWARD_SHOCK", std::make_shared<EmptyPayload>());
-        } 
+        // registered on demand rather than in configure(), the copies of a prototype would share it otherwise
+        if (shock_topic == TOPICID_INVALID) {
+            shock_topic = simulation()->registerTopic(name() + "/EVENT_SHOCK");
+        }
+        simulation()->subscribeToTopic(shock_topic, subscriber);
     }
 }
\ No newline at end of file
@@ -16,9 +16,12 @@ class DownwardShockAgent : public Agent {
 
         // Inherited via Agent
         void receiveMessage(const MessagePtr& msg) override;
+        void receiveWakeup(WakeupTag tag) override;
     
     private:
         std::string exchange_1;
+        // every spike is published on it as EVENT_SHOCK, for the agents measuring what the shocks do to the market
+        TopicID shock_topic;
 
         double spike_probability;
         uint64_t volume_per_order;
@@ -45,25 +45,30 @@ void ExchangePopulator::configure(const pugi::xml_node& node, const std::string&
 
 }
 
+void ExchangePopulator::receiveWakeup(WakeupTag /*tag*/) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    // Populate the order book with limit orders, centered around initial price, all of them in one message
+    auto pptr = std::make_shared<PlaceOrdersPayload>();
+    pptr->orders.reserve(2 * num_levels_both_sides);
+    for (uint64_t i = 0; i < num_levels_both_sides; ++i) {
+        pptr->orders.push_back(PlaceOrdersOrder(OrderDirection::Buy, quantity_per_level, initial_price - (i * level_spacing)));
+        pptr->orders.push_back(PlaceOrdersOrder(OrderDirection::Sell, quantity_per_level, initial_price + (i * level_spacing)));
+    }
+    simulation()->dispatchMessage(currentTimestamp, 0, name(), exchange, "PLACE_ORDERS", pptr);
+    std::cout << "Populated" << std::endl;
+}
+
 void ExchangePopulator::receiveMessage(const MessagePtr& msg) {
     const Timestamp currentTimestamp = simulation()->currentTimestamp();
 
     if (msg->type == "EVENT_SIMULATION_START") {
-        simulation()->dispatchMessage(currentTimestamp, 0, name(), name(), "WAKEUP_FOR_POPULATOR", std::make_shared<EmptyPayload>());
-    } else if (msg->type == "WAKEUP_FOR_POPULATOR") {
-        // Populate the order book with limit orders, centered around initial price
-        for (uint64_t i = 0; i < num_levels_both_sides; ++i) {
-            auto pptr1 = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Buy, quantity_per_level, initial_price - (i * level_spacing));
-            simulation()->dispatchMessage(currentTimestamp, 0, name(), exchange, "PLACE_ORDER_LIMIT", pptr1);
-            auto pptr2 = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, quantity_per_level, initial_price + (i * level_spacing));
-            simulation()->dispatchMessage(currentTimestamp, 0, name(), exchange, "PLACE_ORDER_LIMIT", pptr2);
-        }
-        std::cout << "Populated" << std::endl;
-    } else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
+        simulation()->scheduleWakeup(this, currentTimestamp);
+    } else if (msg->type == "RESPONSE_PLACE_ORDERS") {
         // std::cout << "Received response for limit order placement" << std::endl;
-        // auto pptr = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(msg->payload);
+        // auto pptr = std::dynamic_pointer_cast<PlaceOrdersResponsePayload>(msg->payload);
         // if (pptr) {
-        //     std::cout << "Order placed with ID: " << pptr->id << std::endl;
+        //     std::cout << "Orders placed: " << pptr->ids.size() << std::endl;
         // }
     }
 }
\ No newline at end of file
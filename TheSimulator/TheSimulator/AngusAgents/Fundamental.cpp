@@ -52,13 +52,17 @@ void FundamentalAgent::configure(const pugi::xml_node& node, const std::string&
     //           << std::endl;
 }
 
+void FundamentalAgent::receiveWakeup(WakeupTag /*tag*/) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());  
+}
+
 void FundamentalAgent::receiveMessage(const MessagePtr& msg) {
     const Timestamp currentTimestamp = simulation()->currentTimestamp();
 
     if (msg->type == "EVENT_SIMULATION_START") {
-        simulation()->dispatchMessage(currentTimestamp, 0, name(), name(), "WAKEUP_FOR_FUNDAMENTAL", std::make_shared<EmptyPayload>());
-    } else if (msg->type == "WAKEUP_FOR_FUNDAMENTAL") {
-        simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());  
+        simulation()->scheduleWakeup(this, currentTimestamp);
     } else if (msg->type == "RESPONSE_RETRIEVE_L1") {
         auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
 
@@ -15,6 +15,7 @@ public:
 
     // Inherited via Agent
     void receiveMessage(const MessagePtr& msg) override;
+    void receiveWakeup(WakeupTag tag) override;
 
 private:
     std::string exchange_1;
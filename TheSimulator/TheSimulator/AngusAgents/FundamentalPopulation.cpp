@@ -0,0 +1,70 @@
+#include "FundamentalPopulation.h"
+#include "../Simulation.h"
+#include "../ParameterStorage.h"
+
+#include <cmath>
+
+FundamentalPopulationAgent::FundamentalPopulationAgent(const Simulation* simulation)
+    : FundamentalPopulationAgent(simulation, "") {}
+
+FundamentalPopulationAgent::FundamentalPopulationAgent(const Simulation* simulation, const std::string& name)
+    : PopulationAgent(simulation, name), fundamental_value_expectation(0.0), fundamental_value_std(0.0), k1(0.0), k2(0.0), num_fundamental_traders(1) {}
+
+void FundamentalPopulationAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+    PopulationAgent::configure(node, configurationPath);
+
+    pugi::xml_attribute att;
+    if (!(att = node.attribute("fundamental_value_expectation")).empty()) {
+        fundamental_value_expectation = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("fundamental_value_std")).empty()) {
+        fundamental_value_std = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("k1")).empty()) {
+        k1 = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("k2")).empty()) {
+        k2 = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("num_fundamental_traders")).empty()) {
+        num_fundamental_traders = std::stoull(simulation()->parameters().processString(att.as_string()));
+    }
+
+    normal_dist = std::normal_distribution<double>(fundamental_value_expectation, fundamental_value_std);
+}
+
+void FundamentalPopulationAgent::resizePopulation(size_t size) {
+    fundamental_values.resize(size);
+}
+
+Timestamp FundamentalPopulationAgent::decide(const RetrieveL1ResponsePayload& l1) {
+    auto price_per_unit = (l1.bestAskPrice + l1.bestBidPrice) / 2.0;
+    if (price_per_unit == (Decimal) 0) {
+        // Keep polling until there's a price
+        return 1;
+    }
+
+    // Every trader draws its own estimate of the fundamental value
+    auto& randomGenerator = simulation()->randomGenerator();
+    for (size_t trader = 0; trader < population_size; ++trader) {
+        fundamental_values[trader] = normal_dist(randomGenerator);
+    }
+
+    drawUniforms(population_size);
+    const double price = double(price_per_unit);
+    for (TraderIndex trader = 0; trader < population_size; ++trader) {
+        const double price_deviation = fundamental_values[trader] - price;
+        const double µ = (k1 * std::abs(price_deviation)) + (k2 * std::pow(std::abs(price_deviation), 3)) / num_fundamental_traders;
+
+        if (µ > uniforms[trader]) {
+            placeMarketOrder(trader, price_deviation > 0 ? OrderDirection::Buy : OrderDirection::Sell, DEFAULT_ORDER_VOLUME);
+        }
+    }
+
+    // Schedule the next wakeup
+    return 10;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "PopulationAgent.h"
+
+// Struct-of-arrays counterpart of FundamentalAgent, one instance trades for population_size fundamental traders
+class FundamentalPopulationAgent : public PopulationAgent {
+public:
+    FundamentalPopulationAgent(const Simulation* simulation);
+    FundamentalPopulationAgent(const Simulation* simulation, const std::string& name);
+
+    void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+protected:
+    void resizePopulation(size_t size) override;
+    Timestamp decide(const RetrieveL1ResponsePayload& l1) override;
+
+private:
+    std::vector<double> fundamental_values;
+
+    double fundamental_value_expectation;
+    double fundamental_value_std;
+    double k1;
+    double k2;
+    uint64_t num_fundamental_traders;
+
+    std::normal_distribution<double> normal_dist;
+
+    const uint64_t DEFAULT_ORDER_VOLUME = 25;
+};
@@ -44,13 +44,17 @@ void MarketMakerAgent::configure(const pugi::xml_node& node, const std::string&
     }
 }
 
+void MarketMakerAgent::receiveWakeup(WakeupTag /*tag*/) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());  
+}
+
 void MarketMakerAgent::receiveMessage(const MessagePtr& msg) {
     const Timestamp currentTimestamp = simulation()->currentTimestamp();
 
     if (msg->type == "EVENT_SIMULATION_START") {
-        simulation()->dispatchMessage(currentTimestamp, 0, name(), name(), "WAKEUP_FOR_MARKET_MAKER", std::make_shared<EmptyPayload>());
-    } else if (msg->type == "WAKEUP_FOR_MARKET_MAKER") {
-        simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());  
+        simulation()->scheduleWakeup(this, currentTimestamp);
     } else if (msg->type == "RESPONSE_RETRIEVE_L1") {
         auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
 
@@ -67,38 +71,40 @@ void MarketMakerAgent::receiveMessage(const MessagePtr& msg) {
 
         if (exceeded_risk_threshold) {
             // Cancel all orders
-            auto cancel_payload = std::make_shared<CancelOrdersPayload>();
-            for (auto& id: outstanding_orders) {
-                cancel_payload->cancellations.push_back(CancelOrdersCancellation(id, std::numeric_limits<unsigned int>::max()));
-            }
-            simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "CANCEL_ORDERS", cancel_payload);
+            cancelAllOrders(currentTimestamp);
 
-            // If position positive, sell excees
-            if (curr_position > 0) {
+            // the position only tells what is left to flatten once the flattening order has been responded to
+            if (is_flattening) {
+                // wait for the response
+            } else if (curr_position > 0) {
+                // If position positive, sell excees
                 auto marketpayload = std::make_shared<PlaceOrderMarketPayload>(OrderDirection::Sell, curr_position);
                 simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDER_MARKET", marketpayload);
+                is_flattening = true;
             } else if (curr_position < 0) {
                 // If position negative, buy excess
                 auto marketpayload = std::make_shared<PlaceOrderMarketPayload>(OrderDirection::Buy, -curr_position);
                 simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDER_MARKET", marketpayload);
+                is_flattening = true;
             }
         } else if (restart_counter == 0) {
-            if (uniform_dist(simulation()->randomGenerator()) < cancel_probability) {
-                // Cancel all limit orders
-                auto cancel_payload = std::make_shared<CancelOrdersPayload>();
-                for (auto& id: outstanding_orders) {
-                    cancel_payload->cancellations.push_back(CancelOrdersCancellation(id, std::numeric_limits<unsigned int>::max()));
+            const bool cancel_all = uniform_dist(simulation()->randomGenerator()) < cancel_probability;
+            const bool requote = uniform_dist(simulation()->randomGenerator()) < limit_order_probability;
+            const double price = double(pptr->bestBidPrice + pptr->bestAskPrice) / 2;
+
+            if (cancel_all && requote && outstanding_orders.contains(bid_quote_id) && outstanding_orders.contains(ask_quote_id)) {
+                // Move the live quote in one message, there is no moment without it, and cancel the rest
+                replaceQuote(currentTimestamp, price);
+                cancelAllOrders(currentTimestamp, true);
+            } else {
+                if (cancel_all) {
+                    // Cancel all limit orders
+                    cancelAllOrders(currentTimestamp);
                 }
-                simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "CANCEL_ORDERS", cancel_payload);
-            }
 
-            if (uniform_dist(simulation()->randomGenerator()) < limit_order_probability) {
-                double price = double(pptr->bestBidPrice + pptr->bestAskPrice) / 2;
-                // put both buy and sell limit orders
-                auto buy_payload = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Buy, DEFAULT_ORDER_VOLUME, price - (spread / 2));
-                auto sell_payload = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, DEFAULT_ORDER_VOLUME, price + (spread / 2));
-                simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDER_LIMIT", buy_payload);
-                simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDER_LIMIT", sell_payload);
+                if (requote) {
+                    placeQuote(currentTimestamp, price);
+                }
             }
         }
         restart_counter--;
@@ -106,42 +112,88 @@ void MarketMakerAgent::receiveMessage(const MessagePtr& msg) {
         // Poll for L1 again
         simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
         
-    } else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
-        auto pptr = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(msg->payload);
-        outstanding_orders.push_back(pptr->id);
+    } else if (msg->type == "RESPONSE_PLACE_ORDERS") {
+        // the position follows the fills of the orders, they come as the orders' trade events
+        auto pptr = std::dynamic_pointer_cast<PlaceOrdersResponsePayload>(msg->payload);
+        for (size_t i = 0; i < pptr->ids.size(); ++i) {
+            const PlaceOrdersOrder& order = pptr->requestPayload->orders[i];
+            auto subscription = std::make_shared<OrderTrackingPayload>(pptr->ids[i], order.direction, order.volume);
+            simulation()->dispatchMessage(currentTimestamp, 0, name(), exchange_1, "SUBSCRIBE_EVENT_ORDER_TRADE", subscription);
+        }
+        // the quotes are the only orders placed in bulk, bid first
+        bid_quote_id = pptr->ids[0];
+        ask_quote_id = pptr->ids[1];
+    } else if (msg->type == "RESPONSE_PLACE_ORDER_MARKET") {
+        // the flattening order, it has traded in full on arrival or what was left of it is gone
+        auto pptr = std::dynamic_pointer_cast<PlaceOrderMarketResponsePayload>(msg->payload);
+        addToPosition(pptr->requestPayload->direction, pptr->filledVolume);
+        is_flattening = false;
+    } else if (msg->type == "RESPONSE_SUBSCRIBE_EVENT_ORDER_TRADE") {
+        outstanding_orders.insertSubscribed(*msg, [this](OrderOwner, OrderDirection direction, Volume volume) {
+            addToPosition(direction, volume);
+        });
+    } else if (msg->type == "RESPONSE_REPLACE_ORDERS") {
+        auto pptr = std::dynamic_pointer_cast<ReplaceOrdersPayload>(msg->payload);
+        for (auto& replacement : pptr->replacements) {
+            outstanding_orders.remove(replacement.id);
+            if (replacement.volume > 0) {
+                outstanding_orders.insert(replacement.id, replacement.volume);
+            }
+        }
     } else if (msg->type == "RESPONSE_CANCEL_ORDERS") {
         auto pptr = std::dynamic_pointer_cast<CancelOrdersPayload>(msg->payload);
         for (auto& id: pptr->cancellations) {
-            auto it = std::find(outstanding_orders.begin(), outstanding_orders.end(), id.id);
-            if (it != outstanding_orders.end()) {
-                outstanding_orders.erase(it);
-            }
+            outstanding_orders.remove(id.id);
         }
-    } else if (msg->type == "RESPONSE_TRADE") {
+    } else if (msg->type == "EVENT_TRADE") {
         auto pptr = std::dynamic_pointer_cast<EventTradePayload>(msg->payload);
-        auto trade = pptr->trade;
+        outstanding_orders.fillTrade(pptr->trade, currentTimestamp, [this](OrderOwner, OrderDirection direction, Volume volume) {
+            addToPosition(direction, volume);
+        });
+    }
+   
+}
 
-        // Update position based on trade
-        if (trade.direction() == OrderDirection::Buy) {
-            curr_position += trade.volume();
-        } else if (trade.direction() == OrderDirection::Sell) {
-            curr_position -= trade.volume();
-        }
+void MarketMakerAgent::addToPosition(OrderDirection direction, Volume volume) {
+    if (direction == OrderDirection::Buy) {
+        curr_position += volume;
+    } else {
+        curr_position -= volume;
+    }
+}
 
-        // We remove both of these from the outstanding orders as MAXE does not specify if the aggressing order 
-        // or the resting order is the one that is belonging to the agent who received the trade event. Removing
-        // both is the safest option and does not cause any significant complexity issues.
+void MarketMakerAgent::cancelAllOrders(Timestamp currentTimestamp, bool keepQuote) {
+    if (outstanding_orders.empty()) {
+        return;
+    }
 
-        // Remove from outstanding orders
-        auto it = std::find(outstanding_orders.begin(), outstanding_orders.end(), pptr->trade.aggressingOrderID());
-        if (it != outstanding_orders.end()) {
-            outstanding_orders.erase(it);
-        }
-        // 
-        auto it2 = std::find(outstanding_orders.begin(), outstanding_orders.end(), pptr->trade.restingOrderID());
-        if (it2 != outstanding_orders.end()) {
-            outstanding_orders.erase(it2);
+    auto cancel_payload = std::make_shared<CancelOrdersPayload>();
+    cancel_payload->cancellations.reserve(outstanding_orders.size());
+    for (OrderID id : outstanding_orders.ids()) {
+        if (keepQuote && (id == bid_quote_id || id == ask_quote_id)) {
+            continue;
         }
+        cancel_payload->cancellations.push_back(CancelOrdersCancellation(id, std::numeric_limits<unsigned int>::max()));
     }
-   
+
+    if (!cancel_payload->cancellations.empty()) {
+        simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "CANCEL_ORDERS", cancel_payload);
+    }
+}
+
+void MarketMakerAgent::placeQuote(Timestamp currentTimestamp, double price) {
+    // put both buy and sell limit orders, as one quote
+    auto quote_payload = std::make_shared<PlaceOrdersPayload>(std::vector<PlaceOrdersOrder>{
+        PlaceOrdersOrder(OrderDirection::Buy, DEFAULT_ORDER_VOLUME, price - (spread / 2)),
+        PlaceOrdersOrder(OrderDirection::Sell, DEFAULT_ORDER_VOLUME, price + (spread / 2))
+    });
+    simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "PLACE_ORDERS", quote_payload);
+}
+
+void MarketMakerAgent::replaceQuote(Timestamp currentTimestamp, double price) {
+    auto replace_payload = std::make_shared<ReplaceOrdersPayload>(std::vector<ReplaceOrdersReplacement>{
+        ReplaceOrdersReplacement(bid_quote_id, price - (spread / 2), DEFAULT_ORDER_VOLUME),
+        ReplaceOrdersReplacement(ask_quote_id, price + (spread / 2), DEFAULT_ORDER_VOLUME)
+    });
+    simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "REPLACE_ORDERS", replace_payload);
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <random>
 #include <vector>
 #include "../ExchangeAgentMessagePayloads.h"
+#include "../OrderTracker.h"
 
 class MarketMakerAgent : public Agent {
     public: 
@@ -15,10 +16,24 @@ class MarketMakerAgent : public Agent {
 
         // Inherited via Agent
         void receiveMessage(const MessagePtr& msg) override;
+        void receiveWakeup(WakeupTag tag) override;
+
+        int64_t position() const { return curr_position; }
+        uint64_t maxRisk() const { return max_risk; }
     private:
         std::string exchange_1;
 
-        std::vector<OrderID> outstanding_orders;
+        OrderTracker outstanding_orders;
+        // the orders of the last quote placed, they are moved to the next quote instead of being cancelled
+        OrderID bid_quote_id{ORDERID_INVALID};
+        OrderID ask_quote_id{ORDERID_INVALID};
+
+        // keepQuote leaves the orders of the current quote alone
+        void cancelAllOrders(Timestamp currentTimestamp, bool keepQuote = false);
+        void placeQuote(Timestamp currentTimestamp, double price);
+        void replaceQuote(Timestamp currentTimestamp, double price);
+        // a fill of one of our orders
+        void addToPosition(OrderDirection direction, Volume volume);
         
         double limit_order_probability;
         double cancel_probability;
@@ -28,6 +43,8 @@ class MarketMakerAgent : public Agent {
         uint64_t num_market_makers;
 
         bool exceeded_risk_threshold{false};
+        // a market order flattening the position is on its way
+        bool is_flattening{false};
         uint64_t restart_counter{0};
         int64_t curr_position{0};
 
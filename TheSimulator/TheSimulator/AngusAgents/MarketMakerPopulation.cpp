@@ -0,0 +1,117 @@
+#include "MarketMakerPopulation.h"
+#include "../Simulation.h"
+#include "../ParameterStorage.h"
+
+#include <cstdlib>
+
+MarketMakerPopulationAgent::MarketMakerPopulationAgent(const Simulation* simulation)
+    : MarketMakerPopulationAgent(simulation, "") {}
+
+MarketMakerPopulationAgent::MarketMakerPopulationAgent(const Simulation* simulation, const std::string& name)
+    : PopulationAgent(simulation, name), limit_order_probability(0.0), cancel_probability(0.0), restart_interval(0), spread(0.0), max_risk(0) {}
+
+void MarketMakerPopulationAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+    PopulationAgent::configure(node, configurationPath);
+
+    pugi::xml_attribute att;
+    if (!(att = node.attribute("limit_order_probability")).empty()) {
+        limit_order_probability = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("cancel_probability")).empty()) {
+        cancel_probability = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("restart_interval")).empty()) {
+        restart_interval = std::stoull(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("spread")).empty()) {
+        spread = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("max_risk")).empty()) {
+        max_risk = std::stoull(simulation()->parameters().processString(att.as_string()));
+    }
+}
+
+void MarketMakerPopulationAgent::resizePopulation(size_t size) {
+    curr_position.assign(size, 0);
+    restart_counter.assign(size, 0);
+    exceeded_risk_threshold.assign(size, 0);
+    flattening.assign(size, 0);
+    cancel_all.assign(size, 0);
+}
+
+Timestamp MarketMakerPopulationAgent::decide(const RetrieveL1ResponsePayload& l1) {
+    const double price = double(l1.bestBidPrice + l1.bestAskPrice) / 2;
+
+    // Two draws per trader: cancellation, quoting
+    drawUniforms(2 * population_size);
+    for (TraderIndex trader = 0; trader < population_size; ++trader) {
+        const uint64_t risk = (uint64_t)std::llabs(curr_position[trader]);
+        cancel_all[trader] = 0;
+
+        if (risk > max_risk) {
+            // Cancel all orders if risk threshold is exceeded
+            exceeded_risk_threshold[trader] = 1;
+            restart_counter[trader] = restart_interval;
+        } else if (exceeded_risk_threshold[trader]) {
+            // Restart the trader if risk threshold is no longer exceeded
+            exceeded_risk_threshold[trader] = 0;
+        }
+
+        if (exceeded_risk_threshold[trader]) {
+            cancel_all[trader] = 1;
+
+            // Flatten the position, it only tells what is left to flatten once the last flattening order has been responded to
+            if (flattening[trader]) {
+                // wait for the response
+            } else if (curr_position[trader] > 0) {
+                placeMarketOrder(trader, OrderDirection::Sell, (Volume)curr_position[trader]);
+                flattening[trader] = 1;
+            } else if (curr_position[trader] < 0) {
+                placeMarketOrder(trader, OrderDirection::Buy, (Volume)-curr_position[trader]);
+                flattening[trader] = 1;
+            }
+        } else if (restart_counter[trader] == 0) {
+            const double* u = &uniforms[2 * (size_t)trader];
+            if (u[0] < cancel_probability) {
+                cancel_all[trader] = 1;
+            }
+
+            if (u[1] < limit_order_probability) {
+                // put both buy and sell limit orders
+                placeLimitOrder(trader, OrderDirection::Buy, DEFAULT_ORDER_VOLUME, price - (spread / 2));
+                placeLimitOrder(trader, OrderDirection::Sell, DEFAULT_ORDER_VOLUME, price + (spread / 2));
+            }
+        }
+
+        if (restart_counter[trader] > 0) {
+            --restart_counter[trader];
+        }
+    }
+
+    // One pass over the live orders of the whole population for the cancellations
+    const auto& owners = orders.owners();
+    for (size_t i = 0; i < owners.size(); ++i) {
+        if (cancel_all[owners[i]]) {
+            cancelOrder(i);
+        }
+    }
+
+    return 1;
+}
+
+void MarketMakerPopulationAgent::onFill(TraderIndex trader, OrderDirection direction, Volume volume) {
+    if (direction == OrderDirection::Buy) {
+        curr_position[trader] += volume;
+    } else {
+        curr_position[trader] -= volume;
+    }
+}
+
+void MarketMakerPopulationAgent::onMarketOrderDone(TraderIndex trader) {
+    // the market makers only place market orders to flatten
+    flattening[trader] = 0;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include "PopulationAgent.h"
+
+// Struct-of-arrays counterpart of MarketMakerAgent, one instance quotes for population_size market makers
+class MarketMakerPopulationAgent : public PopulationAgent {
+public:
+    MarketMakerPopulationAgent(const Simulation* simulation);
+    MarketMakerPopulationAgent(const Simulation* simulation, const std::string& name);
+
+    void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+protected:
+    void resizePopulation(size_t size) override;
+    Timestamp decide(const RetrieveL1ResponsePayload& l1) override;
+    void onFill(TraderIndex trader, OrderDirection direction, Volume volume) override;
+    void onMarketOrderDone(TraderIndex trader) override;
+
+private:
+    std::vector<int64_t> curr_position;
+    std::vector<uint64_t> restart_counter;
+    std::vector<uint8_t> exceeded_risk_threshold;
+    // a market order flattening the position is on its way
+    std::vector<uint8_t> flattening;
+    std::vector<uint8_t> cancel_all;
+
+    double limit_order_probability;
+    double cancel_probability;
+    uint64_t restart_interval;
+    double spread;
+    uint64_t max_risk;
+
+    const uint64_t DEFAULT_ORDER_VOLUME = 25;
+};
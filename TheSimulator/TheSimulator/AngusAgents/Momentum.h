@@ -5,6 +5,8 @@
 #include <random>
 #include <vector>
 #include "../ExchangeAgentMessagePayloads.h"
+#include "../OrderTracker.h"
+#include "../BernoulliSampler.h"
 
 class MomentumAgent : public Agent {
     public:
@@ -15,14 +17,16 @@ class MomentumAgent : public Agent {
 
         // Inherited via Agent
         void receiveMessage(const MessagePtr& msg) override;
+        void receiveWakeup(WakeupTag tag) override;
+        void beginBranch() override;
     private:
         std::string exchange_1;
 
-        std::vector<OrderID> outstanding_orders;
+        OrderTracker outstanding_orders;
         
         double momentum_signal{0.0};
         double previous_price{0.0};
-        double cancel_probability;
+        BernoulliSampler cancel_sampler;
         double market_to_limit_ratio;
         double demand_saturation;
         double alpha;
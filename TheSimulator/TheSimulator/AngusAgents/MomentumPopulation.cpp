@@ -0,0 +1,89 @@
+#include "MomentumPopulation.h"
+#include "../Simulation.h"
+#include "../ParameterStorage.h"
+
+#include <cmath>
+
+MomentumPopulationAgent::MomentumPopulationAgent(const Simulation* simulation)
+    : MomentumPopulationAgent(simulation, "") {}
+
+MomentumPopulationAgent::MomentumPopulationAgent(const Simulation* simulation, const std::string& name)
+    : PopulationAgent(simulation, name), cancel_sampler(0.0), market_to_limit_ratio(0.0), demand_saturation(0.0), alpha(0.0), beta(0.0), num_momentum_traders(1) {}
+
+void MomentumPopulationAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+    PopulationAgent::configure(node, configurationPath);
+
+    pugi::xml_attribute att;
+    if (!(att = node.attribute("cancel_probability")).empty()) {
+        cancel_sampler.setProbability(std::stod(simulation()->parameters().processString(att.as_string())));
+    }
+
+    if (!(att = node.attribute("market_to_limit_ratio")).empty()) {
+        market_to_limit_ratio = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("num_momentum_traders")).empty()) {
+        num_momentum_traders = std::stoull(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("alpha")).empty()) {
+        alpha = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("beta")).empty()) {
+        beta = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("demand_saturation")).empty()) {
+        demand_saturation = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+}
+
+void MomentumPopulationAgent::beginBranch() {
+    cancel_sampler.discardBatch();
+}
+
+void MomentumPopulationAgent::resizePopulation(size_t size) {
+    momentum_signal.assign(size, 0.0);
+    previous_price.assign(size, 0.0);
+}
+
+Timestamp MomentumPopulationAgent::decide(const RetrieveL1ResponsePayload& l1) {
+    // Cancel outstanding limit orders with probability cancel_probability
+    orders.sample(cancel_sampler, simulation()->randomGenerator(), [this](size_t index) {
+        cancelOrder(index);
+    });
+
+    const double price_per_unit = double(l1.bestAskPrice + l1.bestBidPrice) / 2.0;
+    if (price_per_unit == 0) {
+        // Keep polling until there's a price
+        return 1;
+    }
+
+    // Signal update for the whole population first, it does not depend on any random draw
+    for (size_t trader = 0; trader < population_size; ++trader) {
+        momentum_signal[trader] = momentum_signal[trader] * (1 - alpha) + alpha * (price_per_unit - previous_price[trader]);
+        previous_price[trader] = price_per_unit;
+    }
+
+    // Two draws per trader: market order, limit order
+    drawUniforms(2 * population_size);
+    for (TraderIndex trader = 0; trader < population_size; ++trader) {
+        const double signal = momentum_signal[trader];
+        const double probability_of_market_order = (beta * std::tanh(demand_saturation * signal)) / num_momentum_traders;
+        const double probability_of_limit_order = probability_of_market_order * market_to_limit_ratio;
+        const double* u = &uniforms[2 * (size_t)trader];
+
+        if (probability_of_market_order > u[0]) {
+            placeMarketOrder(trader, signal > 0 ? OrderDirection::Buy : OrderDirection::Sell, DEFAULT_ORDER_VOLUME);
+        } else if (probability_of_limit_order > u[1]) {
+            if (signal > 0) {
+                placeLimitOrder(trader, OrderDirection::Buy, DEFAULT_ORDER_VOLUME, price_per_unit - DEFAULT_OFFSET_FOR_LIMIT);
+            } else {
+                placeLimitOrder(trader, OrderDirection::Sell, DEFAULT_ORDER_VOLUME, price_per_unit + DEFAULT_OFFSET_FOR_LIMIT);
+            }
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "PopulationAgent.h"
+
+// Struct-of-arrays counterpart of MomentumAgent, one instance trades for population_size momentum traders
+class MomentumPopulationAgent : public PopulationAgent {
+public:
+    MomentumPopulationAgent(const Simulation* simulation);
+    MomentumPopulationAgent(const Simulation* simulation, const std::string& name);
+
+    void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+    void beginBranch() override;
+
+protected:
+    void resizePopulation(size_t size) override;
+    Timestamp decide(const RetrieveL1ResponsePayload& l1) override;
+
+private:
+    std::vector<double> momentum_signal;
+    std::vector<double> previous_price;
+
+    BernoulliSampler cancel_sampler;
+    double market_to_limit_ratio;
+    double demand_saturation;
+    double alpha;
+    double beta;
+    uint64_t num_momentum_traders;
+
+    const uint64_t DEFAULT_ORDER_VOLUME = 25;
+    const double DEFAULT_OFFSET_FOR_LIMIT = 0.5;
+};
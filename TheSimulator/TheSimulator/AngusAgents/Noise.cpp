@@ -6,10 +6,10 @@
 
 
 NoiseAgent::NoiseAgent(const Simulation* simulation)
-    : Agent(simulation), cancel_probability(0.0), market_to_limit_ratio(0.0), num_noise_traders(0), sigma(0.0) {}
+    : Agent(simulation), cancel_sampler(0.0), market_to_limit_ratio(0.0), num_noise_traders(0), sigma(0.0) {}
 
 NoiseAgent::NoiseAgent(const Simulation* simulation, const std::string& name)
-    : Agent(simulation, name), cancel_probability(0.0), market_to_limit_ratio(0.0), num_noise_traders(0), sigma(0.0) {}
+    : Agent(simulation, name), cancel_sampler(0.0), market_to_limit_ratio(0.0), num_noise_traders(0), sigma(0.0) {}
 
 
 void NoiseAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
@@ -21,7 +21,7 @@ void NoiseAgent::configure(const pugi::xml_node& node, const std::string& config
     }
 
     if (!(att = node.attribute("cancel_probability")).empty()) {
-        cancel_probability = std::stod(simulation()->parameters().processString(att.as_string()));
+        cancel_sampler.setProbability(std::stod(simulation()->parameters().processString(att.as_string())));
     }
 
     if (!(att = node.attribute("market_to_limit_ratio")).empty()) {
@@ -37,32 +37,39 @@ void NoiseAgent::configure(const pugi::xml_node& node, const std::string& config
     }
 
     // std::cout << "NoiseAgent: " << name() << " configured with exchange_1: " << exchange_1
-    //           << ", cancel_probability: " << cancel_probability
+    //           << ", cancel_probability: " << cancel_sampler.probability()
     //           << ", market_to_limit_ratio: " << market_to_limit_ratio
     //           << ", num_noise_traders: " << num_noise_traders
     //           << ", sigma: " << sigma
     //           << std::endl;
 }
 
+void NoiseAgent::beginBranch() {
+    // the next cancellations draw from the branch's own seed
+    cancel_sampler.discardBatch();
+}
+
+void NoiseAgent::receiveWakeup(WakeupTag /*tag*/) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());  
+}
+
 void NoiseAgent::receiveMessage(const MessagePtr& msg) {
     const Timestamp currentTimestamp = simulation()->currentTimestamp();
 
 
     if (msg->type == "EVENT_SIMULATION_START") {
-        simulation()->dispatchMessage(currentTimestamp, 0, name(), name(), "WAKEUP_FOR_NOISE", std::make_shared<EmptyPayload>());
-    } else if (msg->type == "WAKEUP_FOR_NOISE") {
-        simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());  
+        simulation()->scheduleWakeup(this, currentTimestamp);
     } else if (msg->type == "RESPONSE_RETRIEVE_L1") {
         auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
 
         // Cancel outstanding limit orders with probability cancel_probability
         auto cancel_payload = std::make_shared<CancelOrdersPayload>();
-        for (auto& id: outstanding_orders) {
-            if (uniform_dist(simulation()->randomGenerator()) < cancel_probability) {
-                // Max unsigned int so we don't need to specify a volume
-                cancel_payload->cancellations.push_back(CancelOrdersCancellation(id, std::numeric_limits<unsigned int>::max()));
-            }
-        }
+        outstanding_orders.sample(cancel_sampler, simulation()->randomGenerator(), [this, &cancel_payload](size_t index) {
+            // Max unsigned int so we don't need to specify a volume
+            cancel_payload->cancellations.push_back(CancelOrdersCancellation(outstanding_orders.id(index), std::numeric_limits<unsigned int>::max()));
+        });
 
         if (!cancel_payload->cancellations.empty()) {
             simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "CANCEL_ORDERS", cancel_payload);
@@ -108,29 +115,21 @@ void NoiseAgent::receiveMessage(const MessagePtr& msg) {
 
 
     } else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
+        // the fills of the order come as its trade events, the order is tracked from the response to the subscription on
         auto pptr = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(msg->payload);
-        outstanding_orders.push_back(pptr->id);
+        auto subscription = std::make_shared<OrderTrackingPayload>(pptr->id, pptr->requestPayload->direction, pptr->requestPayload->volume);
+        simulation()->dispatchMessage(currentTimestamp, 0, name(), exchange_1, "SUBSCRIBE_EVENT_ORDER_TRADE", subscription);
+    } else if (msg->type == "RESPONSE_SUBSCRIBE_EVENT_ORDER_TRADE") {
+        outstanding_orders.insertSubscribed(*msg);
     } else if (msg->type == "RESPONSE_CANCEL_ORDERS") {
         auto pptr = std::dynamic_pointer_cast<CancelOrdersPayload>(msg->payload);
         for (auto& cancellation : pptr->cancellations) {
-            auto it = std::find(outstanding_orders.begin(), outstanding_orders.end(), cancellation.id);
-            if (it != outstanding_orders.end()) {
-                outstanding_orders.erase(it);
-            }
+            outstanding_orders.remove(cancellation.id);
         }
 
-    // We remove both of these from the outstanding orders as MAXE does not specify if the aggressing order 
-    // or the resting order is the one that is belonging to the agent who received the trade event. Removing
-    // both is the safest option and does not cause any significant complexity issues.
-    } else if (msg->type == "RESPONSE_TRADE") {
+    // The trades of our limit orders
+    } else if (msg->type == "EVENT_TRADE") {
         auto pptr = std::dynamic_pointer_cast<EventTradePayload>(msg->payload);
-        auto it = std::find(outstanding_orders.begin(), outstanding_orders.end(), pptr->trade.aggressingOrderID());
-        if (it != outstanding_orders.end()) {
-            outstanding_orders.erase(it);
-        }
-        auto it2 = std::find(outstanding_orders.begin(), outstanding_orders.end(), pptr->trade.restingOrderID());
-        if (it2 != outstanding_orders.end()) {
-            outstanding_orders.erase(it2);
-        }
+        outstanding_orders.fillTrade(pptr->trade, currentTimestamp);
     }
 }
\ No newline at end of file
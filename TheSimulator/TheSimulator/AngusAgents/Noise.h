@@ -5,6 +5,8 @@
 #include <random>
 #include <vector>
 #include "../ExchangeAgentMessagePayloads.h"
+#include "../OrderTracker.h"
+#include "../BernoulliSampler.h"
 
 class NoiseAgent : public Agent {
 public:
@@ -15,13 +17,15 @@ public:
 
     // Inherited via Agent
     void receiveMessage(const MessagePtr& msg) override;
+    void receiveWakeup(WakeupTag tag) override;
+    void beginBranch() override;
 
 private:
     std::string exchange_1;
 
-    std::vector<OrderID> outstanding_orders;
+    OrderTracker outstanding_orders;
     
-    double cancel_probability;
+    BernoulliSampler cancel_sampler;
     double market_to_limit_ratio;
 
     uint64_t num_noise_traders;
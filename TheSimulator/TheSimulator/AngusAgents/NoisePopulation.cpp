@@ -0,0 +1,71 @@
+#include "NoisePopulation.h"
+#include "../Simulation.h"
+#include "../ParameterStorage.h"
+
+NoisePopulationAgent::NoisePopulationAgent(const Simulation* simulation)
+    : NoisePopulationAgent(simulation, "") {}
+
+NoisePopulationAgent::NoisePopulationAgent(const Simulation* simulation, const std::string& name)
+    : PopulationAgent(simulation, name), cancel_sampler(0.0), market_to_limit_ratio(0.0), num_noise_traders(1), sigma(0.0) {}
+
+void NoisePopulationAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+    PopulationAgent::configure(node, configurationPath);
+
+    pugi::xml_attribute att;
+    if (!(att = node.attribute("cancel_probability")).empty()) {
+        cancel_sampler.setProbability(std::stod(simulation()->parameters().processString(att.as_string())));
+    }
+
+    if (!(att = node.attribute("market_to_limit_ratio")).empty()) {
+        market_to_limit_ratio = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("num_noise_traders")).empty()) {
+        num_noise_traders = std::stoull(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (!(att = node.attribute("sigma")).empty()) {
+        sigma = std::stod(simulation()->parameters().processString(att.as_string()));
+    }
+}
+
+void NoisePopulationAgent::beginBranch() {
+    // none of the branches reuses the uniforms the samplers drew ahead before the fork
+    cancel_sampler.discardBatch();
+    market_sampler.discardBatch();
+    limit_sampler.discardBatch();
+}
+
+Timestamp NoisePopulationAgent::decide(const RetrieveL1ResponsePayload& l1) {
+    // Cancel outstanding limit orders with probability cancel_probability
+    orders.sample(cancel_sampler, simulation()->randomGenerator(), [this](size_t index) {
+        cancelOrder(index);
+    });
+
+    auto price_per_unit = (l1.bestAskPrice + l1.bestBidPrice) / 2.0;
+    if (price_per_unit == (Decimal) 0) {
+        // Keep polling until theres a price
+        return 1;
+    }
+
+    const double probability_of_market_order = sigma / num_noise_traders;
+    const double probability_of_limit_order = probability_of_market_order * market_to_limit_ratio;
+
+    // Only the traders that act are visited, one side draw each
+    auto& randomGenerator = simulation()->randomGenerator();
+    market_sampler.setProbability(probability_of_market_order);
+    market_sampler.sample(population_size, randomGenerator, [&](size_t trader) {
+        placeMarketOrder((TraderIndex)trader, uniform_dist(randomGenerator) < 0.5 ? OrderDirection::Buy : OrderDirection::Sell, DEFAULT_ORDER_VOLUME);
+    });
+
+    limit_sampler.setProbability(probability_of_limit_order);
+    limit_sampler.sample(population_size, randomGenerator, [&](size_t trader) {
+        if (uniform_dist(randomGenerator) < 0.5) {
+            placeLimitOrder((TraderIndex)trader, OrderDirection::Buy, DEFAULT_ORDER_VOLUME, price_per_unit - DEFAULT_OFFSET_FOR_LIMIT);
+        } else {
+            placeLimitOrder((TraderIndex)trader, OrderDirection::Sell, DEFAULT_ORDER_VOLUME, price_per_unit + DEFAULT_OFFSET_FOR_LIMIT);
+        }
+    });
+
+    return 1;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "PopulationAgent.h"
+
+// Struct-of-arrays counterpart of NoiseAgent, one instance trades for population_size noise traders
+class NoisePopulationAgent : public PopulationAgent {
+public:
+    NoisePopulationAgent(const Simulation* simulation);
+    NoisePopulationAgent(const Simulation* simulation, const std::string& name);
+
+    void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+    void beginBranch() override;
+
+protected:
+    void resizePopulation(size_t /*size*/) override { }
+    Timestamp decide(const RetrieveL1ResponsePayload& l1) override;
+
+private:
+    BernoulliSampler cancel_sampler;
+    BernoulliSampler market_sampler;
+    BernoulliSampler limit_sampler;
+    double market_to_limit_ratio;
+
+    uint64_t num_noise_traders;
+
+    double sigma;
+
+    const uint64_t DEFAULT_ORDER_VOLUME = 25;
+    const double DEFAULT_OFFSET_FOR_LIMIT = 0.5;
+};
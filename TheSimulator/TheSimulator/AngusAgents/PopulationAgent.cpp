@@ -0,0 +1,130 @@
+#include "PopulationAgent.h"
+#include "../Simulation.h"
+#include "../SimulationException.h"
+#include "../ParameterStorage.h"
+
+#include <limits>
+
+PopulationAgent::PopulationAgent(const Simulation* simulation, const std::string& name)
+    : Agent(simulation, name), population_size(0), pending_cancellations(nullptr) {}
+
+void PopulationAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+    Agent::configure(node, configurationPath);
+
+    pugi::xml_attribute att;
+    if (!(att = node.attribute("exchange_1")).empty()) {
+        exchange_1 = simulation()->parameters().processString(att.as_string());
+    }
+
+    if (!(att = node.attribute("population_size")).empty()) {
+        population_size = std::stoull(simulation()->parameters().processString(att.as_string()));
+    }
+
+    if (population_size > std::numeric_limits<TraderIndex>::max()) {
+        throw SimulationException("PopulationAgent::configure(): population_size of '" + name() + "' exceeds the maximum number of traders");
+    }
+
+    resizePopulation(population_size);
+}
+
+void PopulationAgent::receiveWakeup(WakeupTag /*tag*/) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    simulation()->dispatchMessage(currentTimestamp, 1, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+}
+
+void PopulationAgent::receiveMessage(const MessagePtr& msg) {
+    const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+    if (msg->type == "EVENT_SIMULATION_START") {
+        simulation()->scheduleWakeup(this, currentTimestamp);
+    } else if (msg->type == "RESPONSE_RETRIEVE_L1") {
+        auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
+
+        const Timestamp pollingDelay = decide(*pptr);
+        flushOrders();
+        flushCancellations();
+
+        simulation()->dispatchMessage(currentTimestamp, pollingDelay, name(), exchange_1, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+    } else if (msg->type == "RESPONSE_PLACE_ORDERS") {
+        auto pptr = std::dynamic_pointer_cast<PlaceOrdersResponsePayload>(msg->payload);
+        auto requestptr = std::static_pointer_cast<PopulationPlaceOrdersPayload>(pptr->requestPayload);
+        // market orders are never tracked, they are done with on arrival; the fills of a limit order come as its trade
+        // events, the order is tracked from the response to the subscription on
+        for (size_t i = 0; i < pptr->ids.size(); ++i) {
+            const PlaceOrdersOrder& order = requestptr->orders[i];
+            if (order.isMarket) {
+                if (pptr->filledVolumes[i] > 0) {
+                    onFill(requestptr->traders[i], order.direction, pptr->filledVolumes[i]);
+                }
+                onMarketOrderDone(requestptr->traders[i]);
+            } else {
+                auto subscription = std::make_shared<OrderTrackingPayload>(pptr->ids[i], order.direction, order.volume, requestptr->traders[i]);
+                simulation()->dispatchMessage(currentTimestamp, 0, name(), exchange_1, "SUBSCRIBE_EVENT_ORDER_TRADE", subscription);
+            }
+        }
+    } else if (msg->type == "RESPONSE_SUBSCRIBE_EVENT_ORDER_TRADE") {
+        orders.insertSubscribed(*msg, [this](TraderIndex trader, OrderDirection direction, Volume volume) {
+            onFill(trader, direction, volume);
+        });
+    } else if (msg->type == "RESPONSE_CANCEL_ORDERS") {
+        auto pptr = std::dynamic_pointer_cast<CancelOrdersPayload>(msg->payload);
+        for (auto& cancellation : pptr->cancellations) {
+            orders.remove(cancellation.id);
+        }
+    } else if (msg->type == "EVENT_TRADE") {
+        auto pptr = std::dynamic_pointer_cast<EventTradePayload>(msg->payload);
+        orders.fillTrade(pptr->trade, currentTimestamp, [this](TraderIndex trader, OrderDirection direction, Volume volume) {
+            onFill(trader, direction, volume);
+        });
+    }
+}
+
+void PopulationAgent::placeMarketOrder(TraderIndex trader, OrderDirection direction, Volume volume) {
+    if (pending_orders == nullptr) {
+        pending_orders = std::make_shared<PopulationPlaceOrdersPayload>();
+    }
+
+    pending_orders->orders.push_back(PlaceOrdersOrder(direction, volume));
+    pending_orders->traders.push_back(trader);
+}
+
+void PopulationAgent::placeLimitOrder(TraderIndex trader, OrderDirection direction, Volume volume, Money price) {
+    if (pending_orders == nullptr) {
+        pending_orders = std::make_shared<PopulationPlaceOrdersPayload>();
+    }
+
+    pending_orders->orders.push_back(PlaceOrdersOrder(direction, volume, price));
+    pending_orders->traders.push_back(trader);
+}
+
+void PopulationAgent::cancelOrder(size_t orderIndex) {
+    if (pending_cancellations == nullptr) {
+        pending_cancellations = std::make_shared<CancelOrdersPayload>();
+    }
+
+    // Max unsigned int so we don't need to specify a volume
+    pending_cancellations->cancellations.push_back(CancelOrdersCancellation(orders.id(orderIndex), std::numeric_limits<unsigned int>::max()));
+}
+
+void PopulationAgent::drawUniforms(size_t count) {
+    uniforms.resize(count);
+    auto& randomGenerator = simulation()->randomGenerator();
+    for (size_t i = 0; i < count; ++i) {
+        uniforms[i] = uniform_dist(randomGenerator);
+    }
+}
+
+void PopulationAgent::flushOrders() {
+    if (pending_orders != nullptr && !pending_orders->orders.empty()) {
+        simulation()->dispatchMessage(simulation()->currentTimestamp(), 1, name(), exchange_1, "PLACE_ORDERS", pending_orders);
+    }
+    pending_orders = nullptr;
+}
+
+void PopulationAgent::flushCancellations() {
+    if (pending_cancellations != nullptr && !pending_cancellations->cancellations.empty()) {
+        simulation()->dispatchMessage(simulation()->currentTimestamp(), 1, name(), exchange_1, "CANCEL_ORDERS", pending_cancellations);
+    }
+    pending_cancellations = nullptr;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "../Agent.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+#include "../ExchangeAgentMessagePayloads.h"
+#include "../OrderTracker.h"
+
+using TraderIndex = OrderOwner;
+
+// The orders of a pass carry the index of the trader that placed them, so the response can be attributed without a lookup
+struct PopulationPlaceOrdersPayload : public PlaceOrdersPayload {
+    // one per order
+    std::vector<TraderIndex> traders;
+};
+
+// One agent holding the state of a whole population of homogeneous traders in struct-of-arrays form. The population shares
+// a single wake-up and RETRIEVE_L1 loop, the decisions of all traders are computed in one pass per market data update and
+// only the resulting orders are sent out as messages.
+class PopulationAgent : public Agent {
+public:
+    virtual ~PopulationAgent() = default;
+
+    void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+    // Inherited via Agent
+    void receiveMessage(const MessagePtr& msg) override;
+    void receiveWakeup(WakeupTag tag) override;
+
+    size_t populationSize() const { return population_size; }
+protected:
+    PopulationAgent(const Simulation* simulation, const std::string& name);
+
+    // allocates the per-trader arrays, called once the population size is known
+    virtual void resizePopulation(size_t size) = 0;
+    // one pass over the whole population, returns the delay until the next market data poll
+    virtual Timestamp decide(const RetrieveL1ResponsePayload& l1) = 0;
+    // a fill of one of the trader's orders
+    virtual void onFill(TraderIndex /*trader*/, OrderDirection /*direction*/, Volume /*volume*/) { }
+    // the response to a market order of the trader has come, after the onFill() of what of it traded
+    virtual void onMarketOrderDone(TraderIndex /*trader*/) { }
+
+    // orders are gathered over the pass and sent as one PLACE_ORDERS message
+    void placeMarketOrder(TraderIndex trader, OrderDirection direction, Volume volume);
+    void placeLimitOrder(TraderIndex trader, OrderDirection direction, Volume volume, Money price);
+    // cancellations are gathered over the pass and sent as one CANCEL_ORDERS message
+    void cancelOrder(size_t orderIndex);
+
+    // the live limit orders of the whole population, owned by the index of the trader that placed them
+    OrderTracker orders;
+
+    std::string exchange_1;
+    size_t population_size;
+
+    std::uniform_real_distribution<double> uniform_dist{0.0, 1.0};
+    // scratch array for drawing the random numbers of a pass in one go
+    std::vector<double> uniforms;
+    void drawUniforms(size_t count);
+private:
+    std::shared_ptr<PopulationPlaceOrdersPayload> pending_orders;
+    std::shared_ptr<CancelOrdersPayload> pending_cancellations;
+
+    void flushOrders();
+    void flushCancellations();
+};
@@ -0,0 +1,178 @@
+#include "AsyncLogWriter.h"
+
+#include "SimulationException.h"
+
+#include <cstring>
+#include <filesystem>
+
+LogRing::LogRing(size_t capacity)
+	: m_head(0), m_tail(0) {
+	size_t roundedCapacity = 1;
+	while (roundedCapacity < capacity) {
+		roundedCapacity <<= 1;
+	}
+	m_buffer.resize(roundedCapacity);
+	m_mask = roundedCapacity - 1;
+}
+
+size_t LogRing::write(const char* data, size_t size) {
+	const size_t head = m_head.load(std::memory_order_relaxed);
+	const size_t freeSpace = m_buffer.size() - (head - m_tail.load(std::memory_order_acquire));
+	size = std::min(size, freeSpace);
+	if (size == 0) {
+		return 0;
+	}
+
+	const size_t offset = head & m_mask;
+	const size_t firstPiece = std::min(size, m_buffer.size() - offset);
+	std::memcpy(m_buffer.data() + offset, data, firstPiece);
+	std::memcpy(m_buffer.data(), data + firstPiece, size - firstPiece);
+	m_head.store(head + size, std::memory_order_release);
+	return size;
+}
+
+LogStream::LogStream(AsyncLogWriter* writer, const std::string& path, std::FILE* file, size_t capacity)
+	: m_writer(writer), m_path(path), m_file(file), m_ring(capacity) { }
+
+LogStream::~LogStream() {
+	if (m_file != nullptr) {
+		std::fclose(m_file);
+	}
+}
+
+void LogStream::write(const char* data, size_t size) {
+	const size_t halfCapacity = m_ring.capacity() / 2;
+	while (size > 0) {
+		const size_t sizeBefore = m_ring.size();
+		const size_t written = m_ring.write(data, size);
+		data += written;
+		size -= written;
+
+		if (sizeBefore < halfCapacity && sizeBefore + written >= halfCapacity) {
+			m_writer->notify();
+		}
+
+		if (size > 0) {
+			// the ring is full, the writer thread is behind
+			m_writer->notify();
+			std::this_thread::yield();
+		}
+	}
+}
+
+AsyncLogWriter& AsyncLogWriter::instance() {
+	static AsyncLogWriter writer;
+	return writer;
+}
+
+AsyncLogWriter::AsyncLogWriter()
+	: m_wakeup(std::make_unique<std::condition_variable>()), m_thread(nullptr), m_stopping(false) { }
+
+AsyncLogWriter::~AsyncLogWriter() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	notify();
+	if (m_thread != nullptr && m_thread->joinable()) {
+		m_thread->join();
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	drainAll(true);
+	m_streams.clear();
+}
+
+LogStreamPtr AsyncLogWriter::open(const std::string& path, size_t capacity) {
+	return openFile(path, "wb", capacity);
+}
+
+LogStreamPtr AsyncLogWriter::branch(const LogStreamPtr& streamPtr, const std::string& path) {
+	if (path == streamPtr->path()) {
+		return streamPtr;
+	}
+
+	// the prefix is on the disk already, prepareFork() wrote out every ring
+	std::error_code error;
+	std::filesystem::copy_file(streamPtr->path(), path, std::filesystem::copy_options::overwrite_existing, error);
+	if (error) {
+		throw SimulationException("AsyncLogWriter::branch(): could not copy '" + streamPtr->path() + "' to '" + path + "': " + error.message());
+	}
+	return openFile(path, "ab", streamPtr->m_ring.capacity());
+}
+
+LogStreamPtr AsyncLogWriter::openFile(const std::string& path, const char* mode, size_t capacity) {
+	std::FILE* file = std::fopen(path.c_str(), mode);
+	if (file == nullptr) {
+		throw SimulationException("AsyncLogWriter::open(): could not open the file '" + path + "' for writing");
+	}
+	// the rings are drained in large pieces already
+	std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+
+	LogStreamPtr streamPtr(new LogStream(this, path, file, capacity));
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_streams.push_back(streamPtr);
+	ensureThread();
+	return streamPtr;
+}
+
+void AsyncLogWriter::flush() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	drainAll(true);
+}
+
+void AsyncLogWriter::prepareFork() {
+	m_mutex.lock();
+	drainAll(true);
+}
+
+void AsyncLogWriter::parentAfterFork() {
+	m_mutex.unlock();
+}
+
+void AsyncLogWriter::childAfterFork() {
+	// the handles of the parent's thread and of what it waited on are meaningless here
+	m_thread.release();
+	m_wakeup.release();
+	m_wakeup = std::make_unique<std::condition_variable>();
+	if (!m_streams.empty()) {
+		ensureThread();
+	}
+	m_mutex.unlock();
+}
+
+void AsyncLogWriter::ensureThread() {
+	if (m_thread == nullptr) {
+		m_thread = std::make_unique<std::thread>(&AsyncLogWriter::run, this);
+	}
+}
+
+void AsyncLogWriter::run() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stopping) {
+		m_wakeup->wait_for(lock, WAKEUP_INTERVAL);
+		drainAll(false);
+	}
+}
+
+void AsyncLogWriter::drainAll(bool flushFiles) {
+	for (auto it = m_streams.begin(); it != m_streams.end();) {
+		LogStream& stream = **it;
+		// no other owner left means that nothing can be written to the ring anymore
+		const bool isClosed = it->use_count() == 1;
+
+		stream.m_ring.drain([&stream](const char* data, size_t size) {
+			std::fwrite(data, 1, size, stream.m_file);
+		});
+
+		if (isClosed) {
+			it = m_streams.erase(it);
+			continue;
+		}
+
+		if (flushFiles) {
+			std::fflush(stream.m_file);
+		}
+		++it;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Single producer, single consumer byte ring. The producer is the simulation thread writing a log, the consumer is the
+// writer thread of AsyncLogWriter, neither takes a lock.
+class LogRing {
+public:
+	// the capacity is rounded up to a power of two
+	explicit LogRing(size_t capacity);
+
+	// copies as much of the data as fits, returns the number of bytes copied
+	size_t write(const char* data, size_t size);
+	// hands the buffered bytes to sink(const char*, size_t) in at most two contiguous pieces, returns the number of bytes
+	template<class Sink>
+	size_t drain(Sink sink);
+
+	size_t capacity() const { return m_buffer.size(); }
+	size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+private:
+	std::vector<char> m_buffer;
+	size_t m_mask;
+
+	// monotonic positions, the producer only moves the head and the consumer only moves the tail
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+};
+
+template<class Sink>
+inline size_t LogRing::drain(Sink sink) {
+	const size_t tail = m_tail.load(std::memory_order_relaxed);
+	const size_t size = m_head.load(std::memory_order_acquire) - tail;
+	if (size == 0) {
+		return 0;
+	}
+
+	const size_t offset = tail & m_mask;
+	const size_t firstPiece = std::min(size, m_buffer.size() - offset);
+	sink(m_buffer.data() + offset, firstPiece);
+	if (firstPiece < size) {
+		sink(m_buffer.data(), size - firstPiece);
+	}
+	m_tail.store(tail + size, std::memory_order_release);
+	return size;
+}
+
+class AsyncLogWriter;
+
+// A log file written by the background thread of AsyncLogWriter. Writing only copies into the stream's ring, the thread
+// appends the ring's contents to the file in large sequential writes. All writes have to come from one thread at a time,
+// which holds for any number of agents of one simulation sharing the stream.
+class LogStream {
+public:
+	~LogStream();
+
+	void write(const char* data, size_t size);
+	void write(const std::string& text) { write(text.data(), text.size()); }
+
+	const std::string& path() const { return m_path; }
+private:
+	LogStream(AsyncLogWriter* writer, const std::string& path, std::FILE* file, size_t capacity);
+
+	AsyncLogWriter* m_writer;
+	std::string m_path;
+	std::FILE* m_file;
+	LogRing m_ring;
+
+	friend class AsyncLogWriter;
+};
+
+using LogStreamPtr = std::shared_ptr<LogStream>;
+
+// The process wide writer thread of all LogStreams. It sleeps until a ring fills past half of its capacity or for at most
+// WAKEUP_INTERVAL, so the simulation threads only ever copy into memory. A producer only waits if its ring is full, i.e.
+// if the disk can not keep up at all. The thread is started with the first stream and stopped at exit.
+class AsyncLogWriter {
+public:
+	static AsyncLogWriter& instance();
+	~AsyncLogWriter();
+
+	// opens (truncates) the file, throws SimulationException if it can not be opened
+	LogStreamPtr open(const std::string& path, size_t capacity = DEFAULT_CAPACITY);
+	// the stream a branch of a forked run goes on writing to: the given one if the path is its own, otherwise a new one
+	// appending to a copy of its file at the path
+	LogStreamPtr branch(const LogStreamPtr& streamPtr, const std::string& path);
+
+	// writes out everything buffered so far, blocking until it is on its way to the disk
+	void flush();
+
+	// fork() only copies the calling thread: the writer thread is parked and all buffers are written out before forking, so
+	// that nothing is written twice, and the child starts a writer thread of its own
+	void prepareFork();
+	void parentAfterFork();
+	void childAfterFork();
+
+	static const size_t DEFAULT_CAPACITY = 1 << 18;
+private:
+	AsyncLogWriter();
+
+	LogStreamPtr openFile(const std::string& path, const char* mode, size_t capacity);
+
+	static constexpr std::chrono::milliseconds WAKEUP_INTERVAL{ 5 };
+
+	std::mutex m_mutex;
+	// both are left behind (not destroyed) in a forked child, where their thread does not exist
+	std::unique_ptr<std::condition_variable> m_wakeup;
+	std::unique_ptr<std::thread> m_thread;
+	bool m_stopping;
+
+	// the streams still referenced by their agents, the writer thread keeps them alive until they are drained
+	std::vector<LogStreamPtr> m_streams;
+
+	void run();
+	// drains every ring into its file and closes the files of the streams no agent refers to anymore, m_mutex held
+	void drainAll(bool flushFiles);
+	void ensureThread();
+
+	void notify() { m_wakeup->notify_one(); }
+
+	friend class LogStream;
+};
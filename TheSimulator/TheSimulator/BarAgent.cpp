@@ -0,0 +1,177 @@
+#include "BarAgent.h"
+
+#include "Simulation.h"
+#include "SimulationException.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "split.h"
+
+#include <algorithm>
+#include <filesystem>
+
+BarAgent::BarAgent(const Simulation* simulation)
+	: BarAgent(simulation, "") { }
+
+BarAgent::BarAgent(const Simulation* simulation, const std::string& name)
+	: Agent(simulation, name), m_format(BarOutputFormat::CSV), m_fillEmpty(false), m_outputFile(), m_bufferSize(4096) { }
+
+void BarAgent::receiveMessage(const MessagePtr& messagePtr) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	if (messagePtr->type == "EVENT_SIMULATION_START") {
+		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_TRADE", std::make_shared<EmptyPayload>());
+	} else if (messagePtr->type == "EVENT_TRADE") {
+		const Trade& trade = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload)->trade;
+		const double price = (double)trade.price();
+		for (Resolution& resolution : m_resolutions) {
+			addTrade(resolution, trade.timestamp(), price, trade.volume(), trade.direction() == OrderDirection::Buy);
+		}
+	} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+		// the last bars end with the simulation
+		for (Resolution& resolution : m_resolutions) {
+			if (resolution.isOpen) {
+				closeBar(resolution);
+			}
+		}
+		flush();
+		m_outputFile.flush();
+	}
+}
+
+void BarAgent::prepareBranching() {
+	// the completed bars of the common prefix go out once, not once per branch
+	flush();
+	m_outputFile.flush();
+}
+
+void BarAgent::beginBranch() {
+	const std::string path = branchOutputPath(m_outputPathTemplate, m_outputPath);
+	if (path == m_outputPath) {
+		return;
+	}
+
+	m_outputFile.close();
+	std::filesystem::copy_file(m_outputPath, path, std::filesystem::copy_options::overwrite_existing);
+	m_outputFile.open(path, m_format == BarOutputFormat::Binary ? std::ios::app | std::ios::binary : std::ios::app);
+	if (!m_outputFile) {
+		throw SimulationException("BarAgent::beginBranch(): could not open the file '" + path + "'");
+	}
+	m_outputPath = path;
+}
+
+void BarAgent::addTrade(Resolution& resolution, Timestamp timestamp, double price, Volume volume, bool isBuy) {
+	const Timestamp start = timestamp - timestamp % resolution.interval;
+	if (resolution.isOpen && start != resolution.bar.start) {
+		closeBar(resolution);
+
+		if (m_fillEmpty) {
+			const double close = resolution.bar.close;
+			for (Timestamp emptyStart = resolution.bar.start + resolution.interval; emptyStart < start; emptyStart += resolution.interval) {
+				pushBar(Bar{ emptyStart, resolution.interval, close, close, close, close, close, 0, 0, 0 });
+			}
+		}
+	}
+
+	Bar& bar = resolution.bar;
+	if (!resolution.isOpen) {
+		bar = Bar{ start, resolution.interval, price, price, price, price, price, 0, 0, 0 };
+		resolution.notional = 0.0;
+		resolution.isOpen = true;
+	}
+
+	bar.high = std::max(bar.high, price);
+	bar.low = std::min(bar.low, price);
+	bar.close = price;
+	bar.volume += volume;
+	bar.signedVolume += isBuy ? (int64_t)volume : -(int64_t)volume;
+	++bar.tradeCount;
+	resolution.notional += price * volume;
+}
+
+void BarAgent::closeBar(Resolution& resolution) {
+	resolution.bar.vwap = resolution.bar.volume > 0 ? resolution.notional / resolution.bar.volume : resolution.bar.close;
+	resolution.isOpen = false;
+	pushBar(resolution.bar);
+}
+
+void BarAgent::pushBar(const Bar& bar) {
+	m_buffer.push_back(bar);
+	if (m_buffer.size() == m_bufferSize) {
+		flush();
+	}
+}
+
+void BarAgent::flush() {
+	if (m_format == BarOutputFormat::Binary) {
+		m_outputFile.write(reinterpret_cast<const char*>(m_buffer.data()), (std::streamsize)(m_buffer.size() * sizeof(Bar)));
+	} else {
+		for (const Bar& bar : m_buffer) {
+			m_outputFile << bar.start << ',' << bar.interval << ','
+				<< bar.open << ',' << bar.high << ',' << bar.low << ',' << bar.close << ',' << bar.vwap << ','
+				<< bar.volume << ',' << bar.signedVolume << ',' << bar.tradeCount << '\n';
+		}
+	}
+
+	// the capacity stays, the buffer is refilled without allocating
+	m_buffer.clear();
+}
+
+#include "ParameterStorage.h"
+
+void BarAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	Agent::configure(node, configurationPath);
+
+	pugi::xml_attribute att;
+	if (!(att = node.attribute("exchange")).empty()) {
+		m_exchange = simulation()->parameters().processString(att.as_string());
+	}
+
+	if (!(att = node.attribute("intervals")).empty()) {
+		for (const std::string& interval : split(simulation()->parameters().processString(att.as_string()), ',')) {
+			const Timestamp intervalTimestamp = std::stoull(interval);
+			if (intervalTimestamp == 0) {
+				throw SimulationException("BarAgent::configure(): '" + name() + "' has a zero bar interval");
+			}
+			m_resolutions.push_back(Resolution{ intervalTimestamp, Bar(), false, 0.0 });
+		}
+	}
+
+	if (m_resolutions.empty()) {
+		throw SimulationException("BarAgent::configure(): '" + name() + "' needs at least one bar interval in 'intervals'");
+	}
+
+	if (!(att = node.attribute("format")).empty()) {
+		const std::string format = simulation()->parameters().processString(att.as_string());
+		if (format == "csv") {
+			m_format = BarOutputFormat::CSV;
+		} else if (format == "binary") {
+			m_format = BarOutputFormat::Binary;
+		} else {
+			throw SimulationException("BarAgent::configure(): unknown format '" + format + "', expected 'csv' or 'binary'");
+		}
+	}
+
+	if (!(att = node.attribute("fillEmpty")).empty()) {
+		m_fillEmpty = att.as_bool();
+	}
+
+	if (!(att = node.attribute("bufferSize")).empty()) {
+		m_bufferSize = std::max((size_t)1, (size_t)std::stoull(simulation()->parameters().processString(att.as_string())));
+	}
+	m_buffer.reserve(m_bufferSize);
+
+	if (!(att = node.attribute("outputFile")).empty()) {
+		m_outputPathTemplate = att.as_string();
+		m_outputPath = simulation()->parameters().processString(m_outputPathTemplate);
+		m_outputFile.open(m_outputPath, m_format == BarOutputFormat::Binary ? std::ios::out | std::ios::binary : std::ios::out);
+		if (!m_outputFile) {
+			throw SimulationException("BarAgent::configure(): could not open the file '" + m_outputPath + "'");
+		}
+	} else {
+		throw SimulationException("BarAgent::configure(): '" + name() + "' needs an 'outputFile' to write the bars to");
+	}
+
+	if (m_format == BarOutputFormat::CSV) {
+		m_outputFile.precision(10);
+		m_outputFile << "start,interval,open,high,low,close,vwap,volume,signedVolume,tradeCount" << std::endl;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Agent.h"
+#include "Volume.h"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// one bar of one resolution, laid out without padding so that the binary output is a plain array of these
+struct Bar {
+	uint64_t start;        // the first timestamp covered by the bar
+	uint64_t interval;
+	double open;
+	double high;
+	double low;
+	double close;
+	double vwap;
+	uint64_t volume;
+	int64_t signedVolume;  // buyer initiated minus seller initiated volume
+	uint64_t tradeCount;
+};
+
+enum class BarOutputFormat {
+	CSV,
+	Binary
+};
+
+// Builds OHLCV bars of an exchange's trades straight from EVENT_TRADE, for every interval in 'intervals' (a comma
+// separated list, e.g. "10,100,1000") at once. A bar covers [k * interval, (k + 1) * interval) and is completed by the
+// first trade past it, or by the end of the simulation. Completed bars of all resolutions go to a buffer of 'bufferSize'
+// preallocated bars, which is written to 'outputFile' in 'format' ("csv" or "binary", an array of Bar) in one chunk
+// whenever it fills up and at EVENT_SIMULATION_STOP, so no allocation happens per trade. With 'fillEmpty', intervals
+// without trades produce bars at the previous close with zero volume.
+class BarAgent : public Agent {
+public:
+	BarAgent(const Simulation* simulation);
+	BarAgent(const Simulation* simulation, const std::string& name);
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	// Inherited via Agent
+	void receiveMessage(const MessagePtr& msg) override;
+	void prepareBranching() override;
+	void beginBranch() override;
+private:
+	struct Resolution {
+		Timestamp interval;
+		Bar bar;         // the bar being built
+		bool isOpen;     // whether 'bar' has any trade yet
+		double notional; // price * volume of 'bar', for its VWAP
+	};
+
+	std::string m_exchange;
+	BarOutputFormat m_format;
+	bool m_fillEmpty;
+	std::ofstream m_outputFile;
+	std::string m_outputPath;
+	std::string m_outputPathTemplate;
+
+	std::vector<Resolution> m_resolutions;
+
+	size_t m_bufferSize;
+	std::vector<Bar> m_buffer;
+
+	void addTrade(Resolution& resolution, Timestamp timestamp, double price, Volume volume, bool isBuy);
+	void closeBar(Resolution& resolution);
+	void pushBar(const Bar& bar);
+	void flush();
+};
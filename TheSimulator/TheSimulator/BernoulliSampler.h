@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Selects each of the indices 0..count-1 independently with a fixed probability. Instead of drawing one random number per
+// index, the gaps between the selected indices are drawn from Geometric(p) = floor(log(U) / log(1 - p)), which costs
+// O(expected selections) draws per call. Uniforms are generated in batches, leftovers carry over to the next call.
+class BernoulliSampler {
+public:
+	BernoulliSampler()
+		: BernoulliSampler(0.0) { }
+	explicit BernoulliSampler(double probability)
+		: m_uniformBatch(BATCH_SIZE), m_batchPosition(BATCH_SIZE) { setProbability(probability); }
+
+	double probability() const { return m_probability; }
+	void setProbability(double probability);
+
+	// calls callback(index) for every selected index in increasing order
+	template<class Callback>
+	void sample(size_t count, std::mt19937& randomGenerator, Callback callback);
+	// number of selected indices, without visiting them
+	size_t count(size_t count, std::mt19937& randomGenerator);
+	// drops the uniforms left over, the next call draws a batch from the generator as it then is
+	void discardBatch() { m_batchPosition = BATCH_SIZE; }
+private:
+	static const size_t BATCH_SIZE = 64;
+
+	double m_probability;
+	double m_logComplement;
+
+	std::vector<double> m_uniformBatch;
+	size_t m_batchPosition;
+
+	double nextUniform(std::mt19937& randomGenerator);
+	double nextGap(std::mt19937& randomGenerator) { return std::floor(std::log(nextUniform(randomGenerator)) / m_logComplement); }
+};
+
+inline void BernoulliSampler::setProbability(double probability) {
+	m_probability = probability;
+	m_logComplement = (probability > 0.0 && probability < 1.0) ? std::log1p(-probability) : 0.0;
+}
+
+template<class Callback>
+inline void BernoulliSampler::sample(size_t count, std::mt19937& randomGenerator, Callback callback) {
+	if (count == 0 || !(m_probability > 0.0)) {
+		return;
+	}
+
+	if (m_probability >= 1.0) {
+		for (size_t index = 0; index < count; ++index) {
+			callback(index);
+		}
+		return;
+	}
+
+	size_t index = 0;
+	while (true) {
+		const double gap = nextGap(randomGenerator);
+		if (gap >= (double)(count - index)) {
+			break;
+		}
+
+		index += (size_t)gap;
+		callback(index);
+		if (++index == count) {
+			break;
+		}
+	}
+}
+
+inline size_t BernoulliSampler::count(size_t count, std::mt19937& randomGenerator) {
+	size_t selected = 0;
+	sample(count, randomGenerator, [&selected](size_t) { ++selected; });
+	return selected;
+}
+
+inline double BernoulliSampler::nextUniform(std::mt19937& randomGenerator) {
+	if (m_batchPosition == BATCH_SIZE) {
+		// (0, 1], log(0) would be an infinite gap
+		std::uniform_real_distribution<double> uniformDistribution(std::numeric_limits<double>::min(), 1.0);
+		for (double& uniform : m_uniformBatch) {
+			uniform = uniformDistribution(randomGenerator);
+		}
+		m_batchPosition = 0;
+	}
+
+	return m_uniformBatch[m_batchPosition++];
+}
@@ -3,8 +3,30 @@
 TickContainer::TickContainer(Money price)
 	: m_price(price), list() { }
 
+void BookChangeJournal::clear() {
+	m_orders.clear();
+	m_orderIds.clear();
+	m_levels.clear();
+	m_levelSet.clear();
+}
+
+void BookChangeJournal::recordOrder(const LimitOrderPtr& order) {
+	const bool wasEmpty = m_orders.empty();
+	if (m_orderIds.insert(order->id()).second) {
+		m_orders.push_back(order);
+	}
+	// a replaced order touches the level it left and the one it went to
+	if (m_levelSet.emplace(order->direction(), order->price()).second) {
+		m_levels.emplace_back(order->direction(), order->price());
+	}
+
+	if (wasEmpty && m_changeListener) {
+		m_changeListener();
+	}
+}
+
 Book::Book(OrderFactoryPtr orderRecordPtr, TradeFactoryPtr tradeRecordPtr)
-	: m_orderRecordPtr(orderRecordPtr), m_tradeRecordPtr(tradeRecordPtr), m_tradeLoggingCallback([] (TradePtr) { }), m_buyQueue(), m_sellQueue(), m_orderIdMap(), m_lastBetteringBuyOrder(nullptr), m_lastBetteringSellOrder(nullptr) { }
+	: m_orderRecordPtr(orderRecordPtr), m_tradeRecordPtr(tradeRecordPtr), m_tradeLoggingCallback([] (TradePtr) { }), m_buyQueue(), m_sellQueue(), m_orderIdMap(), m_lastBetteringBuyOrder(nullptr), m_lastBetteringSellOrder(nullptr), m_deltaSequence(0) { }
 
 void Book::placeOrder(const LimitOrderPtr& order) {
 	if (order->direction() == OrderDirection::Sell) {
@@ -28,6 +50,8 @@ void Book::placeOrder(const LimitOrderPtr& order) {
 
 				m_lastBetteringSellOrder = order;
 			}
+			journalOrder(order);
+			publishDelta(BookDeltaType::Add, order->id(), order->direction(), order->price(), order->volume(), order->volume());
 		} else {
 			processAgainstTheBuyQueue(order, order->price());
 
@@ -56,6 +80,8 @@ void Book::placeOrder(const LimitOrderPtr& order) {
 
 				m_lastBetteringBuyOrder = order;
 			}
+			journalOrder(order);
+			publishDelta(BookDeltaType::Add, order->id(), order->direction(), order->price(), order->volume(), order->volume());
 		} else {
 			processAgainstTheSellQueue(order, order->price());
 
@@ -84,6 +110,39 @@ void Book::placeOrder(const MarketOrderPtr& order) {
 	}
 }
 
+void Book::matchOrder(const LimitOrderPtr& order) {
+	if (order->direction() == OrderDirection::Sell) {
+		if (!m_buyQueue.empty() && order->price() <= m_buyQueue.back().price()) {
+			processAgainstTheBuyQueue(order, order->price());
+		}
+	} else {
+		if (!m_sellQueue.empty() && order->price() >= m_sellQueue.front().price()) {
+			processAgainstTheSellQueue(order, order->price());
+		}
+	}
+}
+
+static Volume hiddenVolume(const TickContainer& level) {
+	return std::accumulate(level.cbegin(), level.cend(), (Volume)0, [](Volume soFar, const LimitOrderPtr& order) {
+		return soFar + order->hiddenVolume();
+	});
+}
+
+Volume Book::crossedVolume(const LimitOrderPtr& order) const {
+	Volume volume = 0;
+	if (order->direction() == OrderDirection::Sell) {
+		for (auto it = m_buyQueue.rbegin(); it != m_buyQueue.rend() && it->price() >= order->price() && volume < order->volume(); ++it) {
+			volume += it->volume() + hiddenVolume(*it);
+		}
+	} else {
+		for (auto it = m_sellQueue.begin(); it != m_sellQueue.end() && it->price() <= order->price() && volume < order->volume(); ++it) {
+			volume += it->volume() + hiddenVolume(*it);
+		}
+	}
+
+	return volume;
+}
+
 MarketOrderPtr Book::placeMarketOrder(OrderDirection direction, Timestamp timestamp, Volume volume) {
 	auto ret = m_orderRecordPtr->makeMarketOrder(direction, timestamp, volume);
 	placeOrder(ret);
@@ -91,19 +150,85 @@ MarketOrderPtr Book::placeMarketOrder(OrderDirection direction, Timestamp timest
 	return ret;
 }
 
-LimitOrderPtr Book::placeLimitOrder(OrderDirection direction, Timestamp timestamp, Volume volume, Money price) {
+LimitOrderPtr Book::placeLimitOrder(OrderDirection direction, Timestamp timestamp, Volume volume, Money price, TimeInForce timeInForce, Timestamp expiry, Volume displayVolume) {
 	auto ret = m_orderRecordPtr->makeLimitOrder(direction, timestamp, volume, price);
-	placeOrder(ret);
+
+	if (timeInForce == TimeInForce::GTD && expiry <= timestamp) {
+		timeInForce = TimeInForce::IOC;
+	}
+
+	switch (timeInForce) {
+	case TimeInForce::FOK:
+		if (crossedVolume(ret) >= ret->volume()) {
+			matchOrder(ret);
+		}
+		ret->setVolume(0);
+		break;
+	case TimeInForce::IOC:
+		matchOrder(ret);
+		ret->setVolume(0);
+		break;
+	case TimeInForce::GTD:
+		restOrder(ret, displayVolume);
+		if (ret->volume() > 0) {
+			m_expiryWheel.add(expiry, ret->id());
+		}
+		break;
+	default:
+		restOrder(ret, displayVolume);
+		break;
+	}
 
 	return ret;
 }
 
+void Book::restOrder(const LimitOrderPtr& order, Volume displayVolume) {
+	if (displayVolume == 0) {
+		placeOrder(order);
+		return;
+	}
+
+	// the whole of an iceberg order matches on arrival, only what rests of it is hidden
+	matchOrder(order);
+	order->hideVolume(displayVolume);
+	if (order->volume() > 0) {
+		placeOrder(order);
+	}
+}
+
+bool Book::replenishOrder(TickContainer& level, TickContainer::iterator orderIt) {
+	const LimitOrderPtr order = *orderIt;
+	if (!order->replenish()) {
+		return false;
+	}
+
+	// the new peak queues up behind the level like a new order would, but it keeps the order's id and storage
+	level.splice(level.end(), level, orderIt);
+	journalOrder(order);
+	publishDelta(BookDeltaType::Add, order->id(), order->direction(), level.price(), order->volume(), order->volume());
+	return true;
+}
+
+void Book::expireOrders(Timestamp now) {
+	m_expiryWheel.advance(now, [this](OrderID id) {
+		// a no-op for the orders filled or cancelled in the meantime
+		cancelOrder(id);
+	});
+}
+
 void Book::cancelOrder(const OrderID orderId) {
 	// POLICY: even the filled and cancelled orders still survive in this hashmap, for future analysis
 	// POLICY: action requested on a non-existing orderId is a no-op
 
 	if (m_orderIdMap.count(orderId) > 0) {
-		m_orderIdMap[orderId]->setVolume(0);
+		const LimitOrderPtr& order = m_orderIdMap[orderId];
+		const Volume cancelledVolume = order->volume();
+		order->setVolume(0);
+		order->setHiddenVolume(0);
+		journalOrder(order);
+		if (cancelledVolume > 0) {
+			publishDelta(BookDeltaType::Cancel, orderId, order->direction(), order->price(), cancelledVolume, 0);
+		}
 		m_orderIdMap.erase(orderId);
 	}
 }
@@ -119,6 +244,12 @@ Volume Book::cancelOrder(const OrderID orderId, Volume volumeToCancel) {
 		const Volume originalVolume = m_orderIdMap[orderId]->volume();
 		remainingVolume = std::min((Volume)0, originalVolume - volumeToCancel);
 		m_orderIdMap[orderId]->setVolume(remainingVolume);
+		m_orderIdMap[orderId]->setHiddenVolume(0);
+		journalOrder(m_orderIdMap[orderId]);
+		if (remainingVolume < originalVolume) {
+			const LimitOrderPtr& order = m_orderIdMap[orderId];
+			publishDelta(BookDeltaType::Cancel, orderId, order->direction(), order->price(), originalVolume - remainingVolume, remainingVolume);
+		}
 		if (remainingVolume == 0) {
 			m_orderIdMap.erase(orderId);
 		}
@@ -127,6 +258,108 @@ Volume Book::cancelOrder(const OrderID orderId, Volume volumeToCancel) {
 	return remainingVolume;
 }
 
+// both queues are sorted by ascending price, the best bid is the back and the best ask the front
+template<class Queue>
+static auto lowerBoundLevel(Queue& queue, Money price) {
+	return std::lower_bound(queue.begin(), queue.end(), price, [](const TickContainer& level, const Money& price) {
+		return level.price() < price;
+	});
+}
+
+const TickContainer* Book::findLevel(OrderDirection direction, Money price) const {
+	const auto& queue = direction == OrderDirection::Buy ? m_buyQueue : m_sellQueue;
+	auto it = lowerBoundLevel(queue, price);
+
+	return it != queue.end() && it->price() == price ? &*it : nullptr;
+}
+
+Volume Book::replaceOrder(const OrderID orderId, Timestamp timestamp, Money newPrice, Volume newVolume) {
+	// POLICY: action requested on a non-existing orderId is a no-op
+
+	// the priority pro-rata books leave their filled priority orders registered, with no volume
+	auto mapIt = m_orderIdMap.find(orderId);
+	if (mapIt == m_orderIdMap.end() || mapIt->second->volume() == 0) {
+		return 0;
+	}
+	const LimitOrderPtr order = mapIt->second;
+	const Volume originalVolume = order->volume();
+
+	if (newVolume == 0) {
+		cancelOrder(orderId);
+		return 0;
+	}
+
+	// the volume of an iceberg order is what it shows and what it hides, the hidden volume goes first
+	if (newPrice == order->price() && newVolume <= originalVolume + order->hiddenVolume()) {
+		const Volume shownVolume = std::min(originalVolume, newVolume);
+		order->setHiddenVolume(newVolume - shownVolume);
+		if (shownVolume < originalVolume) {
+			order->setVolume(shownVolume);
+			journalOrder(order);
+			publishDelta(BookDeltaType::Cancel, orderId, order->direction(), order->price(), originalVolume - shownVolume, shownVolume);
+		}
+		return newVolume;
+	}
+
+	auto& queue = order->direction() == OrderDirection::Buy ? m_buyQueue : m_sellQueue;
+	auto levelIt = lowerBoundLevel(queue, order->price());
+	if (levelIt == queue.end() || levelIt->price() != order->price()) {
+		return 0;
+	}
+	auto orderIt = std::find(levelIt->begin(), levelIt->end(), order);
+	if (orderIt == levelIt->end()) {
+		return 0;
+	}
+
+	// the order's list node is carried over to its new level, nothing is allocated for it
+	std::list<LimitOrderPtr> node;
+	node.splice(node.begin(), *levelIt, orderIt);
+	journalOrder(order);
+	publishDelta(BookDeltaType::Cancel, orderId, order->direction(), order->price(), originalVolume, 0);
+	if (levelIt->empty()) {
+		publishDelta(BookDeltaType::LevelDelete, 0, order->direction(), levelIt->price(), 0, 0);
+		queue.erase(levelIt);
+	}
+	if (m_lastBetteringBuyOrder == order) {
+		m_lastBetteringBuyOrder = nullptr;
+	} else if (m_lastBetteringSellOrder == order) {
+		m_lastBetteringSellOrder = nullptr;
+	}
+
+	order->setTimestamp(timestamp);
+	order->setPrice(newPrice);
+	order->setVolume(newVolume);
+	order->setHiddenVolume(0);
+	matchOrder(order);
+	if (order->isIceberg()) {
+		order->hideVolume(order->peakVolume());
+	}
+
+	if (order->volume() == 0) {
+		m_orderIdMap.erase(orderId);
+		return 0;
+	}
+
+	auto newLevelIt = lowerBoundLevel(queue, newPrice);
+	if (newLevelIt == queue.end() || newLevelIt->price() != newPrice) {
+		newLevelIt = queue.emplace(newLevelIt, newPrice);
+		if (order->direction() == OrderDirection::Buy) {
+			m_lastBetteringBuyOrder = order;
+		} else {
+			m_lastBetteringSellOrder = order;
+		}
+	}
+	newLevelIt->splice(newLevelIt->end(), node);
+	journalOrder(order);
+	publishDelta(BookDeltaType::Add, orderId, order->direction(), newPrice, order->volume(), order->volume());
+
+	return order->volume() + order->hiddenVolume();
+}
+
+void Book::detachChangeJournal(BookChangeJournal* journal) {
+	m_changeJournals.erase(std::remove(m_changeJournals.begin(), m_changeJournals.end(), journal), m_changeJournals.end());
+}
+
 bool Book::tryGetOrder(OrderID id, LimitOrderPtr& orderPtr) const {
 	decltype(m_orderIdMap)::const_iterator it;
 	if ((it = m_orderIdMap.find(id)) != m_orderIdMap.end()) {
@@ -177,6 +410,15 @@ void Book::unregisterLimitOrder(const LimitOrderPtr& order) {
 }
 
 void Book::logTrade(OrderDirection direction, OrderID aggressorId, OrderID restingId, Volume volume, Money execPrice) {
+	// every matching algorithm logs a fill before it unregisters the filled resting order
+	if (!m_changeJournals.empty() || m_bookDeltaCallback) {
+		auto it = m_orderIdMap.find(restingId);
+		if (it != m_orderIdMap.end()) {
+			journalOrder(it->second);
+			publishDelta(BookDeltaType::Execute, restingId, it->second->direction(), execPrice, volume, it->second->volume());
+		}
+	}
+
 	TradePtr tradePtr = tradeFactory()->makeRecord(TIMESTAMP_INVALID, direction, aggressorId, restingId, volume, execPrice);
 	m_tradeLoggingCallback(tradePtr);
 }
@@ -184,3 +426,17 @@ void Book::logTrade(OrderDirection direction, OrderID aggressorId, OrderID resti
 void Book::registerTradeLoggingCallback(TradeLoggingCallback tradeLogginCallbackToRegister) {
 	m_tradeLoggingCallback = tradeLogginCallbackToRegister;
 }
+
+void Book::registerBookDeltaCallback(BookDeltaCallback bookDeltaCallbackToRegister) {
+	m_bookDeltaCallback = bookDeltaCallbackToRegister;
+}
+
+void Book::popBestLevel(OrderDirection direction) {
+	if (direction == OrderDirection::Buy) {
+		publishDelta(BookDeltaType::LevelDelete, 0, direction, m_buyQueue.back().price(), 0, 0);
+		m_buyQueue.pop_back();
+	} else {
+		publishDelta(BookDeltaType::LevelDelete, 0, direction, m_sellQueue.front().price(), 0, 0);
+		m_sellQueue.pop_front();
+	}
+}
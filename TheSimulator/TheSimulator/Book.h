@@ -1,14 +1,19 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <queue>
 #include <map>
+#include <set>
+#include <unordered_set>
+#include <vector>
 #include <functional>
 #include <algorithm>
 #include <numeric>
 
 #include "OrderFactory.h"
 #include "TradeFactory.h"
+#include "ExpiryWheel.h"
 
 #include "ICSVPrintable.h"
 #include "IHumanPrintable.h"
@@ -32,20 +37,86 @@ using OrderContainer = std::deque<TickContainer>;
 
 using TradeLoggingCallback = std::function<void(TradePtr)>;
 
+enum class BookDeltaType : uint8_t {
+	Add,        // an order came to rest in the book
+	Execute,    // a resting order was filled, possibly partially
+	Cancel,     // a resting order was cancelled, possibly partially
+	LevelDelete // a price level left the book, orderId and both volumes are 0
+};
+
+// One mutation of the resting orders of a book, in the spirit of an ITCH feed: 'volume' is the volume added, executed or
+// cancelled and 'remainingVolume' what the order has left afterwards. Applying the deltas in sequence order to a mirror of
+// the book reproduces it without any matching logic. Sequence numbers are consecutive per book, starting at 1.
+struct BookDelta {
+	uint64_t sequence;
+	BookDeltaType type;
+	OrderID orderId;
+	OrderDirection direction;
+	Money price;
+	Volume volume;
+	Volume remainingVolume;
+};
+
+using BookDeltaCallback = std::function<void(const BookDelta&)>;
+
+// Collects the resting orders a book touched (placed, filled or cancelled) since its reader last cleared it, and with them
+// the price levels whose volume may have changed, so that observing the changes costs O(changes) instead of O(depth).
+class BookChangeJournal {
+public:
+	bool empty() const { return m_orders.empty(); }
+	const std::vector<LimitOrderPtr>& orders() const { return m_orders; }
+	// (direction, price) of every touched level, each once
+	const std::vector<std::pair<OrderDirection, Money>>& levels() const { return m_levels; }
+	void clear();
+
+	// called on the first change recorded after a clear()
+	void setChangeListener(std::function<void()> listener) { m_changeListener = listener; }
+
+	void recordOrder(const LimitOrderPtr& order);
+private:
+	std::vector<LimitOrderPtr> m_orders;
+	std::unordered_set<OrderID> m_orderIds;
+	std::vector<std::pair<OrderDirection, Money>> m_levels;
+	std::set<std::pair<OrderDirection, Money>> m_levelSet;
+
+	std::function<void()> m_changeListener;
+};
+
 class Book : public IHumanPrintable, public ICSVPrintable {
 public:
 	Book(OrderFactoryPtr orderFactoryPtr, TradeFactoryPtr tradeFactoryPtr);
 	virtual ~Book() = default;
 
 	MarketOrderPtr placeMarketOrder(OrderDirection direction, Timestamp timestamp, Volume volume);
-	LimitOrderPtr placeLimitOrder(OrderDirection direction, Timestamp timestamp, Volume volume, Money price);
+	// IOC and FOK orders never rest in the book, what they do not match is cancelled and the returned order is left with
+	// no volume; a FOK order that cannot be filled in full does not match at all. A GTD order whose expiry is not after the
+	// timestamp is treated as IOC, otherwise it rests until expireOrders() reaches its expiry.
+	// With a display volume, what rests of a GTC or GTD order is an iceberg: it shows at most the display volume, and each
+	// time that has been filled the next part of the hidden volume is shown, at the back of the level.
+	LimitOrderPtr placeLimitOrder(OrderDirection direction, Timestamp timestamp, Volume volume, Money price,
+		TimeInForce timeInForce = TimeInForce::GTC, Timestamp expiry = TIMESTAMP_INVALID, Volume displayVolume = 0);
 	void cancelOrder(const OrderID orderId);
 	Volume cancelOrder(const OrderID orderId, Volume volumeToCancel);
+	// Changes the price and volume of a resting order, returns its resting volume afterwards (0 if it does not rest in the
+	// book anymore). Only decreasing the volume at the same price keeps the priority, otherwise the order goes to the back of
+	// its new level, matching whatever it crosses first, like a new order placed at the timestamp would, and takes the
+	// timestamp as its own. The order keeps its id and its storage.
+	Volume replaceOrder(const OrderID orderId, Timestamp timestamp, Money newPrice, Volume newVolume);
+	// cancels the GTD orders whose expiry is at or before now
+	void expireOrders(Timestamp now);
+	// when expireOrders() next has something to do, TIMESTAMP_INVALID if no GTD order is pending
+	Timestamp nextExpiry() const { return m_expiryWheel.nextExpiry(); }
 
 	bool tryGetOrder(OrderID id, LimitOrderPtr& orderPtr) const;
 
 	const OrderContainer<TickContainer>& buyQueue() const { return m_buyQueue; }
 	const OrderContainer<TickContainer>& sellQueue() const { return m_sellQueue; }
+	// the level at the given price, nullptr if there is none, O(log depth)
+	const TickContainer* findLevel(OrderDirection direction, Money price) const;
+
+	// the journals are not owned, a journal has to be detached before it is destroyed
+	void attachChangeJournal(BookChangeJournal* journal) { m_changeJournals.push_back(journal); }
+	void detachChangeJournal(BookChangeJournal* journal);
 
 	void printHuman() const override;
 	void printCSV() const override;
@@ -58,9 +129,20 @@ public:
 	const TradeFactoryPtr& tradeFactory() const { return m_tradeRecordPtr; }
 
 	void registerTradeLoggingCallback(TradeLoggingCallback tradeLogginCallbackToRegister);
+	void registerBookDeltaCallback(BookDeltaCallback bookDeltaCallbackToRegister);
+	// the sequence number of the last published delta
+	uint64_t deltaSequence() const { return m_deltaSequence; }
 protected:
 	void placeOrder(const MarketOrderPtr& order);
 	void placeOrder(const LimitOrderPtr& order);
+	// matches the order against whatever it crosses, without resting the remainder
+	void matchOrder(const LimitOrderPtr& order);
+	// the volume resting at prices the order crosses, hidden volume included
+	Volume crossedVolume(const LimitOrderPtr& order) const;
+	void restOrder(const LimitOrderPtr& order, Volume displayVolume);
+	// for the matching algorithms, when a resting order's shown volume has been filled: an iceberg order with hidden volume
+	// left shows its next peak and moves to the back of the level, returns false for any other order, which is then done
+	bool replenishOrder(TickContainer& level, TickContainer::iterator orderIt);
 
 	void registerLimitOrder(const LimitOrderPtr& order);
 	void unregisterLimitOrder(const LimitOrderPtr& order);
@@ -75,7 +157,27 @@ protected:
 	virtual void processAgainstTheSellQueue(const OrderPtr& order, Money maxPrice) = 0;
 
 	void logTrade(OrderDirection direction, OrderID aggressorId, OrderID restingId, Volume volume, Money execPrice);
+
+	void journalOrder(const LimitOrderPtr& order) {
+		for (BookChangeJournal* journal : m_changeJournals) {
+			journal->recordOrder(order);
+		}
+	}
+
+	void publishDelta(BookDeltaType type, OrderID orderId, OrderDirection direction, Money price, Volume volume, Volume remainingVolume) {
+		if (m_bookDeltaCallback) {
+			m_bookDeltaCallback(BookDelta{ ++m_deltaSequence, type, orderId, direction, price, volume, remainingVolume });
+		}
+	}
+	// removes the best level of the side, the matching algorithms' only way of deleting a level
+	void popBestLevel(OrderDirection direction);
 private:
+	std::vector<BookChangeJournal*> m_changeJournals;
+	BookDeltaCallback m_bookDeltaCallback;
+	uint64_t m_deltaSequence;
+
+	ExpiryWheel m_expiryWheel;
+
 	OrderFactoryPtr m_orderRecordPtr;
 	TradeFactoryPtr m_tradeRecordPtr;
 	TradeLoggingCallback m_tradeLoggingCallback;
@@ -55,10 +55,6 @@ void BouchaudAgent::receiveMessage(const MessagePtr& msg) {
 
 	if (msg->type == "EVENT_SIMULATION_START") {
 		scheduleNextOrderPlacement();
-		scheduleNextOrderCancellation();
-	} else if (msg->type == "WAKEUP_FOR_PLACEMENT") {
-		// queue an L1 data request
-		simulation()->dispatchMessage(simulation()->currentTimestamp(), 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
 	} else if (msg->type == "RESPONSE_RETRIEVE_L1") {
 		auto l1ptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
 		// place an order based on the current L1 status
@@ -82,50 +78,20 @@ void BouchaudAgent::receiveMessage(const MessagePtr& msg) {
 				price = l1ptr->bestBidPrice + priceDeltaFromBest.floorToCents();
 			}
 
-			auto pptr = std::make_shared<PlaceOrderLimitPayload>(direction, m_volumeUnit, price);
+			// the exchange cancels the order at the end of its life, no cancellation messages needed
+			auto pptr = std::make_shared<PlaceOrderLimitPayload>(direction, m_volumeUnit, price, TimeInForce::GTD, currentTimestamp + drawOrderLifeTime());
 			simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
 		}
 	} else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
-		auto responsepptr = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(msg->payload);
-		auto orderIterator = std::upper_bound(m_ownedOrders.begin(), m_ownedOrders.end(), responsepptr->id, [](OrderID orderSought, const BouchaudAgentOrder& agentOrder) {
-			return orderSought < agentOrder.id;
-		});
-		m_ownedOrders.insert(orderIterator, BouchaudAgentOrder(responsepptr->id, responsepptr->requestPayload->volume));
-
-		auto pptr = std::make_shared<SubscribeEventTradeByOrderPayload>(responsepptr->id);
-		simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_TRADE", pptr);
-
 		scheduleNextOrderPlacement();
-	} else if (msg->type == "EVENT_TRADE") {
-		auto eventpptr = std::dynamic_pointer_cast<EventTradePayload>(msg->payload);
-		auto orderIterator = std::lower_bound(m_ownedOrders.begin(), m_ownedOrders.end(), eventpptr->trade.restingOrderID(), [](const BouchaudAgentOrder& agentOrder, OrderID orderSought) {
-			return agentOrder.id < orderSought;
-		});
-		if(orderIterator != m_ownedOrders.end()) {
-			orderIterator->volume -= eventpptr->trade.volume();
-			if (orderIterator->volume == 0) {
-				m_ownedOrders.erase(orderIterator);
-			}
-		}
-	} else if (msg->type == "WAKEUP_FOR_CANCELLATION") {
-		if (!m_ownedOrders.empty()) { 
-			// randomly cancel an order with the exchange, and remove it from ownedOrders
-			std::uniform_int_distribution<size_t> discreteUniformDistribution(0, m_ownedOrders.size()-1);
-			auto indexToKill = discreteUniformDistribution(simulation()->randomGenerator());
-			auto it = m_ownedOrders.begin();
-			std::advance(it, indexToKill);
-
-			auto pptr = std::make_shared<CancelOrdersPayload>();
-			pptr->cancellations.push_back(CancelOrdersCancellation(it->id, it->volume));
-			simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "CANCEL_ORDER", pptr);
-
-			m_ownedOrders.erase(it); // safe to erase here because everything else first checks whether an order with a given id exists
-		}
-
-		scheduleNextOrderCancellation();
 	}
 }
 
+void BouchaudAgent::receiveWakeup(WakeupTag /*tag*/) {
+	// queue an L1 data request
+	simulation()->dispatchMessage(simulation()->currentTimestamp(), 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+}
+
 void BouchaudAgent::scheduleNextOrderPlacement() {
 	double rate = 1.0 / m_orderMeanArrivalTime;
 
@@ -134,18 +100,13 @@ void BouchaudAgent::scheduleNextOrderPlacement() {
 	Timestamp delay = (Timestamp)std::floor(exponentialDistribution(simulation()->randomGenerator()));
 
 	// queue a placement
-	simulation()->dispatchMessage(simulation()->currentTimestamp(), delay, name(), name(), "WAKEUP_FOR_PLACEMENT", std::make_shared<EmptyPayload>());
+	simulation()->scheduleWakeup(this, simulation()->currentTimestamp() + delay);
 }
 
-void BouchaudAgent::scheduleNextOrderCancellation() {
-	// based on m_ownedOrders.size() and m_orderMeanLifetime, schedule an order cancellation
+Timestamp BouchaudAgent::drawOrderLifeTime() {
+	// cancelling a random one of n orders at rate n / lifetime is the same as giving each an exponential lifetime
 	Timestamp adjustedMeanOrderLifetime = (Timestamp)(m_orderMeanLifeTime * (1 + m_marketOrderFraction));
-	double nextCancellationRate = !m_ownedOrders.empty() ? ((double)m_ownedOrders.size() / adjustedMeanOrderLifetime) : (1.0 / adjustedMeanOrderLifetime);
-
-	// generate a random cancellation delay
-	std::exponential_distribution<> exponentialDistribution(nextCancellationRate);
-	Timestamp delay = (Timestamp)std::floor(exponentialDistribution(simulation()->randomGenerator()));
 
-	// queue a cancellation
-	simulation()->dispatchMessage(simulation()->currentTimestamp(), delay, name(), name(), "WAKEUP_FOR_CANCELLATION", std::make_shared<EmptyPayload>());
+	std::exponential_distribution<> exponentialDistribution(1.0 / adjustedMeanOrderLifetime);
+	return (Timestamp)std::floor(exponentialDistribution(simulation()->randomGenerator()));
 }
@@ -3,13 +3,6 @@
 #include "Agent.h"
 #include "Order.h"
 
-struct BouchaudAgentOrder {
-	OrderID id;
-	Volume volume;
-
-	BouchaudAgentOrder(OrderID id, Volume volume) : id(id), volume(volume) { }
-};
-
 class BouchaudAgent : public Agent {
 public:
 	BouchaudAgent(const Simulation* simulation);
@@ -19,6 +12,7 @@ public:
 
 	// Inherited via Agent
 	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
 private:
 	std::string m_exchange;
 	Volume m_volumeUnit;
@@ -30,7 +24,5 @@ private:
 	double m_mu;
 
 	void scheduleNextOrderPlacement();
-	void scheduleNextOrderCancellation();
-
-	std::vector<BouchaudAgentOrder> m_ownedOrders;
+	Timestamp drawOrderLifeTime();
 };
\ No newline at end of file
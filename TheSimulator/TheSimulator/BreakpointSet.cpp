@@ -0,0 +1,165 @@
+#include "BreakpointSet.h"
+
+#include "Simulation.h"
+#include "SimulationException.h"
+#include "ExchangeAgent.h"
+
+#include <sstream>
+
+unsigned int BreakpointSet::add(const std::string& condition, const Simulation& simulation) {
+	std::stringstream ss(condition);
+	std::string subject;
+	ss >> subject;
+
+	Breakpoint breakpoint{ m_nextId, BreakpointKind::MessageType, condition, "", 0.0, nullptr, false };
+	if (subject == "type" || subject == "agent") {
+		breakpoint.kind = subject == "type" ? BreakpointKind::MessageType : BreakpointKind::Agent;
+		if (!(ss >> breakpoint.subject)) {
+			throw SimulationException("BreakpointSet::add(): '" + subject + "' needs a " + (subject == "type" ? "message type" : "agent name"));
+		}
+	} else if (subject == "spread" || subject == "mid") {
+		// the symbol is optional, 0 if the comparison follows the exchange
+		std::string comparison;
+		SymbolID symbol = 0;
+		bool isValid = (bool)(ss >> breakpoint.subject >> comparison);
+		if (isValid && comparison != ">" && comparison != "<") {
+			size_t end = 0;
+			try {
+				symbol = (SymbolID)std::stoul(comparison, &end);
+			} catch (const std::exception&) {
+				end = 0;
+			}
+			isValid = end > 0 && end == comparison.size() && (bool)(ss >> comparison);
+		}
+		if (!isValid || !(ss >> breakpoint.threshold) || (comparison != ">" && comparison != "<")) {
+			throw SimulationException("BreakpointSet::add(): expected '" + subject + " <exchange> [symbol] >|< <price>', got '" + condition + "'");
+		}
+
+		if (subject == "spread") {
+			breakpoint.kind = comparison == ">" ? BreakpointKind::SpreadAbove : BreakpointKind::SpreadBelow;
+		} else {
+			breakpoint.kind = comparison == ">" ? BreakpointKind::MidAbove : BreakpointKind::MidBelow;
+		}
+
+		auto exchangePtr = dynamic_cast<ExchangeAgent*>(simulation.findAgent(breakpoint.subject));
+		if (exchangePtr == nullptr || exchangePtr->book() == nullptr) {
+			throw SimulationException("BreakpointSet::add(): there is no exchange named '" + breakpoint.subject + "'");
+		}
+		breakpoint.bookPtr = exchangePtr->hostedBook(symbol);
+		if (breakpoint.bookPtr == nullptr) {
+			throw SimulationException("BreakpointSet::add(): '" + breakpoint.subject + "' does not host the symbol " + std::to_string(symbol)
+				+ ", it hosts the symbols 0 to " + std::to_string(exchangePtr->symbolCount() - 1));
+		}
+		breakpoint.wasSatisfied = isSatisfied(breakpoint);
+	} else {
+		throw SimulationException("BreakpointSet::add(): unknown condition '" + subject + "', expected 'type', 'agent', 'spread' or 'mid'");
+	}
+
+	m_breakpoints.push_back(breakpoint);
+	compile();
+	return m_nextId++;
+}
+
+bool BreakpointSet::remove(unsigned int id) {
+	auto it = std::find_if(m_breakpoints.begin(), m_breakpoints.end(), [id](const Breakpoint& breakpoint) {
+		return breakpoint.id == id;
+	});
+	if (it == m_breakpoints.end()) {
+		return false;
+	}
+
+	m_breakpoints.erase(it);
+	resetHit();
+	compile();
+	return true;
+}
+
+void BreakpointSet::compile() {
+	m_byMessageType.clear();
+	m_byAgent.clear();
+	m_byExchange.clear();
+
+	for (size_t index = 0; index < m_breakpoints.size(); ++index) {
+		const Breakpoint& breakpoint = m_breakpoints[index];
+		if (breakpoint.kind == BreakpointKind::MessageType) {
+			m_byMessageType.emplace(breakpoint.subject, index);
+		} else if (breakpoint.kind == BreakpointKind::Agent) {
+			m_byAgent.emplace(breakpoint.subject, index);
+		} else {
+			m_byExchange[breakpoint.subject].push_back(index);
+		}
+	}
+}
+
+bool BreakpointSet::check(const Message& message) {
+	if (!m_byMessageType.empty()) {
+		auto it = m_byMessageType.find(message.type);
+		if (it != m_byMessageType.end()) {
+			m_lastHitIndex = it->second;
+			return true;
+		}
+	}
+
+	if (!m_byAgent.empty()) {
+		auto it = m_byAgent.find(message.source);
+		for (auto targetIt = message.targets.begin(); it == m_byAgent.end() && targetIt != message.targets.end(); ++targetIt) {
+			it = m_byAgent.find(*targetIt);
+		}
+		if (it != m_byAgent.end()) {
+			m_lastHitIndex = it->second;
+			return true;
+		}
+	}
+
+	// only the exchange changes its book, and only while it handles a message or a wakeup
+	if (!m_byExchange.empty()) {
+		for (const std::string& target : message.targets) {
+			if (checkBooks(target)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool BreakpointSet::checkBooks(const std::string& agentName) {
+	auto it = m_byExchange.find(agentName);
+	if (it == m_byExchange.end()) {
+		return false;
+	}
+
+	bool isHit = false;
+	for (size_t index : it->second) {
+		Breakpoint& breakpoint = m_breakpoints[index];
+		const bool satisfied = isSatisfied(breakpoint);
+		if (satisfied && !breakpoint.wasSatisfied && !isHit) {
+			m_lastHitIndex = index;
+			isHit = true;
+		}
+		breakpoint.wasSatisfied = satisfied;
+	}
+	return isHit;
+}
+
+bool BreakpointSet::isSatisfied(const Breakpoint& breakpoint) const {
+	const Book& book = *breakpoint.bookPtr;
+	if (book.buyQueue().empty() || book.sellQueue().empty()) {
+		return false;
+	}
+
+	const double bestBid = (double)book.buyQueue().back().price();
+	const double bestAsk = (double)book.sellQueue().front().price();
+	switch (breakpoint.kind) {
+	case BreakpointKind::SpreadAbove:
+		return bestAsk - bestBid > breakpoint.threshold;
+	case BreakpointKind::SpreadBelow:
+		return bestAsk - bestBid < breakpoint.threshold;
+	case BreakpointKind::MidAbove:
+		return (bestAsk + bestBid) / 2 > breakpoint.threshold;
+	case BreakpointKind::MidBelow:
+		return (bestAsk + bestBid) / 2 < breakpoint.threshold;
+	default:
+		return false;
+	}
+}
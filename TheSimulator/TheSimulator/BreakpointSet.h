@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Message.h"
+#include "Book.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+enum class BreakpointKind {
+	MessageType, // a message of the type is delivered
+	Agent,       // a message from or to the agent is delivered
+	SpreadAbove,
+	SpreadBelow,
+	MidAbove,
+	MidBelow
+};
+
+struct Breakpoint {
+	unsigned int id;
+	BreakpointKind kind;
+	std::string description;
+
+	// MessageType, Agent: the type or the name; book conditions: the exchange, bookPtr is the book of its symbol
+	std::string subject;
+	double threshold;
+	BookPtr bookPtr;
+	// the book conditions break when they become true, not on every message while they stay true
+	bool wasSatisfied;
+};
+
+class Simulation;
+
+// The breakpoints of the interactive mode, checked by the simulation after every delivered message and wakeup. The
+// conditions are compiled when they are added: message type and agent breakpoints are hash lookups, book conditions are
+// only evaluated after a message to or a wakeup of their exchange, so that running with breakpoints set is nearly as fast
+// as running without.
+class BreakpointSet {
+public:
+	// parses e.g. "spread MARKET1 > 0.05", "mid MARKET1 2 < 99.5" (on the exchange's symbol 2, 0 if left out), "type
+	// PLACE_ORDER_MARKET" or "agent NOISE_AGENT_1", throws SimulationException on malformed conditions, unknown exchanges
+	// or symbols they do not host, returns the id of the breakpoint
+	unsigned int add(const std::string& condition, const Simulation& simulation);
+	bool remove(unsigned int id);
+
+	bool empty() const { return m_breakpoints.empty(); }
+	const std::vector<Breakpoint>& breakpoints() const { return m_breakpoints; }
+
+	// true if the message (just delivered) hits a breakpoint, which is then available through lastHit()
+	bool check(const Message& message);
+	// true if the book conditions on the agent (just woken up, e.g. expiring orders) hit a breakpoint
+	bool checkBooks(const std::string& agentName);
+	const Breakpoint* lastHit() const { return m_lastHitIndex < m_breakpoints.size() ? &m_breakpoints[m_lastHitIndex] : nullptr; }
+	void resetHit() { m_lastHitIndex = (size_t)-1; }
+private:
+	std::vector<Breakpoint> m_breakpoints;
+	unsigned int m_nextId = 1;
+	size_t m_lastHitIndex = (size_t)-1;
+
+	// compiled lookups into m_breakpoints, rebuilt whenever a breakpoint is added or removed
+	std::unordered_map<std::string, size_t> m_byMessageType;
+	std::unordered_map<std::string, size_t> m_byAgent;
+	std::unordered_map<std::string, std::vector<size_t>> m_byExchange;
+
+	void compile();
+	bool isSatisfied(const Breakpoint& breakpoint) const;
+};
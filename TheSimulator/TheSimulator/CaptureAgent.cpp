@@ -0,0 +1,63 @@
+#include "CaptureAgent.h"
+
+#include "Simulation.h"
+#include "ExchangeAgentMessagePayloads.h"
+
+CaptureAgent::CaptureAgent(const Simulation* simulation)
+	: Agent(simulation), m_aggregationPeriod(0) { }
+
+CaptureAgent::CaptureAgent(const Simulation* simulation, const std::string& name)
+	: Agent(simulation, name), m_aggregationPeriod(0) { }
+
+void CaptureAgent::receiveMessage(const MessagePtr& messagePtr) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	if (messagePtr->type == "EVENT_SIMULATION_START") {
+		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_TRADE", std::make_shared<EmptyPayload>());
+		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_LIMIT", std::make_shared<EmptyPayload>());
+		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_MARKET", std::make_shared<EmptyPayload>());
+		if (m_aggregationPeriod) {
+			simulation()->scheduleWakeup(this, currentTimestamp + m_aggregationPeriod);
+		}
+	} else if (messagePtr->type == "EVENT_TRADE") {
+		const Trade& trade = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload)->trade;
+		m_trades.push_back(CapturedTrade{ trade.timestamp(), trade.id(), trade.aggressingOrderID(), trade.restingOrderID(), trade.volume(), (double)trade.price(), (uint32_t)trade.direction() });
+	} else if (messagePtr->type == "EVENT_ORDER_LIMIT") {
+		const LimitOrder& order = std::dynamic_pointer_cast<EventOrderLimitPayload>(messagePtr->payload)->order;
+		m_orderEvents.push_back(CapturedOrderEvent{ order.timestamp(), order.id(), order.volume(), (double)order.price(), (uint32_t)order.direction(), 0 });
+		if (!m_aggregationPeriod) {
+			simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+		}
+	} else if (messagePtr->type == "EVENT_ORDER_MARKET") {
+		const MarketOrder& order = std::dynamic_pointer_cast<EventOrderMarketPayload>(messagePtr->payload)->order;
+		m_orderEvents.push_back(CapturedOrderEvent{ order.timestamp(), order.id(), order.volume(), 0.0, (uint32_t)order.direction(), 1 });
+		if (!m_aggregationPeriod) {
+			simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+		}
+	} else if (messagePtr->type == "RESPONSE_RETRIEVE_L1") {
+		auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(messagePtr->payload);
+		m_l1.push_back(CapturedL1{ pptr->time, (double)pptr->bestBidPrice, pptr->bestBidVolume, pptr->bidTotalVolume, (double)pptr->bestAskPrice, pptr->bestAskVolume, pptr->askTotalVolume });
+	}
+}
+
+void CaptureAgent::receiveWakeup(WakeupTag /*tag*/) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+	simulation()->scheduleWakeup(this, currentTimestamp + m_aggregationPeriod);
+}
+
+#include "ParameterStorage.h"
+
+void CaptureAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	Agent::configure(node, configurationPath);
+
+	pugi::xml_attribute att;
+	if (!(att = node.attribute("exchange")).empty()) {
+		m_exchange = simulation()->parameters().processString(att.as_string());
+	}
+
+	if (!(att = node.attribute("aggregationPeriod")).empty()) {
+		m_aggregationPeriod = std::stoull(simulation()->parameters().processString(att.as_string()));
+	}
+}
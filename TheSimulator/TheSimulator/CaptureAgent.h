@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Agent.h"
+
+#include <cstdint>
+#include <vector>
+
+struct CapturedTrade {
+	uint64_t timestamp;
+	uint64_t id;
+	uint64_t aggressingOrderId;
+	uint64_t restingOrderId;
+	uint64_t volume;
+	double price;
+	uint32_t direction;
+};
+
+struct CapturedL1 {
+	uint64_t timestamp;
+	double bidPrice;
+	uint64_t bidVolume;
+	uint64_t bidTotalVolume;
+	double askPrice;
+	uint64_t askVolume;
+	uint64_t askTotalVolume;
+};
+
+struct CapturedOrderEvent {
+	uint64_t timestamp;
+	uint64_t orderId;
+	uint64_t volume;
+	double price; // 0 for market orders
+	uint32_t direction;
+	uint32_t isMarket;
+};
+
+// Records the trades, the L1 updates and the order events of an exchange into flat buffers, meant to be handed over
+// to the caller of the simulation (i.e. the maxe Python module) once the simulation is over. Like L1LogAgent, the L1
+// is retrieved on every order event, or every 'aggregationPeriod' time units if that is set.
+class CaptureAgent : public Agent {
+public:
+	CaptureAgent(const Simulation* simulation);
+	CaptureAgent(const Simulation* simulation, const std::string& name);
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	// Inherited via Agent
+	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
+
+	std::vector<CapturedTrade>& trades() { return m_trades; }
+	std::vector<CapturedL1>& l1() { return m_l1; }
+	std::vector<CapturedOrderEvent>& orderEvents() { return m_orderEvents; }
+private:
+	std::string m_exchange;
+	Timestamp m_aggregationPeriod;
+
+	std::vector<CapturedTrade> m_trades;
+	std::vector<CapturedL1> m_l1;
+	std::vector<CapturedOrderEvent> m_orderEvents;
+};
@@ -0,0 +1,185 @@
+#include "DepthSnapshotAgent.h"
+
+#include "Simulation.h"
+#include "SimulationException.h"
+#include "ExchangeAgent.h"
+#include "ExchangeAgentMessagePayloads.h"
+
+#include <cstring>
+
+DepthSnapshotAgent::DepthSnapshotAgent(const Simulation* simulation)
+	: DepthSnapshotAgent(simulation, "") { }
+
+DepthSnapshotAgent::DepthSnapshotAgent(const Simulation* simulation, const std::string& name)
+	: Agent(simulation, name), m_symbol(0), m_level(DepthSnapshotLevel::L2), m_period(0), m_keyframeInterval(0), m_outputFile(nullptr),
+	m_bookPtr(nullptr), m_snapshotCount(0), m_entryCount(0) { }
+
+DepthSnapshotAgent::~DepthSnapshotAgent() {
+	if (m_bookPtr != nullptr) {
+		m_bookPtr->detachChangeJournal(&m_journal);
+	}
+}
+
+void DepthSnapshotAgent::receiveMessage(const MessagePtr& messagePtr) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	if (messagePtr->type == "EVENT_SIMULATION_START") {
+		auto exchangePtr = dynamic_cast<ExchangeAgent*>(simulation()->findAgent(m_exchange));
+		if (exchangePtr == nullptr || exchangePtr->book() == nullptr) {
+			throw SimulationException("DepthSnapshotAgent::receiveMessage(): '" + name() + "' found no exchange with a book named '" + m_exchange + "'");
+		}
+		m_bookPtr = exchangePtr->hostedBook(m_symbol);
+		if (m_bookPtr == nullptr) {
+			throw SimulationException("DepthSnapshotAgent::receiveMessage(): '" + name() + "' found no symbol " + std::to_string(m_symbol)
+				+ " on '" + m_exchange + "', it hosts the symbols 0 to " + std::to_string(exchangePtr->symbolCount() - 1));
+		}
+		m_bookPtr->attachChangeJournal(&m_journal);
+
+		takeSnapshot(currentTimestamp);
+		if (m_period) {
+			simulation()->scheduleWakeup(this, currentTimestamp + m_period);
+		} else {
+			// a snapshot after every timestamp with changes, once all of them are in
+			m_journal.setChangeListener([this]() { simulation()->deferToEndOfTimestamp(this); });
+		}
+	}
+}
+
+void DepthSnapshotAgent::receiveWakeup(WakeupTag /*tag*/) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	takeSnapshot(currentTimestamp);
+	simulation()->scheduleWakeup(this, currentTimestamp + m_period);
+}
+
+void DepthSnapshotAgent::endOfTimestamp() {
+	takeSnapshot(simulation()->currentTimestamp());
+}
+
+void DepthSnapshotAgent::takeSnapshot(Timestamp timestamp) {
+	const bool isKeyframe = m_snapshotCount == 0 || (m_keyframeInterval > 0 && m_snapshotCount % m_keyframeInterval == 0);
+
+	m_snapshotBuffer.clear();
+	append<uint8_t>(isKeyframe ? 0 : 1);
+	append<uint8_t>(m_level == DepthSnapshotLevel::L2 ? 2 : 3);
+	append<uint64_t>(timestamp);
+	const size_t entryCountOffset = m_snapshotBuffer.size();
+	append<uint32_t>(0);
+
+	m_entryCount = 0;
+	if (isKeyframe) {
+		writeKeyframe();
+	} else {
+		writeDelta();
+	}
+
+	const uint32_t entryCount = (uint32_t)m_entryCount;
+	std::memcpy(&m_snapshotBuffer[entryCountOffset], &entryCount, sizeof(entryCount));
+	m_outputFile->write(m_snapshotBuffer);
+
+	m_journal.clear();
+	++m_snapshotCount;
+}
+
+void DepthSnapshotAgent::writeKeyframe() {
+	for (const auto* queue : { &m_bookPtr->buyQueue(), &m_bookPtr->sellQueue() }) {
+		for (const TickContainer& level : *queue) {
+			if (m_level == DepthSnapshotLevel::L2) {
+				if (level.volume() > 0) {
+					writeLevel(queue == &m_bookPtr->buyQueue() ? OrderDirection::Buy : OrderDirection::Sell, level.price(), &level);
+				}
+			} else {
+				for (const LimitOrderPtr& order : level) {
+					if (order->volume() > 0) {
+						writeOrder(*order);
+					}
+				}
+			}
+		}
+	}
+}
+
+void DepthSnapshotAgent::writeDelta() {
+	if (m_level == DepthSnapshotLevel::L2) {
+		for (const auto& level : m_journal.levels()) {
+			writeLevel(level.first, level.second, m_bookPtr->findLevel(level.first, level.second));
+		}
+	} else {
+		for (const LimitOrderPtr& order : m_journal.orders()) {
+			writeOrder(*order);
+		}
+	}
+}
+
+void DepthSnapshotAgent::writeLevel(OrderDirection direction, Money price, const TickContainer* level) {
+	// cancelled orders stay in their level with no volume until it is matched out
+	Volume volume = 0;
+	uint32_t orderCount = 0;
+	if (level != nullptr) {
+		for (const LimitOrderPtr& order : *level) {
+			volume += order->volume();
+			orderCount += order->volume() > 0 ? 1 : 0;
+		}
+	}
+
+	append<uint8_t>(direction == OrderDirection::Buy ? 0 : 1);
+	append<double>((double)price);
+	append<uint64_t>(volume);
+	append<uint32_t>(orderCount);
+	++m_entryCount;
+}
+
+void DepthSnapshotAgent::writeOrder(const LimitOrder& order) {
+	append<uint64_t>(order.id());
+	append<uint8_t>(order.direction() == OrderDirection::Buy ? 0 : 1);
+	append<double>((double)order.price());
+	append<uint64_t>(order.volume());
+	++m_entryCount;
+}
+
+#include "ParameterStorage.h"
+
+void DepthSnapshotAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	Agent::configure(node, configurationPath);
+
+	pugi::xml_attribute att;
+	if (!(att = node.attribute("exchange")).empty()) {
+		m_exchange = simulation()->parameters().processString(att.as_string());
+	}
+
+	if (!(att = node.attribute("symbol")).empty()) {
+		m_symbol = (SymbolID)std::stoul(simulation()->parameters().processString(att.as_string()));
+	}
+
+	if (!(att = node.attribute("level")).empty()) {
+		const std::string level = simulation()->parameters().processString(att.as_string());
+		if (level == "L2") {
+			m_level = DepthSnapshotLevel::L2;
+		} else if (level == "L3") {
+			m_level = DepthSnapshotLevel::L3;
+		} else {
+			throw SimulationException("DepthSnapshotAgent::configure(): unknown level '" + level + "', expected 'L2' or 'L3'");
+		}
+	}
+
+	if (!(att = node.attribute("period")).empty()) {
+		m_period = std::stoull(simulation()->parameters().processString(att.as_string()));
+	}
+
+	if (!(att = node.attribute("keyframeInterval")).empty()) {
+		m_keyframeInterval = (unsigned int)std::stoul(simulation()->parameters().processString(att.as_string()));
+	}
+
+	if (!(att = node.attribute("outputFile")).empty()) {
+		m_outputPathTemplate = att.as_string();
+		m_outputFile = AsyncLogWriter::instance().open(simulation()->parameters().processString(m_outputPathTemplate));
+	} else {
+		throw SimulationException("DepthSnapshotAgent::configure(): '" + name() + "' needs an 'outputFile' to write the snapshots to");
+	}
+}
+
+void DepthSnapshotAgent::beginBranch() {
+	if (m_outputFile != nullptr) {
+		m_outputFile = AsyncLogWriter::instance().branch(m_outputFile, branchOutputPath(m_outputPathTemplate, m_outputFile->path()));
+	}
+}
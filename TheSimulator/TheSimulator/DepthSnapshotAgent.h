@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Agent.h"
+#include "Book.h"
+#include "AsyncLogWriter.h"
+
+#include <cstdint>
+#include <string>
+
+enum class DepthSnapshotLevel {
+	L2, // aggregated price levels
+	L3  // individual orders
+};
+
+// Writes the full depth of the book of an exchange's 'symbol' (0 by default) to 'outputFile', reading the book in-process
+// instead of through RETRIEVE_BOOK_* messages; a symbol the exchange does not host fails the run. The first snapshot (and
+// every 'keyframeInterval'-th one, if set) is a keyframe of the whole book, all other snapshots are deltas holding only
+// what changed since the previous snapshot, as tracked by the book's change journal. Snapshots are taken every 'period'
+// time units, or with period 0 at the end of every timestamp in which the book changed.
+//
+// The binary format is a sequence of snapshots, all numbers little endian (i.e. as on x86):
+//   uint8 kind (0 keyframe, 1 delta), uint8 level (2 or 3), uint64 timestamp, uint32 entry count, entries
+// L2 entry: uint8 side (0 bid, 1 ask), float64 price, uint64 volume, uint32 order count; volume 0 removes the level
+// L3 entry: uint64 order id, uint8 side, float64 price, uint64 volume; volume 0 removes the order
+class DepthSnapshotAgent : public Agent {
+public:
+	DepthSnapshotAgent(const Simulation* simulation);
+	DepthSnapshotAgent(const Simulation* simulation, const std::string& name);
+	~DepthSnapshotAgent();
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	// Inherited via Agent
+	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
+	void endOfTimestamp() override;
+	void beginBranch() override;
+private:
+	std::string m_exchange;
+	SymbolID m_symbol;
+	DepthSnapshotLevel m_level;
+	Timestamp m_period;
+	unsigned int m_keyframeInterval;
+	LogStreamPtr m_outputFile;
+	std::string m_outputPathTemplate;
+
+	// held so that the journal can be detached even if the exchange is destroyed first
+	BookPtr m_bookPtr;
+	BookChangeJournal m_journal;
+	unsigned int m_snapshotCount;
+
+	std::string m_snapshotBuffer;
+	size_t m_entryCount;
+
+	void takeSnapshot(Timestamp timestamp);
+	void writeKeyframe();
+	void writeDelta();
+	void writeLevel(OrderDirection direction, Money price, const TickContainer* level);
+	void writeOrder(const LimitOrder& order);
+
+	template<class T>
+	void append(T value) { m_snapshotBuffer.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+};
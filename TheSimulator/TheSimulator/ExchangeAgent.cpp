@@ -9,43 +9,130 @@
 
 #include <iostream>
 
+ExchangeAgent::Instrument::Instrument(SymbolID symbol, const BookPtr& book)
+	: symbol(symbol), book(book), marketOrderTopic(TOPICID_INVALID), limitOrderTopic(TOPICID_INVALID), tradeTopic(TOPICID_INVALID), bookDeltaTopic(TOPICID_INVALID),
+	isBookDeltaPublishingDeferred(false), hasTradedSinceStopScan(false) { }
+
 ExchangeAgent::ExchangeAgent(const Simulation* simulation)
-	: Agent(simulation), m_processingDelay(0), m_bookPtr(nullptr) { }
+	: Agent(simulation), m_processingDelay(0) { }
 
 ExchangeAgent::ExchangeAgent(const Simulation* simulation, const std::string& name, const BookPtr& bookPtr, Timestamp processingDelay)
-	: Agent(simulation, name), m_processingDelay(processingDelay), m_bookPtr(bookPtr) {
+	: Agent(simulation, name), m_processingDelay(processingDelay) {
+
+	m_instruments.resize(1);
+	addInstrument(0, bookPtr);
+}
+
+BookPtr ExchangeAgent::book(SymbolID symbol) const {
+	if (symbol >= m_instruments.size() || m_instruments[symbol] == nullptr) {
+		return nullptr;
+	}
+	return m_instruments[symbol]->book;
+}
+
+BookPtr ExchangeAgent::hostedBook(SymbolID symbol) {
+	if (symbol >= m_instruments.size()) {
+		return nullptr;
+	}
+	return instrument(symbol).book;
+}
+
+ExchangeAgent::Instrument& ExchangeAgent::instrument(SymbolID symbol) {
+	if (m_instruments[symbol] == nullptr) {
+		addInstrument(symbol, m_bookFactory());
+	}
+	return *m_instruments[symbol];
+}
 
-	std::function<void(TradePtr)> loggingCallbackBound = std::bind(&ExchangeAgent::notifyTradeSubscribers, this, std::placeholders::_1);
+ExchangeAgent::Instrument& ExchangeAgent::addInstrument(SymbolID symbol, const BookPtr& bookPtr) {
+	m_instruments[symbol] = std::make_unique<Instrument>(symbol, bookPtr);
+	Instrument& instrument = *m_instruments[symbol];
+
+	const std::string topicPrefix = name() + "/" + std::to_string(symbol) + "/";
+	instrument.marketOrderTopic = simulation()->registerTopic(topicPrefix + "EVENT_ORDER_MARKET");
+	instrument.limitOrderTopic = simulation()->registerTopic(topicPrefix + "EVENT_ORDER_LIMIT");
+	instrument.tradeTopic = simulation()->registerTopic(topicPrefix + "EVENT_TRADE");
+	instrument.bookDeltaTopic = simulation()->registerTopic(topicPrefix + "EVENT_BOOK_DELTA");
+
+	std::function<void(TradePtr)> loggingCallbackBound = std::bind(&ExchangeAgent::notifyTradeSubscribers, this, std::ref(instrument), std::placeholders::_1);
 	bookPtr->registerTradeLoggingCallback(loggingCallbackBound);
+	bookPtr->registerBookDeltaCallback(std::bind(&ExchangeAgent::collectBookDelta, this, std::ref(instrument), std::placeholders::_1));
+	return instrument;
 }
 
 void ExchangeAgent::receiveMessage(const MessagePtr& msg) {
+	auto ipptr = std::dynamic_pointer_cast<InstrumentPayload>(msg->payload);
+	const SymbolID symbol = ipptr != nullptr ? ipptr->symbol : 0;
+	if (symbol >= m_instruments.size()) {
+		auto retpptr = std::make_shared<ErrorResponsePayload>("Unknown symbol " + std::to_string(symbol) + " in request type: " + msg->type);
+		fastRespondToMessage(msg, retpptr);
+		return;
+	}
+	Instrument& instrument = this->instrument(symbol);
+	const BookPtr& bookPtr = instrument.book;
+
+	// the GTD orders are gone at their expiry, whether or not the wakeup for it came first
+	bookPtr->expireOrders(simulation()->currentTimestamp());
+
 	if (msg->type == "PLACE_ORDER_MARKET") {
 		auto ptr = std::dynamic_pointer_cast<PlaceOrderMarketPayload>(msg->payload);
-		auto mop = m_bookPtr->placeMarketOrder(ptr->direction, msg->arrival, ptr->volume);
+		auto mop = bookPtr->placeMarketOrder(ptr->direction, msg->arrival, ptr->volume);
 		
-		PlaceOrderMarketResponsePayload retpay(mop->id(), ptr);
+		PlaceOrderMarketResponsePayload retpay(mop->id(), ptr, ptr->volume - mop->volume());
 		auto retpayptr = std::make_shared<PlaceOrderMarketResponsePayload>(retpay);
 
 		respondToMessage(msg, retpayptr, m_processingDelay);
 
-		notifyMarketOrderSubscribers(mop);
+		notifyMarketOrderSubscribers(instrument, mop);
 	} else if (msg->type == "PLACE_ORDER_LIMIT") {
 		auto ptr = std::dynamic_pointer_cast<PlaceOrderLimitPayload>(msg->payload);
-		auto lop = m_bookPtr->placeLimitOrder(ptr->direction, msg->arrival, ptr->volume, ptr->price);
+		auto lop = bookPtr->placeLimitOrder(ptr->direction, msg->arrival, ptr->volume, ptr->price, ptr->timeInForce, ptr->expiry, ptr->displayVolume);
+		if (ptr->timeInForce == TimeInForce::GTD && lop->volume() > 0) {
+			scheduleExpiryWakeup(instrument, ptr->expiry);
+		}
 
-		PlaceOrderLimitResponsePayload retpay(lop->id(), ptr);
+		PlaceOrderLimitResponsePayload retpay(lop->id(), ptr, filledVolume(lop->id()));
 		auto retpayptr = std::make_shared<PlaceOrderLimitResponsePayload>(retpay);
 
 		respondToMessage(msg, retpayptr, m_processingDelay);
 
-		notifyLimitOrderSubscribers(lop);
+		notifyLimitOrderSubscribers(instrument, lop);
+	} else if (msg->type == "PLACE_ORDERS") {
+		auto ptr = std::dynamic_pointer_cast<PlaceOrdersPayload>(msg->payload);
+		auto retpptr = std::make_shared<PlaceOrdersResponsePayload>(ptr);
+		retpptr->ids.reserve(ptr->orders.size());
+		retpptr->filledVolumes.reserve(ptr->orders.size());
+
+		for (const PlaceOrdersOrder& order : ptr->orders) {
+			if (order.isMarket) {
+				auto mop = bookPtr->placeMarketOrder(order.direction, msg->arrival, order.volume);
+				retpptr->ids.push_back(mop->id());
+				retpptr->filledVolumes.push_back(order.volume - mop->volume());
+				notifyMarketOrderSubscribers(instrument, mop);
+			} else {
+				auto lop = bookPtr->placeLimitOrder(order.direction, msg->arrival, order.volume, order.price, order.timeInForce, order.expiry, order.displayVolume);
+				if (order.timeInForce == TimeInForce::GTD && lop->volume() > 0) {
+					scheduleExpiryWakeup(instrument, order.expiry);
+				}
+				retpptr->ids.push_back(lop->id());
+				retpptr->filledVolumes.push_back(filledVolume(lop->id()));
+				notifyLimitOrderSubscribers(instrument, lop);
+			}
+		}
+
+		respondToMessage(msg, retpptr, m_processingDelay);
+	} else if (msg->type == "PLACE_ORDER_STOP") {
+		auto ptr = std::dynamic_pointer_cast<PlaceOrderStopPayload>(msg->payload);
+		const OrderID id = bookPtr->orderFactory()->reserveOrderId();
+		instrument.stopOrders.add(StopOrder{ id, msg->source, ptr->direction, ptr->volume, ptr->stopPrice, ptr->isLimit, ptr->limitPrice });
+
+		respondToMessage(msg, std::make_shared<PlaceOrderStopResponsePayload>(id, ptr), m_processingDelay);
 	} else if (msg->type == "RETRIEVE_ORDERS") {
 		auto pptr = std::dynamic_pointer_cast<RetrieveOrdersPayload>(msg->payload);
 		auto retpptr = std::make_shared<RetrieveOrdersResponsePayload>();
 		for (OrderID id : pptr->ids) {
 			LimitOrderPtr lop;
-			if (m_bookPtr->tryGetOrder(id, lop)) {
+			if (bookPtr->tryGetOrder(id, lop)) {
 				retpptr->orders.push_back(*lop);
 			}
 		}
@@ -57,39 +144,57 @@ void ExchangeAgent::receiveMessage(const MessagePtr& msg) {
 		
 		for (const auto& cancellation : pptr->cancellations) {
 			auto cancellationCopy = cancellation;
-			cancellationCopy.volume = m_bookPtr->cancelOrder(cancellation.id, cancellation.volume);
+			if (instrument.stopOrders.remove(cancellation.id)) {
+				// stop orders are cancelled in full
+				cancellationCopy.volume = 0;
+			} else {
+				cancellationCopy.volume = bookPtr->cancelOrder(cancellation.id, cancellation.volume);
+			}
 			retpptr->cancellations.push_back(cancellationCopy);
 		}
 
 		// NOTE: event [orderId no longer exists in the book] is a no-op
 		// NOTE: might be woth implementing the processing delay as well, in one way or another (think about the error message about)
+		respondToMessage(msg, retpptr, m_processingDelay);
+	} else if (msg->type == "REPLACE_ORDERS") {
+		auto pptr = std::dynamic_pointer_cast<ReplaceOrdersPayload>(msg->payload);
+		auto retpptr = std::make_shared<ReplaceOrdersPayload>();
+		retpptr->replacements.reserve(pptr->replacements.size());
+
+		// NOTE: event [orderId no longer exists in the book] is a no-op, its resting volume is 0
+		for (const auto& replacement : pptr->replacements) {
+			auto replacementCopy = replacement;
+			replacementCopy.volume = bookPtr->replaceOrder(replacement.id, msg->arrival, replacement.price, replacement.volume);
+			retpptr->replacements.push_back(replacementCopy);
+		}
+
 		respondToMessage(msg, retpptr, m_processingDelay);
 	} else if (msg->type == "RETRIEVE_L1") {
 		auto retpptr = std::make_shared<RetrieveL1ResponsePayload>();
 		retpptr->time = simulation()->currentTimestamp();
 
-		if (m_bookPtr->sellQueue().empty()) {
+		if (bookPtr->sellQueue().empty()) {
 			retpptr->bestAskPrice = 0;
 			retpptr->bestAskVolume = 0;
 			retpptr->askTotalVolume = 0;
 		} else {
-			const auto& bestSellLevel = m_bookPtr->sellQueue().front();
+			const auto& bestSellLevel = bookPtr->sellQueue().front();
 			retpptr->bestAskPrice = bestSellLevel.price();
 			retpptr->bestAskVolume = bestSellLevel.volume();
-			retpptr->askTotalVolume = std::accumulate(m_bookPtr->sellQueue().begin(), m_bookPtr->sellQueue().end(), (Volume)0, [](Volume acc, const TickContainer& cont) {
+			retpptr->askTotalVolume = std::accumulate(bookPtr->sellQueue().begin(), bookPtr->sellQueue().end(), (Volume)0, [](Volume acc, const TickContainer& cont) {
 				return acc + cont.volume();
 			});
 		}
 
-		if (m_bookPtr->buyQueue().empty()) {
+		if (bookPtr->buyQueue().empty()) {
 			retpptr->bestBidPrice = 0;
 			retpptr->bestBidVolume = 0;
 			retpptr->bidTotalVolume = 0;
 		} else {
-			const auto& bestBuyLevel = m_bookPtr->buyQueue().back();
+			const auto& bestBuyLevel = bookPtr->buyQueue().back();
 			retpptr->bestBidPrice = bestBuyLevel.price();
 			retpptr->bestBidVolume = bestBuyLevel.volume();
-			retpptr->bidTotalVolume = std::accumulate(m_bookPtr->buyQueue().begin(), m_bookPtr->buyQueue().end(), (Volume)0, [](Volume acc, const TickContainer& cont) {
+			retpptr->bidTotalVolume = std::accumulate(bookPtr->buyQueue().begin(), bookPtr->buyQueue().end(), (Volume)0, [](Volume acc, const TickContainer& cont) {
 				return acc + cont.volume();
 			});
 		}
@@ -99,8 +204,8 @@ void ExchangeAgent::receiveMessage(const MessagePtr& msg) {
 		auto pptr = std::dynamic_pointer_cast<RetrieveBookPayload>(msg->payload);
 		auto retpptr = std::make_shared<RetrieveBookResponsePayload>(simulation()->currentTimestamp());
 		
-		unsigned int actualDepth = (unsigned int)std::min((size_t)pptr->depth, m_bookPtr->sellQueue().size());
-		const auto beg = m_bookPtr->sellQueue().cbegin();
+		unsigned int actualDepth = (unsigned int)std::min((size_t)pptr->depth, bookPtr->sellQueue().size());
+		const auto beg = bookPtr->sellQueue().cbegin();
 		auto end = beg;
 		std::advance(end, actualDepth);
 		retpptr->tickContainers.reserve(actualDepth);
@@ -111,69 +216,101 @@ void ExchangeAgent::receiveMessage(const MessagePtr& msg) {
 		auto pptr = std::dynamic_pointer_cast<RetrieveBookPayload>(msg->payload);
 		auto retpptr = std::make_shared<RetrieveBookResponsePayload>(simulation()->currentTimestamp());
 
-		unsigned int actualDepth = (unsigned int)std::min((size_t)pptr->depth, m_bookPtr->buyQueue().size());
-		const auto beg = m_bookPtr->buyQueue().crbegin();
+		unsigned int actualDepth = (unsigned int)std::min((size_t)pptr->depth, bookPtr->buyQueue().size());
+		const auto beg = bookPtr->buyQueue().crbegin();
 		auto end = beg;
 		std::advance(end, actualDepth);
 		retpptr->tickContainers.reserve(actualDepth);
 		std::copy(beg, end, std::back_inserter(retpptr->tickContainers));
 
 		respondToMessage(msg, retpptr);
-	} else if (msg->type == "SUBSCRIBE_EVENT_ORDER_MARKET") { 
-		if (std::binary_search(m_marketOrderSubscribers.begin(), m_marketOrderSubscribers.end(), msg->source)) {
-			auto eretpptr = std::make_shared<ErrorResponsePayload>("The agent is already subscribed to order events: " + msg->source);
-			fastRespondToMessage(msg, eretpptr);
-		} else {
-			auto iit = std::upper_bound(m_marketOrderSubscribers.begin(), m_marketOrderSubscribers.end(), msg->source);
-			m_marketOrderSubscribers.insert(iit, msg->source);
-
-			auto sretpptr = std::make_shared<SuccessResponsePayload>("Agent subscribed successfully to order events: " + msg->source);
-			fastRespondToMessage(msg, sretpptr);
-		}
+	} else if (msg->type == "SUBSCRIBE_EVENT_ORDER_MARKET") {
+		subscribe(instrument.marketOrderTopic, msg, "order events");
 	} else if (msg->type == "SUBSCRIBE_EVENT_ORDER_LIMIT") {
-		if (std::binary_search(m_limitOrderSubscribers.begin(), m_limitOrderSubscribers.end(), msg->source)) {
-			auto eretpptr = std::make_shared<ErrorResponsePayload>("The agent is already subscribed to order events: " + msg->source);
-			fastRespondToMessage(msg, eretpptr);
-		} else {
-			auto iit = std::upper_bound(m_limitOrderSubscribers.begin(), m_limitOrderSubscribers.end(), msg->source);
-			m_limitOrderSubscribers.insert(iit, msg->source);
-
-			auto sretpptr = std::make_shared<SuccessResponsePayload>("Agent subscribed successfully to order events: " + msg->source);
-			fastRespondToMessage(msg, sretpptr);
-		}
+		subscribe(instrument.limitOrderTopic, msg, "order events");
 	} else if (msg->type == "SUBSCRIBE_EVENT_TRADE") {
-		if (std::binary_search(m_tradeSubscribers.begin(), m_tradeSubscribers.end(), msg->source)) {
-			auto eretpptr = std::make_shared<ErrorResponsePayload>("The agent is already subscribed to trade events: " + msg->source);
+		subscribe(instrument.tradeTopic, msg, "trade events");
+	} else if (msg->type == "SUBSCRIBE_EVENT_BOOK_DELTA") {
+		const AgentHandle subscriber = simulation()->findAgentHandle(msg->source);
+		if (subscriber == AGENTHANDLE_INVALID) {
+			auto eretpptr = std::make_shared<ErrorResponsePayload>("Only agents can subscribe to book delta events: " + msg->source);
+			fastRespondToMessage(msg, eretpptr);
+		} else if (simulation()->topic(instrument.bookDeltaTopic).subscribers.contains(subscriber) || !instrument.newBookDeltaSubscribers.insert(subscriber)) {
+			auto eretpptr = std::make_shared<ErrorResponsePayload>("The agent is already subscribed to book delta events: " + msg->source);
 			fastRespondToMessage(msg, eretpptr);
 		} else {
-			auto iit = std::upper_bound(m_tradeSubscribers.begin(), m_tradeSubscribers.end(), msg->source);
-			m_tradeSubscribers.insert(iit, msg->source);
+			deferBookDeltaPublishing(instrument);
 
-			auto sretpptr = std::make_shared<SuccessResponsePayload>("Agent subscribed successfully to trade events: " + msg->source);
+			auto sretpptr = std::make_shared<SuccessResponsePayload>("Agent subscribed successfully to book delta events: " + msg->source);
 			fastRespondToMessage(msg, sretpptr);
 		}
 	} else if (msg->type == "SUBSCRIBE_EVENT_ORDER_TRADE") {
 		auto pptr = std::dynamic_pointer_cast<SubscribeEventTradeByOrderPayload>(msg->payload);
-		if (m_tradeByOrderSubscribers.count(pptr->id) == 0) {
-			m_tradeByOrderSubscribers[pptr->id] = std::vector<std::string>();
-		}
-
-		auto& subscribers = m_tradeByOrderSubscribers[pptr->id];
-		if (std::binary_search(subscribers.begin(), subscribers.end(), msg->source)) {
+		const AgentHandle subscriber = simulation()->findAgentHandle(msg->source);
+		LimitOrderPtr lop;
+		if (subscriber == AGENTHANDLE_INVALID) {
+			auto eretpptr = std::make_shared<ErrorResponsePayload>("Only agents can subscribe to trade events for order " + std::to_string(pptr->id) + ":" + msg->source);
+			fastRespondToMessage(msg, eretpptr);
+		} else if (!bookPtr->tryGetOrder(pptr->id, lop) || lop->volume() + lop->hiddenVolume() == 0) {
+			// the order will not trade again, its subscription would never be dropped
+			fastRespondToMessage(msg, std::make_shared<SubscribeEventTradeByOrderResponsePayload>(0, filledVolume(pptr->id), pptr));
+		} else if (!insertSorted(m_tradeByOrderSubscribers[pptr->id], subscriber)) {
 			auto eretpptr = std::make_shared<ErrorResponsePayload>("The agent is already subscribed to trade events for order " + std::to_string(pptr->id) + ":" + msg->source);
 			fastRespondToMessage(msg, eretpptr);
 		} else {
-			auto iit = std::upper_bound(subscribers.begin(), subscribers.end(), msg->source);
-			subscribers.insert(iit, msg->source);
-
-			auto sretpptr = std::make_shared<SuccessResponsePayload>("Agent subscribed to trade events for order " + std::to_string(pptr->id) + ":" + msg->source);
-			fastRespondToMessage(msg, sretpptr);
+			fastRespondToMessage(msg, std::make_shared<SubscribeEventTradeByOrderResponsePayload>(lop->volume() + lop->hiddenVolume(), filledVolume(pptr->id), pptr));
 		}
 	} else {
 		auto retpptr = std::make_shared<ErrorResponsePayload>("Unrecognized request type: " + msg->type);
 
 		fastRespondToMessage(msg, retpptr);
 	}
+
+	// the stop orders triggered by the trades of this message enter the book right after it
+	releaseTriggeredStopOrders(instrument);
+	dropTradeByOrderSubscriptions(instrument);
+}
+
+void ExchangeAgent::receiveWakeup(WakeupTag tag) {
+	// the only wakeups of the exchange are the expiries, tagged with the symbol of their book
+	Instrument& instrument = this->instrument((SymbolID)tag);
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	instrument.book->expireOrders(currentTimestamp);
+	instrument.expiryWakeups.erase(currentTimestamp);
+
+	const Timestamp nextExpiry = instrument.book->nextExpiry();
+	if (nextExpiry != TIMESTAMP_INVALID) {
+		scheduleExpiryWakeup(instrument, nextExpiry);
+	}
+
+	dropTradeByOrderSubscriptions(instrument);
+}
+
+bool ExchangeAgent::insertSorted(std::vector<AgentHandle>& subscribers, AgentHandle subscriber) {
+	auto iit = std::lower_bound(subscribers.begin(), subscribers.end(), subscriber);
+	if (iit != subscribers.end() && *iit == subscriber) {
+		return false;
+	}
+	subscribers.insert(iit, subscriber);
+	return true;
+}
+
+void ExchangeAgent::subscribe(TopicID topic, const MessagePtr& msg, const std::string& events) {
+	auto pptr = std::dynamic_pointer_cast<SubscribeEventPayload>(msg->payload);
+	const bool conflate = pptr != nullptr && pptr->conflate;
+
+	const AgentHandle subscriber = simulation()->findAgentHandle(msg->source);
+	if (subscriber == AGENTHANDLE_INVALID) {
+		auto eretpptr = std::make_shared<ErrorResponsePayload>("Only agents can subscribe to " + events + ": " + msg->source);
+		fastRespondToMessage(msg, eretpptr);
+	} else if (!simulation()->subscribeToTopic(topic, subscriber, conflate)) {
+		auto eretpptr = std::make_shared<ErrorResponsePayload>("The agent is already subscribed to " + events + ": " + msg->source);
+		fastRespondToMessage(msg, eretpptr);
+	} else {
+		auto sretpptr = std::make_shared<SuccessResponsePayload>("Agent subscribed successfully to " + events + ": " + msg->source);
+		fastRespondToMessage(msg, sretpptr);
+	}
 }
 
 #include "PriceTimeBook.h"
@@ -189,25 +326,37 @@ void ExchangeAgent::configure(const pugi::xml_node& node, const std::string& con
 	pugi::xml_attribute att;
 	if (!(att = node.attribute("algorithm")).empty()) {
 		std::string algorithm = simulation()->parameters().processString(att.as_string());
-		std::function<void(TradePtr)> loggingCallbackBound = std::bind(&ExchangeAgent::notifyTradeSubscribers, this, std::placeholders::_1);
-		
+		if (algorithm != "PriceTime" && algorithm != "PureProRata" && algorithm != "PriorityProRata" && algorithm != "TimeProRata") {
+			throw SimulationException("ExchangeAgent::configure(): unknown algorithm '" + algorithm + "'");
+		}
+
+		// one order id space across the instruments, so that an order id names a single order of the exchange
 		auto orderFactoryPtr = std::make_shared<OrderFactory>();
 		auto tradeFactoryPtr = std::make_shared<TradeFactory>();
-		if (algorithm == "PriceTime") {
-			m_bookPtr = std::make_shared<PriceTimeBook>(orderFactoryPtr, tradeFactoryPtr);
-			m_bookPtr->registerTradeLoggingCallback(loggingCallbackBound);
-		} else if (algorithm == "PureProRata") {
-			m_bookPtr = std::make_shared<PureProRataBook>(orderFactoryPtr, tradeFactoryPtr);
-			m_bookPtr->registerTradeLoggingCallback(loggingCallbackBound);
-		} else if (algorithm == "PriorityProRata") {
-			m_bookPtr = std::make_shared<PriorityProRataBook>(orderFactoryPtr, tradeFactoryPtr);
-			m_bookPtr->registerTradeLoggingCallback(loggingCallbackBound);
-		} else if (algorithm == "TimeProRata") {
-			m_bookPtr = std::make_shared<TimeProRataBook>(orderFactoryPtr, tradeFactoryPtr);
-			m_bookPtr->registerTradeLoggingCallback(loggingCallbackBound);
-		} else {
-			throw SimulationException("ExchangeAgent::configure(): unknown algorithm '" + algorithm + "'");
+		m_bookFactory = [algorithm, orderFactoryPtr, tradeFactoryPtr]() -> BookPtr {
+			if (algorithm == "PriceTime") {
+				return std::make_shared<PriceTimeBook>(orderFactoryPtr, tradeFactoryPtr);
+			} else if (algorithm == "PureProRata") {
+				return std::make_shared<PureProRataBook>(orderFactoryPtr, tradeFactoryPtr);
+			} else if (algorithm == "PriorityProRata") {
+				return std::make_shared<PriorityProRataBook>(orderFactoryPtr, tradeFactoryPtr);
+			} else {
+				return std::make_shared<TimeProRataBook>(orderFactoryPtr, tradeFactoryPtr);
+			}
+		};
+
+		m_instruments.clear();
+		m_instruments.resize(1);
+		addInstrument(0, m_bookFactory());
+	}
+
+	if (!(att = node.attribute("symbols")).empty()) {
+		const unsigned long symbolCount = std::stoul(simulation()->parameters().processString(att.as_string()));
+		if (!m_bookFactory || symbolCount == 0) {
+			throw SimulationException("ExchangeAgent::configure(): '" + name() + "' needs an algorithm and at least one symbol");
 		}
+		// the instruments beyond the first are allocated on their first request
+		m_instruments.resize(symbolCount);
 	}
 
 	if (!(att = node.attribute("processingDelay")).empty()) {
@@ -216,42 +365,235 @@ void ExchangeAgent::configure(const pugi::xml_node& node, const std::string& con
 	}
 }
 
-void ExchangeAgent::notifyMarketOrderSubscribers(MarketOrderPtr ptr) {
-	auto currentTimestamp = simulation()->currentTimestamp();
-	for(const std::string& subscriber : m_marketOrderSubscribers) {
-		auto pptr = std::make_shared<EventOrderMarketPayload>(*ptr);
-		simulation()->dispatchMessage(currentTimestamp, m_processingDelay, name(), subscriber, "EVENT_ORDER_MARKET", pptr);
+void ExchangeAgent::notifyMarketOrderSubscribers(Instrument& instrument, MarketOrderPtr ptr) {
+	if (!simulation()->topic(instrument.marketOrderTopic).subscribers.empty()) {
+		auto pptr = std::make_shared<EventOrderMarketPayload>(*ptr, instrument.symbol);
+		simulation()->publish(simulation()->currentTimestamp(), m_processingDelay, name(), instrument.marketOrderTopic, "EVENT_ORDER_MARKET", pptr);
 	}
 }
 
-void ExchangeAgent::notifyLimitOrderSubscribers(LimitOrderPtr ptr) {
-	auto currentTimestamp = simulation()->currentTimestamp();
-	for (const std::string& subscriber : m_limitOrderSubscribers) {
-		auto pptr = std::make_shared<EventOrderLimitPayload>(*ptr);
-		simulation()->dispatchMessage(currentTimestamp, m_processingDelay, name(), subscriber, "EVENT_ORDER_LIMIT", pptr);
+void ExchangeAgent::notifyLimitOrderSubscribers(Instrument& instrument, LimitOrderPtr ptr) {
+	if (!simulation()->topic(instrument.limitOrderTopic).subscribers.empty()) {
+		auto pptr = std::make_shared<EventOrderLimitPayload>(*ptr, instrument.symbol);
+		simulation()->publish(simulation()->currentTimestamp(), m_processingDelay, name(), instrument.limitOrderTopic, "EVENT_ORDER_LIMIT", pptr);
 	}
 }
 
-void ExchangeAgent::notifyTradeSubscribers(TradePtr tradePtr) {
+void ExchangeAgent::notifyTradeSubscribers(Instrument& instrument, TradePtr tradePtr) {
 	const auto currentTimestamp = simulation()->currentTimestamp();
 	tradePtr->setTimestamp(currentTimestamp); // the trade happens exactly on the receipt of the aggressing order, no processing delay there; the processing delay only kicks in sending out a response and events related to the matching
 
-	for (const std::string& subscriber : m_tradeSubscribers) {
-		auto pptr = std::make_shared<EventTradePayload>(*tradePtr);
+	addFilledVolume(tradePtr->aggressingOrderID(), tradePtr->volume());
+	addFilledVolume(tradePtr->restingOrderID(), tradePtr->volume());
+
+	if (!instrument.stopOrders.empty()) {
+		const Money& price = tradePtr->price();
+		if (!instrument.hasTradedSinceStopScan) {
+			instrument.hasTradedSinceStopScan = true;
+			instrument.lowestTradePrice = price;
+			instrument.highestTradePrice = price;
+		} else if (price < instrument.lowestTradePrice) {
+			instrument.lowestTradePrice = price;
+		} else if (price > instrument.highestTradePrice) {
+			instrument.highestTradePrice = price;
+		}
+	}
+
+	if (!simulation()->topic(instrument.tradeTopic).subscribers.empty()) {
+		auto pptr = std::make_shared<EventTradePayload>(*tradePtr, instrument.symbol);
+		simulation()->publish(currentTimestamp, m_processingDelay, name(), instrument.tradeTopic, "EVENT_TRADE", pptr);
+	}
+
+	notifyTradeSubscribersByOrderID(instrument, tradePtr);
+}
+
+void ExchangeAgent::addFilledVolume(OrderID id, Volume volume) {
+	if (id >= m_filledVolumes.size()) {
+		// the ids are handed out in sequence, grow ahead of them
+		m_filledVolumes.resize(std::max<size_t>(id + 1, 2 * m_filledVolumes.size()), 0);
+	}
+	m_filledVolumes[id] += volume;
+}
+
+void ExchangeAgent::notifyTradeSubscribersByOrderID(Instrument& instrument, TradePtr tradePtr) {
+	if (m_tradeByOrderSubscribers.empty()) {
+		return;
+	}
+
+	static const std::vector<AgentHandle> none;
+	auto aggressingIt = m_tradeByOrderSubscribers.find(tradePtr->aggressingOrderID());
+	auto restingIt = m_tradeByOrderSubscribers.find(tradePtr->restingOrderID());
+	const auto& aggressingSubscribers = aggressingIt != m_tradeByOrderSubscribers.end() ? aggressingIt->second : none;
+	const auto& restingSubscribers = restingIt != m_tradeByOrderSubscribers.end() ? restingIt->second : none;
+
+	// an agent subscribed to both orders of the trade, e.g. trading with itself, gets the trade once
+	const auto currentTimestamp = simulation()->currentTimestamp();
+	auto aggressingSubscriberIt = aggressingSubscribers.begin();
+	auto restingSubscriberIt = restingSubscribers.begin();
+	while (aggressingSubscriberIt != aggressingSubscribers.end() || restingSubscriberIt != restingSubscribers.end()) {
+		AgentHandle subscriber;
+		if (restingSubscriberIt == restingSubscribers.end() || (aggressingSubscriberIt != aggressingSubscribers.end() && *aggressingSubscriberIt < *restingSubscriberIt)) {
+			subscriber = *aggressingSubscriberIt++;
+		} else {
+			subscriber = *restingSubscriberIt++;
+			if (aggressingSubscriberIt != aggressingSubscribers.end() && *aggressingSubscriberIt == subscriber) {
+				++aggressingSubscriberIt;
+			}
+		}
+
+		auto pptr = std::make_shared<EventTradePayload>(*tradePtr, instrument.symbol);
 		simulation()->dispatchMessage(currentTimestamp, m_processingDelay, name(), subscriber, "EVENT_TRADE", pptr);
 	}
+}
+
+void ExchangeAgent::endOfTimestamp() {
+	for (Instrument* instrument : m_bookDeltaPublishingDeferred) {
+		instrument->isBookDeltaPublishingDeferred = false;
+		notifyBookDeltaSubscribers(*instrument);
+
+		// the snapshot already contains this timestamp's deltas: the batch just published only goes to the subscribers from
+		// before, the new ones' feed starts with the next timestamp's batch, which arrives after the snapshot
+		for (AgentHandle subscriber : instrument->newBookDeltaSubscribers) {
+			sendBookDeltaSnapshot(*instrument, subscriber);
+			simulation()->subscribeToTopic(instrument->bookDeltaTopic, subscriber);
+		}
+		instrument->newBookDeltaSubscribers.clear();
+	}
+	m_bookDeltaPublishingDeferred.clear();
+}
+
+void ExchangeAgent::printState() const {
+	size_t marketOrderSubscriberCount = 0, limitOrderSubscriberCount = 0, tradeSubscriberCount = 0, bookDeltaSubscriberCount = 0, stopOrderCount = 0;
+	std::vector<const Instrument*> allocatedInstruments;
+	for (const auto& instrument : m_instruments) {
+		if (instrument != nullptr) {
+			marketOrderSubscriberCount += simulation()->topic(instrument->marketOrderTopic).subscribers.size();
+			limitOrderSubscriberCount += simulation()->topic(instrument->limitOrderTopic).subscribers.size();
+			tradeSubscriberCount += simulation()->topic(instrument->tradeTopic).subscribers.size();
+			bookDeltaSubscriberCount += simulation()->topic(instrument->bookDeltaTopic).subscribers.size() + instrument->newBookDeltaSubscribers.size();
+			stopOrderCount += instrument->stopOrders.size();
+			allocatedInstruments.push_back(instrument.get());
+		}
+	}
+
+	std::cout << "\tprocessing delay: " << m_processingDelay << std::endl;
+	std::cout << "\tsubscribers: " << marketOrderSubscriberCount << " market order, " << limitOrderSubscriberCount << " limit order, "
+		<< tradeSubscriberCount << " trade, " << m_tradeByOrderSubscribers.size() << " orders with trade, "
+		<< bookDeltaSubscriberCount << " book delta" << std::endl;
+	std::cout << "\tstop orders: " << stopOrderCount << " pending" << std::endl;
+	if (m_instruments.size() > 1) {
+		std::cout << "\tinstruments: " << allocatedInstruments.size() << " of " << m_instruments.size() << " symbols in use" << std::endl;
+	}
+	for (const Instrument* instrument : allocatedInstruments) {
+		const BookPtr& bookPtr = instrument->book;
+		std::cout << "\tbook";
+		if (m_instruments.size() > 1) {
+			std::cout << " " << instrument->symbol;
+		}
+		std::cout << ": " << bookPtr->buyQueue().size() << " bid levels, " << bookPtr->sellQueue().size() << " ask levels, "
+			<< bookPtr->deltaSequence() << " deltas so far" << std::endl;
+		// the books themselves only for a single instrument, there may be thousands of them
+		if (m_instruments.size() == 1) {
+			bookPtr->printHuman(1);
+		}
+	}
+}
+
+void ExchangeAgent::collectBookDelta(Instrument& instrument, const BookDelta& delta) {
+	if (delta.remainingVolume == 0 && delta.type != BookDeltaType::LevelDelete && m_tradeByOrderSubscribers.count(delta.orderId) > 0) {
+		m_ordersLeavingBook.push_back(delta.orderId);
+	}
+
+	if (!simulation()->topic(instrument.bookDeltaTopic).subscribers.empty()) {
+		instrument.pendingBookDeltas.push_back(delta);
+		deferBookDeltaPublishing(instrument);
+	}
+}
+
+void ExchangeAgent::deferBookDeltaPublishing(Instrument& instrument) {
+	if (!instrument.isBookDeltaPublishingDeferred) {
+		if (m_bookDeltaPublishingDeferred.empty()) {
+			simulation()->deferToEndOfTimestamp(this);
+		}
+		m_bookDeltaPublishingDeferred.push_back(&instrument);
+		instrument.isBookDeltaPublishingDeferred = true;
+	}
+}
+
+void ExchangeAgent::notifyBookDeltaSubscribers(Instrument& instrument) {
+	if (instrument.pendingBookDeltas.empty()) {
+		return;
+	}
 
-	notifyTradeSubscribersByOrderID(tradePtr, tradePtr->aggressingOrderID());
-	notifyTradeSubscribersByOrderID(tradePtr, tradePtr->restingOrderID());
+	auto pptr = std::make_shared<EventBookDeltaPayload>(instrument.pendingBookDeltas, instrument.symbol);
+	simulation()->publish(simulation()->currentTimestamp(), m_processingDelay, name(), instrument.bookDeltaTopic, "EVENT_BOOK_DELTA", pptr);
+	instrument.pendingBookDeltas.clear();
 }
 
-void ExchangeAgent::notifyTradeSubscribersByOrderID(TradePtr tradePtr, OrderID orderId) {
+void ExchangeAgent::sendBookDeltaSnapshot(Instrument& instrument, AgentHandle subscriber) {
+	// the resting orders as Add deltas in time priority, all carrying the sequence number of the last delta they include
+	std::vector<BookDelta> snapshot;
+	const BookPtr& bookPtr = instrument.book;
+	const uint64_t sequence = bookPtr->deltaSequence();
+	for (const auto* queue : { &bookPtr->buyQueue(), &bookPtr->sellQueue() }) {
+		for (const TickContainer& level : *queue) {
+			for (const LimitOrderPtr& order : level) {
+				if (order->volume() > 0) {
+					snapshot.push_back(BookDelta{ sequence, BookDeltaType::Add, order->id(), order->direction(), level.price(), order->volume(), order->volume() });
+				}
+			}
+		}
+	}
+
 	const auto currentTimestamp = simulation()->currentTimestamp();
-	if (m_tradeByOrderSubscribers.count(orderId) > 0) {
-		const auto& subscribers = m_tradeByOrderSubscribers[orderId];
-		for (const std::string& subscriber : subscribers) {
-			auto pptr = std::make_shared<EventTradePayload>(*tradePtr);
-			simulation()->dispatchMessage(currentTimestamp, m_processingDelay, name(), subscriber, "EVENT_TRADE", pptr);
+	simulation()->dispatchMessage(currentTimestamp, m_processingDelay, name(), subscriber, "EVENT_BOOK_DELTA", std::make_shared<EventBookDeltaPayload>(snapshot, instrument.symbol));
+}
+
+void ExchangeAgent::releaseTriggeredStopOrders(Instrument& instrument) {
+	// the triggered orders may trade and trigger further stop orders, the cascade goes on in rounds until it stops
+	const BookPtr& bookPtr = instrument.book;
+	std::vector<StopOrder> triggered;
+	while (instrument.hasTradedSinceStopScan) {
+		instrument.hasTradedSinceStopScan = false;
+		triggered.clear();
+		instrument.stopOrders.collectTriggered(instrument.lowestTradePrice, instrument.highestTradePrice, triggered);
+
+		const auto currentTimestamp = simulation()->currentTimestamp();
+		for (const StopOrder& stopOrder : triggered) {
+			OrderID orderId;
+			if (stopOrder.isLimit) {
+				auto lop = bookPtr->placeLimitOrder(stopOrder.direction, currentTimestamp, stopOrder.volume, stopOrder.limitPrice);
+				orderId = lop->id();
+				notifyLimitOrderSubscribers(instrument, lop);
+			} else {
+				auto mop = bookPtr->placeMarketOrder(stopOrder.direction, currentTimestamp, stopOrder.volume);
+				orderId = mop->id();
+				notifyMarketOrderSubscribers(instrument, mop);
+			}
+
+			auto pptr = std::make_shared<EventStopOrderTriggeredPayload>(stopOrder.id, orderId, instrument.symbol);
+			simulation()->dispatchMessage(currentTimestamp, m_processingDelay, name(), stopOrder.owner, "EVENT_STOP_ORDER_TRIGGERED", pptr);
 		}
 	}
 }
+
+void ExchangeAgent::dropTradeByOrderSubscriptions(Instrument& instrument) {
+	// an iceberg refilled or an order moved by a replacement is back in the book and keeps its subscribers
+	for (OrderID id : m_ordersLeavingBook) {
+		LimitOrderPtr lop;
+		if (!instrument.book->tryGetOrder(id, lop) || lop->volume() + lop->hiddenVolume() == 0) {
+			m_tradeByOrderSubscribers.erase(id);
+		}
+	}
+	m_ordersLeavingBook.clear();
+}
+
+void ExchangeAgent::scheduleExpiryWakeup(Instrument& instrument, Timestamp expiry) {
+	// a later expiry is scheduled by the earlier wakeup when it comes
+	if (!instrument.expiryWakeups.empty() && *instrument.expiryWakeups.begin() <= expiry) {
+		return;
+	}
+
+	instrument.expiryWakeups.insert(expiry);
+	simulation()->scheduleWakeup(this, expiry, (WakeupTag)instrument.symbol);
+}
@@ -2,9 +2,14 @@
 
 #include "Agent.h"
 #include "Book.h"
+#include "StopOrderIndex.h"
+#include "SubscriberSet.h"
 
-#include <list>
-#include <map>
+#include <functional>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 class ExchangeAgent : public Agent {
 public:
@@ -13,21 +18,80 @@ public:
 	virtual ~ExchangeAgent() = default;
 
 	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
+	void endOfTimestamp() override;
+	void printState() const override;
 
 	Timestamp processingDelay() const { return m_processingDelay; }
+	SymbolID symbolCount() const { return (SymbolID)m_instruments.size(); }
+	// for in-process observers of the book, e.g. DepthSnapshotAgent; nullptr until the instrument is first used
+	BookPtr book(SymbolID symbol = 0) const;
+	// likewise, allocating the instrument of a hosted symbol not used yet so that it can be observed from the start;
+	// nullptr if the exchange does not host the symbol
+	BookPtr hostedBook(SymbolID symbol);
 
 	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
 private:
+	// The book of one instrument and everything the exchange keeps per instrument
+	struct Instrument {
+		SymbolID symbol;
+		BookPtr book;
+
+		// the event feeds of the instrument, published on the simulation's topics
+		TopicID marketOrderTopic;
+		TopicID limitOrderTopic;
+		TopicID tradeTopic;
+		TopicID bookDeltaTopic;
+		// subscribed during the current timestamp, they get a snapshot of the book at its end instead of its deltas
+		SubscriberSet newBookDeltaSubscribers;
+		// the deltas of the current timestamp, published in one batch at its end so that the batches arrive in sequence order
+		std::vector<BookDelta> pendingBookDeltas;
+		bool isBookDeltaPublishingDeferred;
+		// the times of the expiry wakeups pending, one is enough for any number of GTD orders expiring together
+		std::set<Timestamp> expiryWakeups;
+
+		StopOrderIndex stopOrders;
+		// the range of the prices traded at since the stop orders were last checked
+		bool hasTradedSinceStopScan;
+		Money lowestTradePrice;
+		Money highestTradePrice;
+
+		Instrument(SymbolID symbol, const BookPtr& book);
+	};
+
 	Timestamp m_processingDelay;
-	BookPtr m_bookPtr;
+	// indexed by symbol, an instrument is allocated on its first request; symbol 0 is there from the start
+	std::vector<std::unique_ptr<Instrument>> m_instruments;
+	// makes the books of the instruments allocated later, all sharing the order ids of the first one
+	std::function<BookPtr()> m_bookFactory;
+	// the instruments with book delta events to publish at the end of the current timestamp
+	std::vector<Instrument*> m_bookDeltaPublishingDeferred;
+
+	// per order, until the order has left the book for good
+	std::unordered_map<OrderID, std::vector<AgentHandle>> m_tradeByOrderSubscribers;
+	// the orders with subscribers that a fill or cancellation of the current message took out of the book
+	std::vector<OrderID> m_ordersLeavingBook;
+	// what each order has traded so far, indexed by id; the ids are shared by the books of all the instruments
+	std::vector<Volume> m_filledVolumes;
 
-	std::list<std::string> m_marketOrderSubscribers;
-	std::list<std::string> m_limitOrderSubscribers;
-	std::list<std::string> m_tradeSubscribers;
-	std::map<OrderID, std::vector<std::string>> m_tradeByOrderSubscribers;
+	Instrument& instrument(SymbolID symbol);
+	Instrument& addInstrument(SymbolID symbol, const BookPtr& bookPtr);
+	void subscribe(TopicID topic, const MessagePtr& msg, const std::string& events);
+	// false if the subscriber is there already
+	static bool insertSorted(std::vector<AgentHandle>& subscribers, AgentHandle subscriber);
 
-	void notifyMarketOrderSubscribers(MarketOrderPtr ptr);
-	void notifyLimitOrderSubscribers(LimitOrderPtr ptr);
-	void notifyTradeSubscribers(TradePtr tradePtr);
-	void notifyTradeSubscribersByOrderID(TradePtr tradePtr, OrderID orderId);
+	void notifyMarketOrderSubscribers(Instrument& instrument, MarketOrderPtr ptr);
+	void notifyLimitOrderSubscribers(Instrument& instrument, LimitOrderPtr ptr);
+	void notifyTradeSubscribers(Instrument& instrument, TradePtr tradePtr);
+	void notifyTradeSubscribersByOrderID(Instrument& instrument, TradePtr tradePtr);
+	void addFilledVolume(OrderID id, Volume volume);
+	// 0 for an order that has not traded, or is not known
+	Volume filledVolume(OrderID id) const { return id < m_filledVolumes.size() ? m_filledVolumes[id] : 0; }
+	void collectBookDelta(Instrument& instrument, const BookDelta& delta);
+	void deferBookDeltaPublishing(Instrument& instrument);
+	void notifyBookDeltaSubscribers(Instrument& instrument);
+	void sendBookDeltaSnapshot(Instrument& instrument, AgentHandle subscriber);
+	void dropTradeByOrderSubscriptions(Instrument& instrument);
+	void scheduleExpiryWakeup(Instrument& instrument, Timestamp expiry);
+	void releaseTriggeredStopOrders(Instrument& instrument);
 };
@@ -9,7 +9,15 @@
 #include <vector>
 #include <string>
 
-struct PlaceOrderMarketPayload : public MessagePayload {
+// A request about one instrument of an exchange, or an event of one; the exchange takes the requests of any other payload
+// type to be about symbol 0
+struct InstrumentPayload : public MessagePayload {
+	SymbolID symbol;
+
+	InstrumentPayload(SymbolID symbol = 0) : symbol(symbol) { }
+};
+
+struct PlaceOrderMarketPayload : public InstrumentPayload {
 	OrderDirection direction;
 	Volume volume;
 
@@ -19,28 +27,103 @@ struct PlaceOrderMarketPayload : public MessagePayload {
 struct PlaceOrderMarketResponsePayload : public MessagePayload {
 	OrderID id;
 	std::shared_ptr<PlaceOrderMarketPayload> requestPayload;
+	// what of the order traded; a market order never rests, what the book could not match is dropped
+	Volume filledVolume;
 
-	PlaceOrderMarketResponsePayload(OrderID id, const std::shared_ptr<PlaceOrderMarketPayload>& requestPayload)
-		: id(id), requestPayload(requestPayload) { }
+	PlaceOrderMarketResponsePayload(OrderID id, const std::shared_ptr<PlaceOrderMarketPayload>& requestPayload, Volume filledVolume)
+		: id(id), requestPayload(requestPayload), filledVolume(filledVolume) { }
 };
 
-struct PlaceOrderLimitPayload : public MessagePayload {
+struct PlaceOrderLimitPayload : public InstrumentPayload {
 	OrderDirection direction;
 	Volume volume;
 	Money price;
-
-	PlaceOrderLimitPayload(OrderDirection direction, Volume volume, Money price) : direction(direction), volume(volume), price(price) { }
+	TimeInForce timeInForce;
+	// GTD only, the exchange cancels the order at this time
+	Timestamp expiry;
+	// if not 0, what rests of the order is an iceberg showing at most this much of its volume at a time
+	Volume displayVolume;
+
+	PlaceOrderLimitPayload(OrderDirection direction, Volume volume, Money price)
+		: direction(direction), volume(volume), price(price), timeInForce(TimeInForce::GTC), expiry(TIMESTAMP_INVALID), displayVolume(0) { }
+	PlaceOrderLimitPayload(OrderDirection direction, Volume volume, Money price, TimeInForce timeInForce, Timestamp expiry = TIMESTAMP_INVALID)
+		: direction(direction), volume(volume), price(price), timeInForce(timeInForce), expiry(expiry), displayVolume(0) { }
 };
 
 struct PlaceOrderLimitResponsePayload : public MessagePayload {
 	OrderID id;
 	std::shared_ptr<PlaceOrderLimitPayload> requestPayload;
+	// what of the order traded on its arrival; what is left rests, or is dropped for IOC and FOK orders
+	Volume filledVolume;
+
+	PlaceOrderLimitResponsePayload(OrderID id, const std::shared_ptr<PlaceOrderLimitPayload>& requestPayload, Volume filledVolume)
+		: id(id), requestPayload(requestPayload), filledVolume(filledVolume) { }
+};
+
+// One order of a PLACE_ORDERS request, a market order unless it has a price; a limit order takes the time in force,
+// expiry and display volume of PLACE_ORDER_LIMIT, with the same defaults
+struct PlaceOrdersOrder {
+	bool isMarket;
+	OrderDirection direction;
+	Volume volume;
+	Money price;
+	TimeInForce timeInForce;
+	Timestamp expiry;
+	Volume displayVolume;
+
+	PlaceOrdersOrder(OrderDirection direction, Volume volume)
+		: isMarket(true), direction(direction), volume(volume), price(0), timeInForce(TimeInForce::GTC), expiry(TIMESTAMP_INVALID), displayVolume(0) { }
+	PlaceOrdersOrder(OrderDirection direction, Volume volume, Money price)
+		: isMarket(false), direction(direction), volume(volume), price(price), timeInForce(TimeInForce::GTC), expiry(TIMESTAMP_INVALID), displayVolume(0) { }
+	PlaceOrdersOrder(OrderDirection direction, Volume volume, Money price, TimeInForce timeInForce, Timestamp expiry = TIMESTAMP_INVALID)
+		: isMarket(false), direction(direction), volume(volume), price(price), timeInForce(timeInForce), expiry(expiry), displayVolume(0) { }
+};
 
-	PlaceOrderLimitResponsePayload(OrderID id, const std::shared_ptr<PlaceOrderLimitPayload>& requestPayload)
+// Any number of orders in one message, placed in the given order as if they had arrived one after the other
+struct PlaceOrdersPayload : public InstrumentPayload {
+	std::vector<PlaceOrdersOrder> orders;
+
+	PlaceOrdersPayload()
+		: orders() { }
+	PlaceOrdersPayload(const std::vector<PlaceOrdersOrder>& orders)
+		: orders(orders) { }
+};
+
+struct PlaceOrdersResponsePayload : public MessagePayload {
+	// the id of every order of the request, in the order of the request
+	std::vector<OrderID> ids;
+	// likewise, what of each order traded on its arrival; the later fills of a resting limit order are trade events
+	std::vector<Volume> filledVolumes;
+	std::shared_ptr<PlaceOrdersPayload> requestPayload;
+
+	PlaceOrdersResponsePayload(const std::shared_ptr<PlaceOrdersPayload>& requestPayload)
+		: ids(), filledVolumes(), requestPayload(requestPayload) { }
+};
+
+// A stop order, held by the exchange until a trade reaches the stop price (at or above it for a buy, at or below it for a
+// sell); it then enters the book as a market order, or with a limit price as a limit order. CANCEL_ORDERS cancels it.
+struct PlaceOrderStopPayload : public InstrumentPayload {
+	OrderDirection direction;
+	Volume volume;
+	Money stopPrice;
+	bool isLimit;
+	Money limitPrice;
+
+	PlaceOrderStopPayload(OrderDirection direction, Volume volume, Money stopPrice)
+		: direction(direction), volume(volume), stopPrice(stopPrice), isLimit(false), limitPrice(0) { }
+	PlaceOrderStopPayload(OrderDirection direction, Volume volume, Money stopPrice, Money limitPrice)
+		: direction(direction), volume(volume), stopPrice(stopPrice), isLimit(true), limitPrice(limitPrice) { }
+};
+
+struct PlaceOrderStopResponsePayload : public MessagePayload {
+	OrderID id;
+	std::shared_ptr<PlaceOrderStopPayload> requestPayload;
+
+	PlaceOrderStopResponsePayload(OrderID id, const std::shared_ptr<PlaceOrderStopPayload>& requestPayload)
 		: id(id), requestPayload(requestPayload) { }
 };
 
-struct RetrieveOrdersPayload : public MessagePayload {
+struct RetrieveOrdersPayload : public InstrumentPayload {
 	std::vector<OrderID> ids;
 
 	RetrieveOrdersPayload(const std::vector<OrderID>& ids)
@@ -60,7 +143,7 @@ struct CancelOrdersCancellation {
 	CancelOrdersCancellation(OrderID id, Volume volume) : id(id), volume(volume) { }
 };
 
-struct CancelOrdersPayload : public MessagePayload {
+struct CancelOrdersPayload : public InstrumentPayload {
 	std::vector<CancelOrdersCancellation> cancellations;
 
 	CancelOrdersPayload()
@@ -69,7 +152,25 @@ struct CancelOrdersPayload : public MessagePayload {
 		: cancellations(cancellations) { }
 };
 
-struct RetrieveBookPayload : public MessagePayload {
+struct ReplaceOrdersReplacement {
+	OrderID id;
+	Money price;
+	Volume volume;
+
+	ReplaceOrdersReplacement(OrderID id, Money price, Volume volume) : id(id), price(price), volume(volume) { }
+};
+
+// the response is a ReplaceOrdersPayload as well, with the resting volume of each order after its replacement
+struct ReplaceOrdersPayload : public InstrumentPayload {
+	std::vector<ReplaceOrdersReplacement> replacements;
+
+	ReplaceOrdersPayload()
+		: replacements() { }
+	ReplaceOrdersPayload(const std::vector<ReplaceOrdersReplacement>& replacements)
+		: replacements(replacements) { }
+};
+
+struct RetrieveBookPayload : public InstrumentPayload {
 	unsigned int depth;
 
 	RetrieveBookPayload(unsigned int _)
@@ -86,7 +187,9 @@ struct RetrieveBookResponsePayload : public MessagePayload {
 		: time(time), tickContainers(tickContainers) { }
 };
 
-struct RetrieveL1Payload : public MessagePayload { };
+struct RetrieveL1Payload : public InstrumentPayload {
+	RetrieveL1Payload(SymbolID symbol = 0) : InstrumentPayload(symbol) { }
+};
 
 struct RetrieveL1ResponsePayload : public MessagePayload {
 	Timestamp time;
@@ -103,26 +206,61 @@ struct RetrieveL1ResponsePayload : public MessagePayload {
 		: time(time), bestAskPrice(bestAskPrice), bestAskVolume(bestAskVolume), askTotalVolume(askTotalVolume), bestBidPrice(bestBidPrice), bestBidVolume(bestBidVolume), bidTotalVolume(bidTotalVolume) { }
 };
 
-struct SubscribeEventTradeByOrderPayload : public MessagePayload {
+// SUBSCRIBE_EVENT_ORDER_MARKET, SUBSCRIBE_EVENT_ORDER_LIMIT and SUBSCRIBE_EVENT_TRADE of an instrument; a conflating
+// subscriber has one event on its way at a time, the next one it gets is the latest of those published meanwhile
+struct SubscribeEventPayload : public InstrumentPayload {
+	bool conflate;
+
+	SubscribeEventPayload(SymbolID symbol = 0, bool conflate = false) : InstrumentPayload(symbol), conflate(conflate) { }
+};
+
+struct SubscribeEventTradeByOrderPayload : public InstrumentPayload {
 	OrderID id;
 
 	SubscribeEventTradeByOrderPayload(OrderID id) : id(id) { }
 };
 
-struct EventOrderMarketPayload : public MessagePayload {
+// The trades of the order from the subscription on are sent as events, those before it are only told by the volumes
+// below; an order that has left the book already will not trade again, there is no subscription then
+struct SubscribeEventTradeByOrderResponsePayload : public MessagePayload {
+	// what rests of the order in the book, hidden volume included; 0 if it has left the book
+	Volume restingVolume;
+	// what the order has traded until the subscription; what it placed less both was cancelled, expired or dropped
+	Volume filledVolume;
+	std::shared_ptr<SubscribeEventTradeByOrderPayload> requestPayload;
+
+	SubscribeEventTradeByOrderResponsePayload(Volume restingVolume, Volume filledVolume, const std::shared_ptr<SubscribeEventTradeByOrderPayload>& requestPayload)
+		: restingVolume(restingVolume), filledVolume(filledVolume), requestPayload(requestPayload) { }
+};
+
+struct EventOrderMarketPayload : public InstrumentPayload {
 	MarketOrder order;
 
-	EventOrderMarketPayload(const MarketOrder& order) : order(order) { }
+	EventOrderMarketPayload(const MarketOrder& order, SymbolID symbol = 0) : InstrumentPayload(symbol), order(order) { }
 };
 
-struct EventOrderLimitPayload : public MessagePayload {
+struct EventOrderLimitPayload : public InstrumentPayload {
 	LimitOrder order;
 
-	EventOrderLimitPayload(const LimitOrder& order) : order(order) { }
+	EventOrderLimitPayload(const LimitOrder& order, SymbolID symbol = 0) : InstrumentPayload(symbol), order(order) { }
 };
 
-struct EventTradePayload : public MessagePayload {
+struct EventTradePayload : public InstrumentPayload {
 	Trade trade;
 
-	EventTradePayload(const Trade& trade) : trade(trade) { }
-};
\ No newline at end of file
+	EventTradePayload(const Trade& trade, SymbolID symbol = 0) : InstrumentPayload(symbol), trade(trade) { }
+};
+
+// sent to the owner of a stop order when it is triggered, orderId is the market or limit order it has become
+struct EventStopOrderTriggeredPayload : public InstrumentPayload {
+	OrderID stopOrderId;
+	OrderID orderId;
+
+	EventStopOrderTriggeredPayload(OrderID stopOrderId, OrderID orderId, SymbolID symbol = 0) : InstrumentPayload(symbol), stopOrderId(stopOrderId), orderId(orderId) { }
+};
+
+struct EventBookDeltaPayload : public InstrumentPayload {
+	std::vector<BookDelta> deltas;
+
+	EventBookDeltaPayload(const std::vector<BookDelta>& deltas, SymbolID symbol = 0) : InstrumentPayload(symbol), deltas(deltas) { }
+};
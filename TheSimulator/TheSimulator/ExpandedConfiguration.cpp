@@ -0,0 +1,157 @@
+#include "ExpandedConfiguration.h"
+
+#include "AgentFactory.h"
+#include "ParameterStorage.h"
+#include "SimulationException.h"
+
+#include <algorithm>
+
+// set anew for every branch of a run after its agents are configured, the agents keeping a template (e.g. of an output
+// path) resolve these again
+static bool isBoundLate(const std::string& value) {
+	return value.find("${runIndex}") != std::string::npos || value.find("${branchIndex}") != std::string::npos;
+}
+
+ExpandedConfiguration::ExpandedConfiguration()
+	: m_hasStartTimestamp(false), m_startTimestamp(0), m_hasDuration(false), m_duration(0) { }
+
+void ExpandedConfiguration::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	pugi::xml_attribute att;
+	if ((m_hasStartTimestamp = !(att = node.attribute("start")).empty())) {
+		m_startTimestamp = (Timestamp)att.as_ullong();
+	}
+
+	if ((m_hasDuration = !(att = node.attribute("duration")).empty())) {
+		m_duration = (Timestamp)att.as_ullong();
+	}
+
+	m_entries.clear();
+	m_latency = pugi::xml_node();
+	flatten(node, configurationPath);
+
+	for (AgentNodeEntry& entry : m_entries) {
+		if (!collectReferences(entry.node, entry.references)) {
+			entry.references.clear();
+		}
+	}
+	std::lock_guard<std::mutex> lock(m_resolvedNodesMutex);
+	m_resolvedNodes.assign(m_entries.size(), {});
+}
+
+pugi::xml_node ExpandedConfiguration::resolvedNode(size_t entryIndex, ParameterStorage& parameters, std::shared_ptr<const pugi::xml_document>& holder) const {
+	const AgentNodeEntry& entry = m_entries[entryIndex];
+	if (entry.references.empty()) {
+		return entry.node;
+	}
+
+	std::string key;
+	for (const std::string& reference : entry.references) {
+		const std::string* value = parameters.find(reference);
+		if (value == nullptr) {
+			return entry.node;
+		}
+		key.append(*value).push_back('\0');
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_resolvedNodesMutex);
+		auto it = m_resolvedNodes[entryIndex].find(key);
+		if (it != m_resolvedNodes[entryIndex].end()) {
+			holder = it->second;
+			return holder->first_child();
+		}
+	}
+
+	// resolved outside the lock, two runs meeting the same values at once resolve the same copy
+	auto documentPtr = std::make_shared<pugi::xml_document>();
+	pugi::xml_node copy = documentPtr->append_copy(entry.node);
+	std::vector<pugi::xml_node> pending{ copy };
+	while (!pending.empty()) {
+		pugi::xml_node node = pending.back();
+		pending.pop_back();
+		for (pugi::xml_attribute att : node.attributes()) {
+			if (isBoundLate(att.as_string())) {
+				continue;
+			}
+			const std::string value = parameters.processString(att.as_string());
+			// a parameter value with references of its own is left to the agent, as it would not resolve it again
+			if (value.find('$') == std::string::npos) {
+				att.set_value(value.c_str());
+			}
+		}
+		for (pugi::xml_node child : node.children()) {
+			if (child.type() == pugi::node_element) {
+				pending.push_back(child);
+			}
+		}
+	}
+
+	holder = documentPtr;
+	std::lock_guard<std::mutex> lock(m_resolvedNodesMutex);
+	auto& resolvedNodes = m_resolvedNodes[entryIndex];
+	if (resolvedNodes.size() >= MAX_RESOLVED_NODES) {
+		resolvedNodes.clear();
+	}
+	resolvedNodes.emplace(key, holder);
+	return holder->first_child();
+}
+
+bool ExpandedConfiguration::collectReferences(const pugi::xml_node& node, std::vector<std::string>& references) {
+	for (pugi::xml_attribute att : node.attributes()) {
+		const std::string value = att.as_string();
+		if (isBoundLate(value)) {
+			continue;
+		}
+		for (size_t start = value.find("${"); start != std::string::npos; start = value.find("${", start)) {
+			const size_t end = value.find('}', start + 2);
+			if (end == std::string::npos) {
+				return false;
+			}
+			std::string reference = value.substr(start + 2, end - start - 2);
+			if (std::find(references.begin(), references.end(), reference) == references.end()) {
+				references.push_back(std::move(reference));
+			}
+			start = end + 1;
+		}
+	}
+	for (pugi::xml_node child : node.children()) {
+		if (child.type() == pugi::node_element && !collectReferences(child, references)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ExpandedConfiguration::flatten(const pugi::xml_node& node, const std::string& configurationPath) {
+	const AgentFactory& agentFactory = AgentFactory::instance();
+
+	for (pugi::xml_node_iterator nit = node.begin(); nit != node.end(); ++nit) {
+		if (nit->type() != pugi::node_element) {
+			continue;
+		}
+
+		const std::string nodeName = nit->name();
+		if (nodeName == "Generator") {
+			pugi::xml_attribute att;
+			if (!(att = nit->attribute("count")).empty()) {
+				const ConfigurationIndex maxIndex = (ConfigurationIndex)att.as_uint();
+				for (ConfigurationIndex index = 1; index <= maxIndex; ++index) {
+					flatten(*nit, configurationPath + std::to_string(index));
+				}
+			}
+		} else if (nodeName == "Latency") {
+			if (!m_latency.empty()) {
+				throw SimulationException("ExpandedConfiguration::configure(): more than one <Latency> element");
+			}
+			m_latency = *nit;
+		} else if (agentFactory.isRegistered(nodeName)) {
+			m_entries.push_back(AgentNodeEntry{ nodeName, *nit, configurationPath, agentFactory.isClonable(nodeName) ? AgentNodeKind::Clonable : AgentNodeKind::Registered });
+		} else {
+#ifdef MAXE_WITH_PYTHON
+			m_entries.push_back(AgentNodeEntry{ nodeName, *nit, configurationPath, AgentNodeKind::Python });
+#else
+			throw SimulationException("ExpandedConfiguration::configure(): unrecognized node '" + nodeName + "', Python agents need a build with Python support");
+#endif
+		}
+	}
+}
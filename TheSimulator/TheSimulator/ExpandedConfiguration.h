@@ -0,0 +1,72 @@
+#pragma once
+
+#include "IConfigurable.h"
+#include "Timestamp.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ParameterStorage;
+
+enum class AgentNodeKind {
+	Registered, // created by the AgentFactory
+	Clonable,   // created by the AgentFactory, a population is copied from one configured prototype
+	Python      // a Python agent, only in builds with MAXE_WITH_PYTHON
+};
+
+struct AgentNodeEntry {
+	std::string nodeName;
+	pugi::xml_node node;
+	std::string configurationPath;
+	AgentNodeKind kind;
+	// the parameters the attributes of the node and its children reference, none if a reference is malformed
+	std::vector<std::string> references;
+};
+
+// The agent nodes of a <Simulation> element with every Generator expanded and every node name checked against the
+// AgentFactory, so that an unknown node fails before any run starts. The '${}' references of a node's attributes are
+// resolved once per combination of the values of the parameters they name, into a copy of the node the runs with those
+// values share: the agents' configure() then only meets plain values, though each agent still parses them itself. The
+// attributes naming ${runIndex} or ${branchIndex} are left as they are, a branch sets those after its agents are
+// configured. It is built once per configuration file and can be shared by all runs (and threads) as long as the
+// document outlives them.
+class ExpandedConfiguration : public IConfigurable {
+public:
+	ExpandedConfiguration();
+
+	// Inherited via IConfigurable
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	bool hasStartTimestamp() const { return m_hasStartTimestamp; }
+	Timestamp startTimestamp() const { return m_startTimestamp; }
+	bool hasDuration() const { return m_hasDuration; }
+	Timestamp duration() const { return m_duration; }
+
+	const std::vector<AgentNodeEntry>& entries() const { return m_entries; }
+	// the node of the entry with the references of its attributes resolved against the parameters, kept alive by holder;
+	// the node itself if it has no references or one of them is not set, its agent then resolves (or fails) as ever
+	pugi::xml_node resolvedNode(size_t entryIndex, ParameterStorage& parameters, std::shared_ptr<const pugi::xml_document>& holder) const;
+	// the <Latency> element of the simulation, empty if there is none
+	const pugi::xml_node& latency() const { return m_latency; }
+private:
+	bool m_hasStartTimestamp;
+	Timestamp m_startTimestamp;
+	bool m_hasDuration;
+	Timestamp m_duration;
+
+	std::vector<AgentNodeEntry> m_entries;
+	pugi::xml_node m_latency;
+
+	// by entry, the resolved copies of its node by the values of its references joined; a sweep over many values only
+	// keeps the latest few
+	static constexpr size_t MAX_RESOLVED_NODES = 16;
+	mutable std::mutex m_resolvedNodesMutex;
+	mutable std::vector<std::unordered_map<std::string, std::shared_ptr<const pugi::xml_document>>> m_resolvedNodes;
+
+	void flatten(const pugi::xml_node& node, const std::string& configurationPath);
+	// false if a reference is malformed
+	static bool collectReferences(const pugi::xml_node& node, std::vector<std::string>& references);
+};
@@ -0,0 +1,76 @@
+#include "ExpiryWheel.h"
+
+#include <algorithm>
+#include <limits>
+
+ExpiryWheel::ExpiryWheel(size_t slotCount)
+	: m_slots(slotCount), m_now(0), m_size(0) { }
+
+void ExpiryWheel::add(Timestamp expiry, OrderID id) {
+	// an expiry that is already due is picked up by the next advance, from the slot visited first
+	const Timestamp slotTime = std::max(expiry, m_now + 1);
+	m_slots[slotTime % m_slots.size()].push_back(Entry{ expiry, id });
+	++m_size;
+}
+
+void ExpiryWheel::advance(Timestamp now, const std::function<void(OrderID)>& expire) {
+	if (now <= m_now) {
+		return;
+	}
+	if (m_size == 0) {
+		m_now = now;
+		return;
+	}
+
+	m_dueEntries.clear();
+	if (now - m_now >= m_slots.size()) {
+		for (auto& slot : m_slots) {
+			collectDue(slot, now);
+		}
+	} else {
+		for (Timestamp time = m_now + 1; time <= now; ++time) {
+			collectDue(m_slots[time % m_slots.size()], now);
+		}
+	}
+	m_now = now;
+
+	// equal expiries share a slot, so the stable sort keeps them in insertion order
+	std::stable_sort(m_dueEntries.begin(), m_dueEntries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return lhs.expiry < rhs.expiry;
+	});
+	for (const Entry& entry : m_dueEntries) {
+		expire(entry.id);
+	}
+}
+
+void ExpiryWheel::collectDue(std::vector<Entry>& slot, Timestamp now) {
+	auto firstLater = std::stable_partition(slot.begin(), slot.end(), [now](const Entry& entry) {
+		return entry.expiry <= now;
+	});
+	m_dueEntries.insert(m_dueEntries.end(), slot.begin(), firstLater);
+	m_size -= firstLater - slot.begin();
+	slot.erase(slot.begin(), firstLater);
+}
+
+Timestamp ExpiryWheel::nextExpiry() const {
+	if (m_size == 0) {
+		return TIMESTAMP_INVALID;
+	}
+
+	// one round ahead, a slot holds the expiries of its time and of later rounds
+	for (Timestamp time = m_now + 1; time <= m_now + m_slots.size(); ++time) {
+		for (const Entry& entry : m_slots[time % m_slots.size()]) {
+			if (entry.expiry <= time) {
+				return time;
+			}
+		}
+	}
+
+	Timestamp earliest = std::numeric_limits<Timestamp>::max();
+	for (const auto& slot : m_slots) {
+		for (const Entry& entry : slot) {
+			earliest = std::min(earliest, entry.expiry);
+		}
+	}
+	return earliest;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Timestamp.h"
+#include "Order.h"
+
+#include <functional>
+#include <vector>
+
+// The expiries of the GTD orders of a book, as a hashed timing wheel: slot (expiry % slot count) holds the orders expiring
+// at that time in any round of the wheel, so adding an expiry is O(1) and advancing the wheel only visits the slots of the
+// time that passed. The expiries of orders filled or cancelled before they are due stay in the wheel, the book ignores
+// them when they come up.
+class ExpiryWheel {
+public:
+	explicit ExpiryWheel(size_t slotCount = 1024);
+
+	bool empty() const { return m_size == 0; }
+	size_t size() const { return m_size; }
+
+	void add(Timestamp expiry, OrderID id);
+	// removes every expiry at or before now and calls expire for it, earliest first and in insertion order among equals
+	void advance(Timestamp now, const std::function<void(OrderID)>& expire);
+	// the earliest time at which advance() has something to expire, TIMESTAMP_INVALID if the wheel is empty
+	Timestamp nextExpiry() const;
+private:
+	struct Entry {
+		Timestamp expiry;
+		OrderID id;
+	};
+
+	std::vector<std::vector<Entry>> m_slots;
+	// everything at or before it has been expired
+	Timestamp m_now;
+	size_t m_size;
+
+	std::vector<Entry> m_dueEntries;
+
+	void collectDue(std::vector<Entry>& slot, Timestamp now);
+};
@@ -3,7 +3,8 @@
 #include "Simulation.h"
 
 void IMessageable::respondToMessage(const MessagePtr& msg, const std::string& type, MessagePayloadPtr payload, Timestamp processingDelay) const {
-	const Timestamp diff = msg->arrival - msg->occurrence;
+	// the way back draws its own latency
+	const Timestamp diff = msg->arrival - msg->occurrence - msg->latency;
 	const Timestamp replyTime = msg->arrival + processingDelay;
 
 	m_simulation->dispatchMessage(replyTime, diff, this->m_name, msg->source, type, payload);
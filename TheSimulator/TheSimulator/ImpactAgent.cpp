@@ -34,13 +34,15 @@ void ImpactAgent::configure(const pugi::xml_node& node, const std::string& confi
 	}
 }
 
+void ImpactAgent::receiveWakeup(WakeupTag /*tag*/) {
+	simulation()->dispatchMessage(simulation()->currentTimestamp(), 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+}
+
 void ImpactAgent::receiveMessage(const MessagePtr& msg) {
 	const Timestamp currentTimestamp = simulation()->currentTimestamp();
 
 	if (msg->type == "EVENT_SIMULATION_START") {
-		simulation()->dispatchMessage(currentTimestamp, m_impactTime - currentTimestamp, name(), name(), "WAKEUP_FOR_IMPACT", std::make_shared<EmptyPayload>());
-	} else if (msg->type == "WAKEUP_FOR_IMPACT") {
-		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+		simulation()->scheduleWakeup(this, m_impactTime);
 	} else if (msg->type == "RESPONSE_RETRIEVE_L1") {
 		auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
 		Volume relevantSideVolume = m_impactSide == "bid" ? pptr->bidTotalVolume : pptr->askTotalVolume;
@@ -14,6 +14,7 @@ public:
 
 	// Inherited via Agent
 	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
 private:
 	std::string m_exchange;
 
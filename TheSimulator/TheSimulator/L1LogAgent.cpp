@@ -6,10 +6,10 @@
 #include <iostream>
 
 L1LogAgent::L1LogAgent(const Simulation* simulation)
-	: Agent(simulation), m_outputFile(), m_mostRecentPayload(nullptr), m_aggregationPeriod(0) { }
+	: Agent(simulation), m_outputFile(nullptr), m_mostRecentPayload(nullptr), m_aggregationPeriod(0) { }
 
 L1LogAgent::L1LogAgent(const Simulation* simulation, const std::string& name)
-	: Agent(simulation, name), m_outputFile(), m_mostRecentPayload(nullptr), m_aggregationPeriod(0) { }
+	: Agent(simulation, name), m_outputFile(nullptr), m_mostRecentPayload(nullptr), m_aggregationPeriod(0) { }
 
 void L1LogAgent::receiveMessage(const MessagePtr& messagePtr) {
 	const Timestamp currentTimestamp = simulation()->currentTimestamp();
@@ -19,10 +19,9 @@ void L1LogAgent::receiveMessage(const MessagePtr& messagePtr) {
 			simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_LIMIT", std::make_shared<EmptyPayload>());
 			simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_MARKET", std::make_shared<EmptyPayload>());
 		} else {
-			Timestamp nextAggregation = computeNextAggregation(currentTimestamp);
-			simulation()->dispatchMessage(currentTimestamp, nextAggregation - currentTimestamp, name(), name(), "WAKEUP_FOR_AGGREGATION", std::make_shared<EmptyPayload>());
+			simulation()->scheduleWakeup(this, computeNextAggregation(currentTimestamp));
 		}
-	} else if (messagePtr->type == "EVENT_ORDER_LIMIT" || messagePtr->type == "EVENT_ORDER_MARKET" || messagePtr->type == "WAKEUP_FOR_AGGREGATION") {
+	} else if (messagePtr->type == "EVENT_ORDER_LIMIT" || messagePtr->type == "EVENT_ORDER_MARKET") {
 		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
 	} else if (messagePtr->type == "RESPONSE_RETRIEVE_L1") {
 		auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(messagePtr->payload);
@@ -39,12 +38,15 @@ void L1LogAgent::receiveMessage(const MessagePtr& messagePtr) {
 		} else {
 			logData(pptr);
 			
-			Timestamp nextAggregation = computeNextAggregation(currentTimestamp);
-			simulation()->dispatchMessage(currentTimestamp, nextAggregation - currentTimestamp, name(), name(), "WAKEUP_FOR_AGGREGATION", std::make_shared<EmptyPayload>());
+			simulation()->scheduleWakeup(this, computeNextAggregation(currentTimestamp));
 		}
 	}
 }
 
+void L1LogAgent::receiveWakeup(WakeupTag /*tag*/) {
+	simulation()->dispatchMessage(simulation()->currentTimestamp(), 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+}
+
 Timestamp L1LogAgent::computeNextAggregation(Timestamp current) const {
 	Timestamp nextAggregation;
 	Timestamp nextAggregationDelta = current % m_aggregationPeriod;
@@ -58,7 +60,14 @@ Timestamp L1LogAgent::computeNextAggregation(Timestamp current) const {
 }
 
 void L1LogAgent::logData(std::shared_ptr<RetrieveL1ResponsePayload> pptr) {
-	m_outputFile << std::to_string(pptr->time) << "," << pptr->bestBidPrice.toCentString() << "," << pptr->bestAskPrice.toCentString() << std::endl;
+	if (m_outputFile == nullptr) {
+		return;
+	}
+
+	// the row buffer keeps its capacity, the row is only copied into the writer's ring
+	m_row.clear();
+	m_row.append(std::to_string(pptr->time)).append(",").append(pptr->bestBidPrice.toCentString()).append(",").append(pptr->bestAskPrice.toCentString()).append("\n");
+	m_outputFile->write(m_row);
 	// std::cout << std::to_string(pptr->time) << ": BID " << pptr->bestBidPrice.toCentString() << " ASK " << pptr->bestAskPrice.toCentString() << " SPREAD " << ((Money)(pptr->bestAskPrice - pptr->bestBidPrice)).toCentString() << std::endl;
 }
 
@@ -73,10 +82,17 @@ void L1LogAgent::configure(const pugi::xml_node& node, const std::string& config
 	}
 
 	if (!(att = node.attribute("outputFile")).empty()) {
-		m_outputFile.open(simulation()->parameters().processString(att.as_string()));
+		m_outputPathTemplate = att.as_string();
+		m_outputFile = AsyncLogWriter::instance().open(simulation()->parameters().processString(m_outputPathTemplate));
 	}
 
 	if (!(att = node.attribute("aggregationPeriod")).empty()) {
 		m_aggregationPeriod = att.as_ullong();
 	}
-}
\ No newline at end of file
+}
+
+void L1LogAgent::beginBranch() {
+	if (m_outputFile != nullptr) {
+		m_outputFile = AsyncLogWriter::instance().branch(m_outputFile, branchOutputPath(m_outputPathTemplate, m_outputFile->path()));
+	}
+}
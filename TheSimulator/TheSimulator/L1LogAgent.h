@@ -2,8 +2,8 @@
 #include "Agent.h"
 
 #include <memory>
-#include <fstream>
 #include "ExchangeAgentMessagePayloads.h"
+#include "AsyncLogWriter.h"
 
 class L1LogAgent : public Agent {
 public:
@@ -14,11 +14,15 @@ public:
 
 	// Inherited via Agent
 	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
+	void beginBranch() override;
 private:
 	std::string m_exchange;
 
 	std::shared_ptr<RetrieveL1ResponsePayload> m_mostRecentPayload;
-	std::ofstream m_outputFile;
+	LogStreamPtr m_outputFile;
+	std::string m_outputPathTemplate;
+	std::string m_row;
 	Timestamp m_aggregationPeriod;
 	Timestamp computeNextAggregation(Timestamp current) const;
 	void logData(std::shared_ptr<RetrieveL1ResponsePayload> l1data);
@@ -0,0 +1,196 @@
+#include "LatencyModel.h"
+
+#include "SimulationException.h"
+
+#include <algorithm>
+#include <cmath>
+
+LatencyModel::LatencyModel(Kind kind, Timestamp min, Timestamp max)
+	: m_kind(kind), m_min(min), m_max(max) { }
+
+LatencyModel LatencyModel::constant(Timestamp delay) {
+	return LatencyModel(Kind::Constant, delay, delay);
+}
+
+LatencyModel LatencyModel::uniform(Timestamp min, Timestamp max) {
+	if (max < min) {
+		throw SimulationException("LatencyModel::uniform(): the maximum delay is below the minimum one");
+	}
+	return LatencyModel(Kind::Uniform, min, max);
+}
+
+LatencyModel LatencyModel::lognormal(double mu, double sigma) {
+	if (!(sigma > 0.0)) {
+		throw SimulationException("LatencyModel::lognormal(): sigma has to be positive");
+	}
+
+	// P(Z > 6) is about 1e-9
+	const double z = 6.0;
+	const Timestamp lowest = (Timestamp)std::floor(std::exp(mu - z * sigma));
+	const double highest = std::ceil(std::exp(mu + z * sigma));
+	if (highest - (double)lowest >= (double)MAX_TABLE_SIZE) {
+		throw SimulationException("LatencyModel::lognormal(): the delays take more than " + std::to_string(MAX_TABLE_SIZE)
+			+ " table entries, the time unit is too fine for them");
+	}
+
+	// the delay d stands for all of (d - 0.5, d + 0.5]
+	auto cdf = [mu, sigma](double x) {
+		return x <= 0.0 ? 0.0 : 0.5 * std::erfc(-(std::log(x) - mu) / (sigma * std::sqrt(2.0)));
+	};
+	std::vector<Timestamp> delays;
+	std::vector<double> weights;
+	for (Timestamp delay = lowest; delay <= (Timestamp)highest; ++delay) {
+		delays.push_back(delay);
+		weights.push_back(cdf((double)delay + 0.5) - cdf((double)delay - 0.5));
+	}
+
+	LatencyModel model(Kind::Table, lowest, (Timestamp)highest);
+	model.buildAliasTable(delays, weights);
+	return model;
+}
+
+LatencyModel LatencyModel::empirical(const std::vector<Timestamp>& delays, const std::vector<double>& weights) {
+	if (delays.empty() || delays.size() != weights.size()) {
+		throw SimulationException("LatencyModel::empirical(): there has to be one weight for each of the delays, and at least one delay");
+	}
+	if (delays.size() > MAX_TABLE_SIZE) {
+		throw SimulationException("LatencyModel::empirical(): more than " + std::to_string(MAX_TABLE_SIZE) + " delays");
+	}
+
+	LatencyModel model(Kind::Table, *std::min_element(delays.begin(), delays.end()), *std::max_element(delays.begin(), delays.end()));
+	model.buildAliasTable(delays, weights);
+	return model;
+}
+
+void LatencyModel::buildAliasTable(const std::vector<Timestamp>& delays, const std::vector<double>& weights) {
+	double totalWeight = 0.0;
+	for (double weight : weights) {
+		if (!(weight >= 0.0)) {
+			throw SimulationException("LatencyModel::buildAliasTable(): a weight is negative");
+		}
+		totalWeight += weight;
+	}
+	if (!(totalWeight > 0.0)) {
+		throw SimulationException("LatencyModel::buildAliasTable(): the weights add up to zero");
+	}
+
+	// Vose: a column under the average is topped up with the rest of one over it, which goes back to the lists
+	const size_t size = delays.size();
+	const double full = 4294967296.0;
+	std::vector<double> scaled(size);
+	std::vector<size_t> small;
+	std::vector<size_t> large;
+	for (size_t index = 0; index < size; ++index) {
+		scaled[index] = weights[index] * (double)size / totalWeight;
+		(scaled[index] < 1.0 ? small : large).push_back(index);
+	}
+
+	m_columns.resize(size);
+	while (!small.empty() && !large.empty()) {
+		const size_t under = small.back();
+		small.pop_back();
+		const size_t over = large.back();
+
+		m_columns[under] = Column{ delays[under], delays[over], (uint64_t)(scaled[under] * full) };
+		scaled[over] -= 1.0 - scaled[under];
+		if (scaled[over] < 1.0) {
+			large.pop_back();
+			small.push_back(over);
+		}
+	}
+	// whatever is left is full up to the rounding errors
+	for (size_t index : small) {
+		m_columns[index] = Column{ delays[index], delays[index], (uint64_t)full };
+	}
+	for (size_t index : large) {
+		m_columns[index] = Column{ delays[index], delays[index], (uint64_t)full };
+	}
+}
+
+Timestamp LatencyModel::sample(std::mt19937_64& generator) const {
+	switch (m_kind) {
+	case Kind::Constant:
+		return m_min;
+	case Kind::Uniform:
+		return std::uniform_int_distribution<Timestamp>(m_min, m_max)(generator);
+	default:
+		break;
+	}
+
+	// the high half picks the column, the low half decides between its delay and its alias
+	const uint64_t draw = generator();
+	const Column& column = m_columns[(size_t)(((draw >> 32) * m_columns.size()) >> 32)];
+	return (draw & 0xFFFFFFFF) < column.threshold ? column.delay : column.aliasDelay;
+}
+
+void LatencyRegistry::setGroup(AgentHandle agent, const std::string& name, const std::string& group) {
+	auto it = m_groupIds.emplace(group, (LatencyGroupID)m_groupIds.size()).first;
+	if (agent >= m_agentGroups.size()) {
+		m_agentGroups.resize((size_t)agent + 1, LATENCYGROUP_NONE);
+	}
+	m_agentGroups[agent] = it->second;
+	m_agentGroupsByName[name] = it->second;
+}
+
+LatencyGroupID LatencyRegistry::group(const std::string& name) const {
+	auto it = m_agentGroupsByName.find(name);
+	return it != m_agentGroupsByName.end() ? it->second : LATENCYGROUP_NONE;
+}
+
+void LatencyRegistry::addLink(const std::string& sourceGroup, const std::string& targetGroup, const LatencyModel& model) {
+	m_links.push_back(Link{ sourceGroup, targetGroup, model, std::mt19937_64() });
+}
+
+void LatencyRegistry::build(uint64_t seed) {
+	const size_t groupCount = m_groupIds.size();
+	m_linkMatrix.assign(groupCount * groupCount, LINK_NONE);
+
+	std::vector<int> specificities(m_linkMatrix.size(), -1);
+	for (uint32_t linkIndex = 0; linkIndex < m_links.size(); ++linkIndex) {
+		Link& link = m_links[linkIndex];
+		const bool anySource = link.sourceGroup == "*";
+		const bool anyTarget = link.targetGroup == "*";
+		auto sit = m_groupIds.find(link.sourceGroup);
+		auto tit = m_groupIds.find(link.targetGroup);
+		if ((!anySource && sit == m_groupIds.end()) || (!anyTarget && tit == m_groupIds.end())) {
+			throw SimulationException("LatencyRegistry::build(): no agent in the group '"
+				+ ((!anySource && sit == m_groupIds.end()) ? link.sourceGroup : link.targetGroup)
+				+ "' of the link " + link.sourceGroup + " -> " + link.targetGroup);
+		}
+
+		const int specificity = (anySource ? 0 : 1) + (anyTarget ? 0 : 1);
+		for (LatencyGroupID source = 0; source < groupCount; ++source) {
+			if (!anySource && source != sit->second) {
+				continue;
+			}
+			for (LatencyGroupID target = 0; target < groupCount; ++target) {
+				if (!anyTarget && target != tit->second) {
+					continue;
+				}
+				const size_t cell = (size_t)source * groupCount + target;
+				if (specificity >= specificities[cell]) {
+					specificities[cell] = specificity;
+					m_linkMatrix[cell] = linkIndex;
+				}
+			}
+		}
+	}
+
+	reseed(seed);
+}
+
+void LatencyRegistry::reseed(uint64_t seed) {
+	for (uint32_t linkIndex = 0; linkIndex < m_links.size(); ++linkIndex) {
+		std::seed_seq seedSequence{ (uint32_t)seed, (uint32_t)(seed >> 32), linkIndex };
+		m_links[linkIndex].generator.seed(seedSequence);
+	}
+}
+
+Timestamp LatencyRegistry::sample(LatencyGroupID source, LatencyGroupID target) {
+	if (source == LATENCYGROUP_NONE || target == LATENCYGROUP_NONE) {
+		return 0;
+	}
+
+	const uint32_t linkIndex = m_linkMatrix[(size_t)source * m_groupIds.size() + target];
+	return linkIndex == LINK_NONE ? 0 : m_links[linkIndex].model.sample(m_links[linkIndex].generator);
+}
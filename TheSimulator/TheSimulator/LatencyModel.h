@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Timestamp.h"
+#include "Message.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The distribution of the delay of a link between agents. A constant or uniform delay is drawn directly, any other
+// distribution is tabulated over the whole delays it takes and drawn through an alias table (Walker/Vose), so that a
+// sample is O(1) whatever the distribution: one 64-bit draw picks a column and chooses between its delay and its alias.
+class LatencyModel {
+public:
+	static LatencyModel constant(Timestamp delay);
+	// every delay in [min, max] equally likely
+	static LatencyModel uniform(Timestamp min, Timestamp max);
+	// exp(N(mu, sigma^2)) rounded to whole time units, without the tail beyond the 1 - 1e-9 quantile
+	static LatencyModel lognormal(double mu, double sigma);
+	// delays[i] with a probability proportional to weights[i]
+	static LatencyModel empirical(const std::vector<Timestamp>& delays, const std::vector<double>& weights);
+
+	Timestamp sample(std::mt19937_64& generator) const;
+private:
+	enum class Kind {
+		Constant,
+		Uniform,
+		Table
+	};
+
+	// a column of the alias table, its own delay if the low 32 bits of the draw are below the threshold
+	struct Column {
+		Timestamp delay;
+		Timestamp aliasDelay;
+		uint64_t threshold;
+	};
+
+	// the lognormal tables of the widest links still fit in a few MB
+	static constexpr size_t MAX_TABLE_SIZE = (size_t)1 << 20;
+
+	LatencyModel(Kind kind, Timestamp min, Timestamp max);
+
+	Kind m_kind;
+	Timestamp m_min;
+	Timestamp m_max;
+	std::vector<Column> m_columns;
+
+	void buildAliasTable(const std::vector<Timestamp>& delays, const std::vector<double>& weights);
+};
+
+// The latency models of the links between groups of agents: a message from an agent to another one whose groups have a
+// link arrives a sample of the link's model later than the delay it was dispatched with, an event published on a topic
+// arrives at each group of subscribers a sample of its own later, though never before the topic's previous event for
+// the group. Every link draws from a stream of its own, seeded from the simulation seed and the position of the link, so
+// adding or changing a link leaves the samples of the other links and the random draws of the agents as they were.
+class LatencyRegistry {
+public:
+	bool empty() const { return m_links.empty(); }
+	size_t linkCount() const { return m_links.size(); }
+
+	void setGroup(AgentHandle agent, const std::string& name, const std::string& group);
+	// '*' stands for any group; of the links of a pair of groups, the one naming more groups applies, the later one
+	// among equals
+	void addLink(const std::string& sourceGroup, const std::string& targetGroup, const LatencyModel& model);
+	// resolves the link of every pair of groups and seeds the streams of the links, once the groups and links are in
+	void build(uint64_t seed);
+	// restarts the streams of the links from another seed, for a branch of a run
+	void reseed(uint64_t seed);
+
+	// LATENCYGROUP_NONE for anything but an agent; by name through a hash map rather than the simulation's binary search,
+	// as every message dispatched over a link needs the group of its source
+	LatencyGroupID group(AgentHandle agent) const { return agent < m_agentGroups.size() ? m_agentGroups[agent] : LATENCYGROUP_NONE; }
+	LatencyGroupID group(const std::string& name) const;
+	// 0 unless both groups are known and have a link
+	Timestamp sample(LatencyGroupID source, LatencyGroupID target);
+private:
+	static constexpr uint32_t LINK_NONE = UINT32_MAX;
+
+	struct Link {
+		std::string sourceGroup;
+		std::string targetGroup;
+		LatencyModel model;
+		std::mt19937_64 generator;
+	};
+
+	std::unordered_map<std::string, LatencyGroupID> m_groupIds;
+	// by agent handle and by agent name
+	std::vector<LatencyGroupID> m_agentGroups;
+	std::unordered_map<std::string, LatencyGroupID> m_agentGroupsByName;
+	std::vector<Link> m_links;
+	// the link of a pair of groups at sourceGroup * group count + targetGroup
+	std::vector<uint32_t> m_linkMatrix;
+};
@@ -0,0 +1,86 @@
+#include "Simulation.h"
+#include "ParameterStorage.h"
+#include "SimulationException.h"
+#include "CaptureAgent.h"
+#include "PythonAgent.h"
+
+#include "pugi/pugixml.hpp"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+namespace py = pybind11;
+
+// hands the buffer over to NumPy, the array owns the records from then on and frees them once it is collected
+template<class Record>
+static py::array_t<Record> adoptRecords(std::vector<Record>&& records) {
+	auto ownedRecords = new std::vector<Record>(std::move(records));
+	py::capsule owner(ownedRecords, [](void* pointer) { delete static_cast<std::vector<Record>*>(pointer); });
+	return py::array_t<Record>({ (py::ssize_t)ownedRecords->size() }, { (py::ssize_t)sizeof(Record) }, ownedRecords->data(), owner);
+}
+
+// runs one simulation given either an XML string or a path to an XML file, returns the buffers of every CaptureAgent by its name
+static py::dict run(const std::string& configuration, const py::dict& parameters) {
+	pugi::xml_document doc;
+	const size_t firstCharacter = configuration.find_first_not_of(" \t\r\n");
+	const bool isXmlString = firstCharacter != std::string::npos && configuration[firstCharacter] == '<';
+	pugi::xml_parse_result parseResult = isXmlString ? doc.load_string(configuration.c_str()) : doc.load_file(configuration.c_str());
+	if (!parseResult) {
+		throw SimulationException("maxe.run(): could not parse " + (isXmlString ? std::string("the configuration string") : "the file '" + configuration + "'") + ": " + parseResult.description());
+	}
+
+	auto node = doc.child("Simulation");
+	if (node.empty()) {
+		throw SimulationException("maxe.run(): the 'Simulation' element was not found");
+	}
+
+	ParameterStorage parameterStorage;
+	parameterStorage.set("runIndex", "0");
+	for (const auto& item : parameters) {
+		parameterStorage.set(py::str(item.first), py::str(item.second));
+	}
+
+	auto simulation = std::make_unique<Simulation>(&parameterStorage);
+	{
+		// the Python agents of the simulation take the GIL back for their own calls only
+		py::gil_scoped_release release;
+		simulation->configure(node, "");
+		simulation->simulate();
+	}
+
+	py::dict result;
+	for (const auto& agentPtr : simulation->agents()) {
+		auto capturePtr = dynamic_cast<CaptureAgent*>(agentPtr.get());
+		if (capturePtr == nullptr) {
+			continue;
+		}
+
+		py::dict captured;
+		captured["trades"] = adoptRecords(std::move(capturePtr->trades()));
+		captured["l1"] = adoptRecords(std::move(capturePtr->l1()));
+		captured["orders"] = adoptRecords(std::move(capturePtr->orderEvents()));
+		result[py::str(capturePtr->name())] = captured;
+	}
+
+	return result;
+}
+
+PYBIND11_MODULE(maxe, m) {
+	m.doc() = "MAXE simulations run in-process, with the CaptureAgent buffers returned as NumPy arrays";
+
+	PYBIND11_NUMPY_DTYPE(CapturedTrade, timestamp, id, aggressingOrderId, restingOrderId, volume, price, direction);
+	PYBIND11_NUMPY_DTYPE(CapturedL1, timestamp, bidPrice, bidVolume, bidTotalVolume, askPrice, askVolume, askTotalVolume);
+	PYBIND11_NUMPY_DTYPE(CapturedOrderEvent, timestamp, orderId, volume, price, direction, isMarket);
+	m.attr("TRADE_DTYPE") = py::dtype::of<CapturedTrade>();
+	m.attr("L1_DTYPE") = py::dtype::of<CapturedL1>();
+	m.attr("ORDER_DTYPE") = py::dtype::of<CapturedOrderEvent>();
+
+	// the Python agents import 'thesimulator', which is this module when not embedded in the executable
+	definePythonAgentBindings(m);
+	py::module::import("sys").attr("modules")["thesimulator"] = m;
+
+	py::register_exception<SimulationException>(m, "SimulationError");
+
+	m.def("run", &run, py::arg("configuration"), py::arg("parameters") = py::dict(),
+		"Runs the simulation configured by an XML string or file with the given parameters, releasing the GIL while simulating. "
+		"Returns {capture agent name: {'trades': ..., 'l1': ..., 'orders': ...}}.");
+}
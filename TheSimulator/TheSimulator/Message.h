@@ -9,15 +9,43 @@
 
 #include "MessagePayload.h"
 
+#include <cstdint>
+
+// An agent as its index in the simulation's agent list, sorted by name once the agents are configured; a message sent to
+// a handle is delivered without looking the target's name up
+using AgentHandle = uint32_t;
+constexpr AgentHandle AGENTHANDLE_INVALID = UINT32_MAX;
+
+// A topic registered with the simulation, a message published on it is delivered to all of its subscribers
+using TopicID = uint32_t;
+constexpr TopicID TOPICID_INVALID = UINT32_MAX;
+
+// A group of agents sharing the latency models of their links, see LatencyRegistry
+using LatencyGroupID = uint32_t;
+constexpr LatencyGroupID LATENCYGROUP_NONE = UINT32_MAX;
+
 struct Message {
 public:
 	Message(Timestamp occurrence, Timestamp arrival, const std::string& source, const std::string& target, const std::string& type, MessagePayloadPtr payload)
-		: occurrence(occurrence), arrival(arrival), source(source), type(type), payload(payload) {
+		: occurrence(occurrence), arrival(arrival), source(source), type(type), payload(payload), targetHandle(AGENTHANDLE_INVALID),
+		topic(TOPICID_INVALID), topicSequence(0), topicGroup(LATENCYGROUP_NONE), latency(0) {
 		this->targets = std::move(split(target, '|'));
 	}
 
 	Message(Timestamp occurrence, Timestamp arrival, const std::string& source, const std::vector<std::string>& targets, const std::string& type, MessagePayloadPtr payload)
-		: occurrence(occurrence), arrival(arrival), source(source), targets(targets), type(type), payload(payload) { }
+		: occurrence(occurrence), arrival(arrival), source(source), targets(targets), type(type), payload(payload), targetHandle(AGENTHANDLE_INVALID),
+		topic(TOPICID_INVALID), topicSequence(0), topicGroup(LATENCYGROUP_NONE), latency(0) { }
+
+	// targetName is the name of the agent of the handle, the targets of the message for anything looking at them
+	Message(Timestamp occurrence, Timestamp arrival, const std::string& source, AgentHandle targetHandle, const std::string& targetName, const std::string& type, MessagePayloadPtr payload)
+		: occurrence(occurrence), arrival(arrival), source(source), targets({ targetName }), type(type), payload(payload), targetHandle(targetHandle),
+		topic(TOPICID_INVALID), topicSequence(0), topicGroup(LATENCYGROUP_NONE), latency(0) { }
+
+	// topicName is the target of the message for anything looking at it, topicSequence the number of the message among the
+	// ones published on the topic
+	Message(Timestamp occurrence, Timestamp arrival, const std::string& source, TopicID topic, uint64_t topicSequence, const std::string& topicName, const std::string& type, MessagePayloadPtr payload)
+		: occurrence(occurrence), arrival(arrival), source(source), targets({ topicName }), type(type), payload(payload), targetHandle(AGENTHANDLE_INVALID),
+		topic(topic), topicSequence(topicSequence), topicGroup(LATENCYGROUP_NONE), latency(0) { }
 	
 	~Message() = default;
 
@@ -29,5 +57,16 @@ public:
 	std::string type;
 
 	MessagePayloadPtr payload;
+
+	// AGENTHANDLE_INVALID unless the message was sent to a handle
+	AgentHandle targetHandle;
+	// TOPICID_INVALID unless the message was published on a topic
+	TopicID topic;
+	uint64_t topicSequence;
+	// the latency group of the subscribers a topic message is for, all of them if LATENCYGROUP_NONE
+	LatencyGroupID topicGroup;
+	// the part of the transit (arrival - occurrence) drawn from the latency model of the link it went over, a response
+	// copies only the rest
+	Timestamp latency;
 };
 using MessagePtr = std::shared_ptr<Message>;
\ No newline at end of file
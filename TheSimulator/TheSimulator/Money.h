@@ -13,6 +13,8 @@ public:
 	Money(const Money& cpy) : Decimal() { setInternalValue(cpy.internalValue()); }
 	Money(const Decimal& cpy) : Decimal(cpy) {} //for amazing convenience
 
+	Money& operator=(const Money& rhs) { setInternalValue(rhs.internalValue()); return *this; }
+
 	void setCents(unsigned int cents);
 	unsigned int cents() const { return (unsigned int)std::abs(fraction() / CENT_OFFSET); }
 	unsigned int roundedCents() const { return cents() + (cents() >= 50 ? 1 : 0); }
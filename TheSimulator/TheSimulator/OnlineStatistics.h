@@ -0,0 +1,286 @@
+#pragma once
+
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <vector>
+
+// Estimators updated in O(1) (amortized for TDigest and RollingVwap) per observation, so that statistics of a whole
+// simulation can be maintained without keeping the observations around.
+
+// count, mean, variance, minimum and maximum by Welford's algorithm
+class WelfordAccumulator {
+public:
+	WelfordAccumulator()
+		: m_count(0), m_mean(0.0), m_m2(0.0), m_min(std::numeric_limits<double>::infinity()), m_max(-std::numeric_limits<double>::infinity()) { }
+
+	void add(double value);
+
+	size_t count() const { return m_count; }
+	double mean() const { return m_count > 0 ? m_mean : std::numeric_limits<double>::quiet_NaN(); }
+	// the unbiased sample variance
+	double variance() const { return m_count > 1 ? m_m2 / (m_count - 1) : std::numeric_limits<double>::quiet_NaN(); }
+	double standardDeviation() const { return std::sqrt(variance()); }
+	double min() const { return m_count > 0 ? m_min : std::numeric_limits<double>::quiet_NaN(); }
+	double max() const { return m_count > 0 ? m_max : std::numeric_limits<double>::quiet_NaN(); }
+private:
+	size_t m_count;
+	double m_mean;
+	double m_m2;
+	double m_min;
+	double m_max;
+};
+
+inline void WelfordAccumulator::add(double value) {
+	++m_count;
+	const double delta = value - m_mean;
+	m_mean += delta / m_count;
+	m_m2 += delta * (value - m_mean);
+	m_min = std::min(m_min, value);
+	m_max = std::max(m_max, value);
+}
+
+// exponentially weighted moving average, the first observation initializes it
+class EwmaAccumulator {
+public:
+	EwmaAccumulator()
+		: EwmaAccumulator(0.05) { }
+	explicit EwmaAccumulator(double alpha)
+		: m_alpha(alpha), m_value(std::numeric_limits<double>::quiet_NaN()), m_empty(true) { }
+
+	void add(double value);
+
+	double alpha() const { return m_alpha; }
+	void setAlpha(double alpha) { m_alpha = alpha; }
+	double value() const { return m_value; }
+private:
+	double m_alpha;
+	double m_value;
+	bool m_empty;
+};
+
+inline void EwmaAccumulator::add(double value) {
+	if (m_empty) {
+		m_value = value;
+		m_empty = false;
+	} else {
+		m_value += m_alpha * (value - m_value);
+	}
+}
+
+// lag-1 autocorrelation of a series, r1 = sum (x_t - m)(x_{t-1} - m) / sum (x_t - m)^2, from running sums
+class LagOneAutocorrelation {
+public:
+	LagOneAutocorrelation()
+		: m_count(0), m_sum(0.0), m_sumOfSquares(0.0), m_sumOfLaggedProducts(0.0), m_first(0.0), m_last(0.0) { }
+
+	void add(double value);
+
+	size_t count() const { return m_count; }
+	double value() const;
+private:
+	size_t m_count;
+	double m_sum;
+	double m_sumOfSquares;
+	double m_sumOfLaggedProducts;
+	double m_first;
+	double m_last;
+};
+
+inline void LagOneAutocorrelation::add(double value) {
+	if (m_count == 0) {
+		m_first = value;
+	} else {
+		m_sumOfLaggedProducts += m_last * value;
+	}
+	++m_count;
+	m_sum += value;
+	m_sumOfSquares += value * value;
+	m_last = value;
+}
+
+inline double LagOneAutocorrelation::value() const {
+	if (m_count < 3) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+
+	const double mean = m_sum / m_count;
+	const double denominator = m_sumOfSquares - m_count * mean * mean;
+	if (denominator <= 0.0) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+
+	// the lagged pairs are (x_1, x_0) .. (x_{n-1}, x_{n-2}), i.e. the sum without the first and without the last value
+	const double numerator = m_sumOfLaggedProducts - mean * (m_sum - m_first) - mean * (m_sum - m_last) + (m_count - 1) * mean * mean;
+	return numerator / denominator;
+}
+
+// Quantile sketch by Dunning's merging t-digest with the k1 (arcsine) scale function. Observations are buffered and
+// merged into at most ~compression centroids once the buffer is full or a quantile is asked for, centroids near the
+// tails stay small so that extreme quantiles remain accurate.
+class TDigest {
+public:
+	TDigest()
+		: TDigest(100.0) { }
+	explicit TDigest(double compression)
+		: m_compression(compression), m_totalWeight(0.0), m_min(std::numeric_limits<double>::infinity()), m_max(-std::numeric_limits<double>::infinity()) {
+		m_buffer.reserve(bufferCapacity());
+	}
+
+	void add(double value, double weight = 1.0);
+
+	double compression() const { return m_compression; }
+	double count() const { return m_totalWeight; }
+	// q in [0, 1]
+	double quantile(double q) const;
+private:
+	struct Centroid {
+		double mean;
+		double weight;
+	};
+
+	static constexpr double PI = 3.14159265358979323846;
+
+	double m_compression;
+	double m_totalWeight;
+	double m_min;
+	double m_max;
+
+	// merging is logically const, quantile() compresses the pending observations first
+	mutable std::vector<Centroid> m_centroids;
+	mutable std::vector<Centroid> m_buffer;
+
+	size_t bufferCapacity() const { return (size_t)(5 * m_compression) + 1; }
+	double scale(double q) const { return m_compression / (2.0 * PI) * std::asin(2.0 * q - 1.0); }
+	double inverseScale(double k) const { return (std::sin(k * 2.0 * PI / m_compression) + 1.0) / 2.0; }
+	void merge() const;
+};
+
+inline void TDigest::add(double value, double weight) {
+	m_buffer.push_back(Centroid{ value, weight });
+	m_totalWeight += weight;
+	m_min = std::min(m_min, value);
+	m_max = std::max(m_max, value);
+	if (m_buffer.size() >= bufferCapacity()) {
+		merge();
+	}
+}
+
+inline void TDigest::merge() const {
+	if (m_buffer.empty()) {
+		return;
+	}
+
+	m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+	std::sort(m_buffer.begin(), m_buffer.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+	m_centroids.clear();
+	Centroid current = m_buffer.front();
+	double weightSoFar = 0.0;
+	double quantileLimit = inverseScale(scale(0.0) + 1.0);
+	for (size_t i = 1; i < m_buffer.size(); ++i) {
+		const Centroid& next = m_buffer[i];
+		if ((weightSoFar + current.weight + next.weight) / m_totalWeight <= quantileLimit) {
+			current.weight += next.weight;
+			current.mean += (next.mean - current.mean) * next.weight / current.weight;
+		} else {
+			weightSoFar += current.weight;
+			m_centroids.push_back(current);
+			quantileLimit = inverseScale(scale(weightSoFar / m_totalWeight) + 1.0);
+			current = next;
+		}
+	}
+	m_centroids.push_back(current);
+	m_buffer.clear();
+}
+
+inline double TDigest::quantile(double q) const {
+	merge();
+	if (m_centroids.empty()) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	if (q <= 0.0) {
+		return m_min;
+	}
+	if (q >= 1.0) {
+		return m_max;
+	}
+
+	// every centroid's mean sits at the middle of its weight, interpolate between the neighbouring middles
+	const double target = q * m_totalWeight;
+	double weightSoFar = 0.0;
+	double previousMiddle = 0.0;
+	double previousMean = m_min;
+	for (const Centroid& centroid : m_centroids) {
+		const double middle = weightSoFar + centroid.weight / 2.0;
+		if (target < middle) {
+			const double fraction = (target - previousMiddle) / (middle - previousMiddle);
+			return previousMean + fraction * (centroid.mean - previousMean);
+		}
+		weightSoFar += centroid.weight;
+		previousMiddle = middle;
+		previousMean = centroid.mean;
+	}
+
+	const double fraction = (target - previousMiddle) / (m_totalWeight - previousMiddle);
+	return previousMean + fraction * (m_max - previousMean);
+}
+
+// volume weighted average price over the trades of the last 'window' time units
+class RollingVwap {
+public:
+	RollingVwap()
+		: RollingVwap(1000) { }
+	explicit RollingVwap(Timestamp window)
+		: m_window(window), m_notional(0.0), m_volume(0.0) { }
+
+	void add(Timestamp timestamp, double price, double volume);
+
+	Timestamp window() const { return m_window; }
+	void setWindow(Timestamp window) { m_window = window; }
+	// drops the trades that fell out of the window ending at the given time
+	double value(Timestamp timestamp);
+private:
+	struct Entry {
+		Timestamp timestamp;
+		double notional;
+		double volume;
+	};
+
+	Timestamp m_window;
+	std::deque<Entry> m_entries;
+	double m_notional;
+	double m_volume;
+
+	void evict(Timestamp timestamp);
+};
+
+inline void RollingVwap::add(Timestamp timestamp, double price, double volume) {
+	evict(timestamp);
+	m_entries.push_back(Entry{ timestamp, price * volume, volume });
+	m_notional += price * volume;
+	m_volume += volume;
+}
+
+inline double RollingVwap::value(Timestamp timestamp) {
+	evict(timestamp);
+	return m_volume > 0.0 ? m_notional / m_volume : std::numeric_limits<double>::quiet_NaN();
+}
+
+inline void RollingVwap::evict(Timestamp timestamp) {
+	while (!m_entries.empty() && m_entries.front().timestamp + m_window <= timestamp) {
+		m_notional -= m_entries.front().notional;
+		m_volume -= m_entries.front().volume;
+		m_entries.pop_front();
+	}
+
+	// the running sums would otherwise accumulate rounding errors over long simulations
+	if (m_entries.empty()) {
+		m_notional = 0.0;
+		m_volume = 0.0;
+	}
+}
@@ -53,7 +53,7 @@ MarketOrder::MarketOrder(OrderID id, OrderDirection direction, Timestamp timesta
 }
 
 LimitOrder::LimitOrder(OrderID id, OrderDirection direction, Timestamp timestamp, Volume volume, const Money& price)
-	: Order(id, direction, timestamp, volume), m_price(price) {
+	: Order(id, direction, timestamp, volume), m_price(price), m_peakVolume(0), m_hiddenVolume(0) {
 }
 
 void LimitOrder::printHuman() const {
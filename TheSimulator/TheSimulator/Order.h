@@ -7,16 +7,29 @@
 #include "IHumanPrintable.h"
 #include "ICSVPrintable.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 
 using OrderID = unsigned long int;
 constexpr OrderID ORDERID_INVALID = 0;
 
+// the instrument of an order on an exchange hosting several, 0 for the only one of the others
+using SymbolID = uint32_t;
+
 enum class OrderDirection : unsigned int {
 	Buy,
 	Sell
 };
 
+// how long a limit order stays in the book
+enum class TimeInForce : unsigned int {
+	GTC, // good till cancelled
+	IOC, // immediate or cancel: whatever does not match on arrival is cancelled
+	FOK, // fill or kill: matches in full on arrival, or not at all
+	GTD  // good till date: rests until it is cancelled or its expiry
+};
+
 class BasicOrder : public IHumanPrintable, public ICSVPrintable {
 public:
 	inline OrderID id() const { return m_id; }
@@ -31,6 +44,7 @@ protected:
 	BasicOrder(OrderID id, Timestamp timestamp, Volume orderVolume);
 
 	void setVolume(Volume newVolume) { m_volume = newVolume; }
+	void setTimestamp(Timestamp newTimestamp) { m_timestamp = newTimestamp; }
 
 	friend class Book;
 private:
@@ -77,6 +91,10 @@ public:
 	LimitOrder(LimitOrder&& order) = default;
 
 	inline Money price() const { return m_price; };
+	// an iceberg order shows at most its peak volume, the rest is hidden until what is shown has been filled
+	inline bool isIceberg() const { return m_peakVolume > 0; }
+	inline Volume peakVolume() const { return m_peakVolume; }
+	inline Volume hiddenVolume() const { return m_hiddenVolume; }
 
 	void printHuman() const override;
 	void printCSV() const override;
@@ -88,8 +106,32 @@ public:
 protected:
 	LimitOrder(OrderID id, OrderDirection direction, Timestamp timestamp, Volume volume, const Money& price);
 
+	// only while the book moves the order to another level
+	void setPrice(const Money& newPrice) { m_price = newPrice; }
+
+	// only the book turns an order into an iceberg, hiding all but the peak volume of what it has
+	void hideVolume(Volume peakVolume) {
+		m_peakVolume = peakVolume;
+		m_hiddenVolume = volume() > peakVolume ? volume() - peakVolume : 0;
+		setVolume(volume() - m_hiddenVolume);
+	}
+	void setHiddenVolume(Volume hiddenVolume) { m_hiddenVolume = hiddenVolume; }
+	// shows the next peak of the hidden volume once the shown volume is filled, false if nothing is hidden anymore
+	bool replenish() {
+		if (m_hiddenVolume == 0) {
+			return false;
+		}
+		const Volume shown = std::min(m_peakVolume, m_hiddenVolume);
+		m_hiddenVolume -= shown;
+		setVolume(volume() + shown);
+		return true;
+	}
+
 	friend class OrderFactory;
+	friend class Book;
 private:
-	const Money m_price;
+	Money m_price;
+	Volume m_peakVolume;
+	Volume m_hiddenVolume;
  };
 using LimitOrderPtr = std::shared_ptr<LimitOrder>;
\ No newline at end of file
@@ -17,6 +17,8 @@ public:
 
 	MarketOrderPtr makeMarketOrder(OrderDirection direction, Timestamp timestamp, Volume volume);
 	LimitOrderPtr makeLimitOrder(OrderDirection direction, Timestamp timestamp, Volume volume, Money price);
+	// an id no order made by the factory will have, for orders held outside of the book (e.g. stop orders)
+	OrderID reserveOrderId();
 
 	// convenience methods
 	MarketOrderPtr marketBuy(Timestamp timestamp, Volume volume);
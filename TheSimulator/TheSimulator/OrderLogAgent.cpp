@@ -4,10 +4,10 @@
 #include "ExchangeAgentMessagePayloads.h"
 
 OrderLogAgent::OrderLogAgent(const Simulation* simulation)
-	: Agent(simulation) { }
+	: Agent(simulation), m_outputFile(nullptr) { }
 
 OrderLogAgent::OrderLogAgent(const Simulation* simulation, const std::string& name)
-	: Agent(simulation, name) { }
+	: Agent(simulation, name), m_outputFile(nullptr) { }
 
 void OrderLogAgent::receiveMessage(const MessagePtr& messagePtr) {
 	const Timestamp currentTimestamp = simulation()->currentTimestamp();
@@ -19,18 +19,38 @@ void OrderLogAgent::receiveMessage(const MessagePtr& messagePtr) {
 		auto pptr = std::dynamic_pointer_cast<EventOrderMarketPayload>(messagePtr->payload);
 		const auto& order = pptr->order;
 
+		if (m_outputFile != nullptr) {
+			logRow(order, "MKT,");
+			return;
+		}
+
 		std::cout << name() << ": ";
 		order.printHuman();
 	} else if (messagePtr->type == "EVENT_ORDER_LIMIT") {
 		auto pptr = std::dynamic_pointer_cast<EventOrderLimitPayload>(messagePtr->payload);
 		const auto& order = pptr->order;
 
+		if (m_outputFile != nullptr) {
+			logRow(order, "LMT," + order.price().toFullString());
+			return;
+		}
+
 		std::cout << name() << ": ";
 		order.printHuman();
 		std::cout << std::endl;
 	}
 }
 
+void OrderLogAgent::logRow(const Order& order, const std::string& typeAndPrice) {
+	m_row.clear();
+	m_row.append(std::to_string(order.id())).append(",")
+		.append(std::to_string(order.timestamp())).append(",")
+		.append(std::to_string(order.volume())).append(",")
+		.append(order.direction() == OrderDirection::Buy ? "buy" : "sell").append(",")
+		.append(typeAndPrice).append("\n");
+	m_outputFile->write(m_row);
+}
+
 #include "ParameterStorage.h"
 
 void OrderLogAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
@@ -40,4 +60,16 @@ void OrderLogAgent::configure(const pugi::xml_node& node, const std::string& con
 	if (!(att = node.attribute("exchange")).empty()) { 
 		m_exchange = simulation()->parameters().processString(att.as_string());
 	}
-}
\ No newline at end of file
+
+	if (!(att = node.attribute("outputFile")).empty()) {
+		m_outputPathTemplate = att.as_string();
+		m_outputFile = AsyncLogWriter::instance().open(simulation()->parameters().processString(m_outputPathTemplate));
+		m_outputFile->write("id,timestamp,volume,direction,type,price\n");
+	}
+}
+
+void OrderLogAgent::beginBranch() {
+	if (m_outputFile != nullptr) {
+		m_outputFile = AsyncLogWriter::instance().branch(m_outputFile, branchOutputPath(m_outputPathTemplate, m_outputFile->path()));
+	}
+}
@@ -27,6 +27,10 @@ LimitOrderPtr OrderFactory::makeLimitOrder(OrderDirection direction, Timestamp t
 	return op;
 }
 
+OrderID OrderFactory::reserveOrderId() {
+	return ++m_orderCount;
+}
+
 MarketOrderPtr OrderFactory::marketBuy(Timestamp timestamp, Volume volume) {
 	return makeMarketOrder(OrderDirection::Buy, timestamp, volume);
 }
@@ -0,0 +1,102 @@
+#include "OrderTracker.h"
+
+void OrderTracker::insert(OrderID id, Volume volume, OrderOwner owner) {
+	auto it = m_indices.find(id);
+	if (it != m_indices.end()) {
+		m_volumes[it->second] = volume;
+		m_owners[it->second] = owner;
+		return;
+	}
+
+	m_indices.emplace(id, m_ids.size());
+	m_ids.push_back(id);
+	m_owners.push_back(owner);
+	m_volumes.push_back(volume);
+}
+
+bool OrderTracker::remove(OrderID id) {
+	auto it = m_indices.find(id);
+	if (it == m_indices.end()) {
+		return false;
+	}
+
+	const size_t index = it->second;
+	m_indices.erase(it);
+	removeAt(index);
+
+	return true;
+}
+
+bool OrderTracker::fill(OrderID id, Volume volume) {
+	auto it = m_indices.find(id);
+	if (it == m_indices.end()) {
+		return false;
+	}
+
+	const size_t index = it->second;
+	if (m_volumes[index] > volume) {
+		m_volumes[index] -= volume;
+		return false;
+	}
+
+	m_indices.erase(it);
+	removeAt(index);
+
+	return true;
+}
+
+void OrderTracker::clear() {
+	m_ids.clear();
+	m_owners.clear();
+	m_volumes.clear();
+	m_indices.clear();
+	m_keptTrades.clear();
+}
+
+bool OrderTracker::tryGetOwner(OrderID id, OrderOwner& owner) const {
+	auto it = m_indices.find(id);
+	if (it == m_indices.end()) {
+		return false;
+	}
+
+	owner = m_owners[it->second];
+	return true;
+}
+
+void OrderTracker::keepTrade(const Trade& trade, Timestamp now) {
+	while (m_hasKeepDuration && !m_keptTrades.empty() && m_keptTrades.front().arrival + m_keepDuration < now) {
+		m_keptTrades.pop_front();
+	}
+	m_keptTrades.push_back(KeptTrade{ now, trade });
+}
+
+bool OrderTracker::attribute(const Trade& trade, OrderID& id, OrderOwner& owner, bool& isAggressor) const {
+	if (tryGetOwner(trade.restingOrderID(), owner)) {
+		id = trade.restingOrderID();
+		isAggressor = false;
+		return true;
+	}
+
+	if (tryGetOwner(trade.aggressingOrderID(), owner)) {
+		id = trade.aggressingOrderID();
+		isAggressor = true;
+		return true;
+	}
+
+	return false;
+}
+
+void OrderTracker::removeAt(size_t index) {
+	// move the last order into the hole to keep the arrays dense
+	const size_t lastIndex = m_ids.size() - 1;
+	if (index != lastIndex) {
+		m_ids[index] = m_ids[lastIndex];
+		m_owners[index] = m_owners[lastIndex];
+		m_volumes[index] = m_volumes[lastIndex];
+		m_indices[m_ids[index]] = index;
+	}
+
+	m_ids.pop_back();
+	m_owners.pop_back();
+	m_volumes.pop_back();
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Message.h"
+#include "Order.h"
+#include "Trade.h"
+#include "BernoulliSampler.h"
+#include "ExchangeAgentMessagePayloads.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using OrderOwner = uint32_t;
+
+// The SUBSCRIBE_EVENT_ORDER_TRADE of an order to track, carrying what was placed; see OrderTracker::insertSubscribed()
+struct OrderTrackingPayload : public SubscribeEventTradeByOrderPayload {
+	OrderDirection direction;
+	Volume volume;
+	OrderOwner owner;
+
+	OrderTrackingPayload(OrderID id, OrderDirection direction, Volume volume, OrderOwner owner = 0)
+		: SubscribeEventTradeByOrderPayload(id), direction(direction), volume(volume), owner(owner) { }
+};
+
+// Book-keeping of an agent's live orders: O(1) insertion and removal, dense iteration and sampling. The owner is an agent
+// defined index (e.g. a trader within a population), agents trading on their own behalf can leave it at 0.
+class OrderTracker {
+public:
+	OrderTracker() = default;
+
+	void insert(OrderID id, Volume volume, OrderOwner owner = 0);
+	bool remove(OrderID id);
+	// removes the filled volume, the order is dropped once nothing remains, returns whether it was
+	bool fill(OrderID id, Volume volume);
+	void clear();
+
+	bool contains(OrderID id) const { return m_indices.count(id) > 0; }
+	bool tryGetOwner(OrderID id, OrderOwner& owner) const;
+	// finds out which side of the trade is ours, preferring the resting order
+	bool attribute(const Trade& trade, OrderID& id, OrderOwner& owner, bool& isAggressor) const;
+
+	// The trades of an order reach the agent through a SUBSCRIBE_EVENT_ORDER_TRADE sent on the response placing it, as an
+	// OrderTrackingPayload: what the order traded before the subscription is told by the filled volume of the response,
+	// what is left to track by the volume still resting then, and its trades from then on are events, which can arrive
+	// before the response to the subscription. fillTrade() removes what the trade filled of the tracked orders on its
+	// sides and calls callback(owner, direction, volume) for each; a trade of an order not tracked yet is kept for as long
+	// as a response has taken to travel back so far. insertSubscribed() inserts the order of the response less what it
+	// traded meanwhile and calls callback(owner, direction, volume) for all it has traded until then, never for what was
+	// cancelled, expired or dropped of it; returns false if nothing of the order is left or the response is an error.
+	template<class Callback>
+	void fillTrade(const Trade& trade, Timestamp now, Callback callback);
+	void fillTrade(const Trade& trade, Timestamp now) {
+		fillTrade(trade, now, [](OrderOwner, OrderDirection, Volume) { });
+	}
+	template<class Callback>
+	bool insertSubscribed(const Message& response, Callback callback);
+	bool insertSubscribed(const Message& response) {
+		return insertSubscribed(response, [](OrderOwner, OrderDirection, Volume) { });
+	}
+
+	size_t size() const { return m_ids.size(); }
+	bool empty() const { return m_ids.empty(); }
+
+	// the live orders in parallel arrays, indices are only stable until the next removal
+	const std::vector<OrderID>& ids() const { return m_ids; }
+	const std::vector<OrderOwner>& owners() const { return m_owners; }
+	OrderID id(size_t index) const { return m_ids[index]; }
+	OrderOwner owner(size_t index) const { return m_owners[index]; }
+
+	// calls callback(index) for each live order independently with the sampler's probability, only the selected orders are visited
+	template<class Callback>
+	void sample(BernoulliSampler& sampler, std::mt19937& randomGenerator, Callback callback) const;
+private:
+	std::vector<OrderID> m_ids;
+	std::vector<OrderOwner> m_owners;
+	std::vector<Volume> m_volumes;
+	std::unordered_map<OrderID, size_t> m_indices;
+
+	struct KeptTrade {
+		Timestamp arrival;
+		Trade trade;
+	};
+	// in the order of their arrival, everything until the first response tells how long responses take
+	std::deque<KeptTrade> m_keptTrades;
+	Timestamp m_keepDuration = 0;
+	bool m_hasKeepDuration = false;
+
+	void keepTrade(const Trade& trade, Timestamp now);
+	void removeAt(size_t index);
+};
+
+template<class Callback>
+inline void OrderTracker::fillTrade(const Trade& trade, Timestamp now, Callback callback) {
+	const OrderDirection restingDirection = trade.direction() == OrderDirection::Buy ? OrderDirection::Sell : OrderDirection::Buy;
+	OrderOwner owner;
+	bool isKept = false;
+
+	if (tryGetOwner(trade.restingOrderID(), owner)) {
+		fill(trade.restingOrderID(), trade.volume());
+		callback(owner, restingDirection, trade.volume());
+	} else {
+		isKept = true;
+	}
+
+	if (tryGetOwner(trade.aggressingOrderID(), owner)) {
+		fill(trade.aggressingOrderID(), trade.volume());
+		callback(owner, trade.direction(), trade.volume());
+	} else {
+		isKept = true;
+	}
+
+	if (isKept) {
+		keepTrade(trade, now);
+	}
+}
+
+template<class Callback>
+inline bool OrderTracker::insertSubscribed(const Message& response, Callback callback) {
+	auto pptr = std::dynamic_pointer_cast<SubscribeEventTradeByOrderResponsePayload>(response.payload);
+	if (pptr == nullptr) {
+		return false;
+	}
+	auto requestptr = std::static_pointer_cast<OrderTrackingPayload>(pptr->requestPayload);
+	const OrderID id = requestptr->id;
+
+	const Timestamp returnDelay = response.arrival - response.occurrence;
+	m_keepDuration = m_hasKeepDuration ? std::max(m_keepDuration, returnDelay) : returnDelay;
+	m_hasKeepDuration = true;
+
+	// what was cancelled, expired or dropped of the order is neither a fill nor left to track
+	const Volume filledVolume = std::min(pptr->filledVolume, requestptr->volume);
+	if (filledVolume > 0) {
+		callback(requestptr->owner, requestptr->direction, filledVolume);
+	}
+	Volume volume = std::min(pptr->restingVolume, requestptr->volume - filledVolume);
+
+	for (const KeptTrade& kept : m_keptTrades) {
+		if (volume > 0 && kept.arrival + returnDelay >= response.arrival && (kept.trade.aggressingOrderID() == id || kept.trade.restingOrderID() == id)) {
+			const Volume filled = std::min(volume, kept.trade.volume());
+			volume -= filled;
+			callback(requestptr->owner, requestptr->direction, filled);
+		}
+	}
+
+	if (volume == 0) {
+		return false;
+	}
+	insert(id, volume, requestptr->owner);
+	return true;
+}
+
+template<class Callback>
+inline void OrderTracker::sample(BernoulliSampler& sampler, std::mt19937& randomGenerator, Callback callback) const {
+	sampler.sample(m_ids.size(), randomGenerator, callback);
+}
@@ -27,8 +27,19 @@ bool ParameterStorage::tryGet(const std::string& name, std::string& val) {
 	}
 }
 
+const std::string* ParameterStorage::find(const std::string& name) const {
+	auto fit = m_parameterMap.find(name);
+	return fit != m_parameterMap.end() ? &fit->second : nullptr;
+}
+
 std::string ParameterStorage::processString(const std::string& stringToProcess) {
+	// most attributes are plain values
+	if (stringToProcess.find('$') == std::string::npos) {
+		return stringToProcess;
+	}
+
 	std::string ret;
+	ret.reserve(stringToProcess.size());
 
 	std::string::const_iterator it = stringToProcess.cbegin();
 	const std::string::const_iterator endIt = stringToProcess.cend();
@@ -45,9 +56,9 @@ std::string ParameterStorage::processString(const std::string& stringToProcess)
 					const auto paramEndIt = std::find(it, endIt, '}');
 					if (paramEndIt != endIt) {
 						const std::string paramName = std::string(it, paramEndIt);
-						std::string paramValue;
-						if (tryGet(paramName, paramValue)) {
-							ret.append(paramValue);
+						auto fit = m_parameterMap.find(paramName);
+						if (fit != m_parameterMap.end()) {
+							ret.append(fit->second);
 						} else {
 							throw SimulationException("ParameterStorage::processString(): unknown parameter name '" + paramName + "' encountered in the string '" + stringToProcess + "'");
 						}
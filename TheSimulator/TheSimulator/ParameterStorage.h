@@ -1,18 +1,21 @@
 #pragma once
 
 #include <string>
-#include <map>
+#include <unordered_map>
 
 class ParameterStorage {
 public:
 	void set(const std::string& name, const std::string& value);
 	const std::string& get(const std::string& name);
 	bool tryGet(const std::string& name, std::string& val);
+	// nullptr if there is no parameter of the name
+	const std::string* find(const std::string& name) const;
 
+	// substitutes every '${name}' by the parameter's value
 	std::string processString(const std::string& stringToProcess);
 
 	const std::string& operator[](const std::string& parameterName) const;
 	std::string& operator[](const std::string& parameterName);
 private:
-	std::map<std::string, std::string> m_parameterMap;
+	std::unordered_map<std::string, std::string> m_parameterMap;
 };
\ No newline at end of file
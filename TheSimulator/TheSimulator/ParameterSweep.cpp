@@ -0,0 +1,221 @@
+#include "ParameterSweep.h"
+
+#include "ParameterStorage.h"
+#include "SimulationException.h"
+#include "split.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+ParameterSweep::ParameterSweep()
+	: m_mode(SweepMode::Grid), m_sampleCount(0), m_replicateCount(1), m_seed(std::random_device()()), m_outputDirectory(""), m_summaryPath("") { }
+
+void ParameterSweep::configure(const pugi::xml_node& node, const std::string& /*configurationPath*/) {
+	pugi::xml_attribute att;
+	if (!(att = node.attribute("mode")).empty()) {
+		const std::string mode = att.as_string();
+		if (mode == "grid") {
+			m_mode = SweepMode::Grid;
+		} else if (mode == "random") {
+			m_mode = SweepMode::Random;
+		} else if (mode == "lhs") {
+			m_mode = SweepMode::LatinHypercube;
+		} else {
+			throw SimulationException("ParameterSweep::configure(): unknown sweep mode '" + mode + "', expected 'grid', 'random' or 'lhs'");
+		}
+	}
+
+	if (!(att = node.attribute("samples")).empty()) {
+		m_sampleCount = att.as_uint();
+	}
+
+	if (!(att = node.attribute("replicates")).empty()) {
+		m_replicateCount = att.as_uint();
+	}
+
+	if (!(att = node.attribute("seed")).empty()) {
+		m_seed = (std::mt19937::result_type)att.as_ullong();
+	}
+
+	if (!(att = node.attribute("outputDirectory")).empty()) {
+		m_outputDirectory = att.as_string();
+	}
+
+	if (!(att = node.attribute("summary")).empty()) {
+		m_summaryPath = att.as_string();
+	} else if (!m_outputDirectory.empty()) {
+		m_summaryPath = m_outputDirectory + "/summary.csv";
+	}
+
+	if (!(att = node.attribute("statistics")).empty()) {
+		m_statistics = split(att.as_string(), ',');
+	}
+
+	for (pugi::xml_node parameterNode : node.children("Parameter")) {
+		SweepParameter parameter{ parameterNode.attribute("name").as_string(), {}, 0.0, 0.0, 0, parameterNode.attribute("integer").as_bool() };
+		if (parameter.name.empty()) {
+			throw SimulationException("ParameterSweep::configure(): every Parameter needs a name");
+		}
+
+		if (!(att = parameterNode.attribute("values")).empty()) {
+			parameter.values = split(att.as_string(), ',');
+			if (parameter.values.empty()) {
+				throw SimulationException("ParameterSweep::configure(): the parameter '" + parameter.name + "' has an empty list of values");
+			}
+		} else if (!parameterNode.attribute("from").empty() && !parameterNode.attribute("to").empty()) {
+			parameter.from = parameterNode.attribute("from").as_double();
+			parameter.to = parameterNode.attribute("to").as_double();
+			parameter.steps = parameterNode.attribute("steps").as_uint(0);
+			if (m_mode == SweepMode::Grid && parameter.steps == 0) {
+				throw SimulationException("ParameterSweep::configure(): the range of the parameter '" + parameter.name + "' needs 'steps' in the grid mode");
+			}
+		} else {
+			throw SimulationException("ParameterSweep::configure(): the parameter '" + parameter.name + "' needs either 'values' or 'from' and 'to'");
+		}
+
+		m_parameters.push_back(std::move(parameter));
+	}
+
+	if (m_parameters.empty()) {
+		throw SimulationException("ParameterSweep::configure(): the sweep has no Parameter to vary");
+	}
+
+	if (m_replicateCount == 0) {
+		throw SimulationException("ParameterSweep::configure(): the number of replicates has to be positive");
+	}
+
+	if (m_mode != SweepMode::Grid && m_sampleCount == 0) {
+		throw SimulationException("ParameterSweep::configure(): the random and lhs modes need a positive number of 'samples'");
+	}
+
+	// the points only depend on the sweep seed, not on the seeds of the runs
+	std::seed_seq pointSeed{ m_seed, (std::mt19937::result_type)0x5eed };
+	std::mt19937 randomGenerator(pointSeed);
+	switch (m_mode) {
+	case SweepMode::Grid:
+		generateGrid();
+		break;
+	case SweepMode::Random:
+		generateRandom(randomGenerator);
+		break;
+	case SweepMode::LatinHypercube:
+		generateLatinHypercube(randomGenerator);
+		break;
+	}
+}
+
+std::mt19937::result_type ParameterSweep::runSeed(unsigned int runIndex) const {
+	std::seed_seq runSeedSequence{ m_seed, (std::mt19937::result_type)runIndex };
+	std::mt19937::result_type seed;
+	runSeedSequence.generate(&seed, &seed + 1);
+	return seed;
+}
+
+std::string ParameterSweep::runOutputDirectory(unsigned int runIndex) const {
+	if (m_outputDirectory.empty()) {
+		return "";
+	}
+
+	return m_outputDirectory + "/run_" + std::to_string(runIndex);
+}
+
+void ParameterSweep::applyRun(unsigned int runIndex, ParameterStorage& parameters) const {
+	const unsigned int pointIndex = runIndex / m_replicateCount;
+	const std::vector<std::string>& values = m_points[pointIndex];
+	for (size_t i = 0; i < m_parameters.size(); ++i) {
+		parameters.set(m_parameters[i].name, values[i]);
+	}
+
+	parameters.set("runIndex", std::to_string(runIndex));
+	parameters.set("pointIndex", std::to_string(pointIndex));
+	parameters.set("replicate", std::to_string(runIndex % m_replicateCount));
+	parameters.set("seed", std::to_string(runSeed(runIndex)));
+	parameters.set("outputDirectory", m_outputDirectory.empty() ? "." : runOutputDirectory(runIndex));
+}
+
+static std::string formatValue(double value) {
+	std::ostringstream ss;
+	ss << std::setprecision(12) << value;
+	return ss.str();
+}
+
+void ParameterSweep::generateGrid() {
+	std::vector<std::vector<std::string>> axes;
+	size_t pointCount = 1;
+	for (const SweepParameter& parameter : m_parameters) {
+		std::vector<std::string> axis = parameter.values;
+		if (axis.empty()) {
+			for (unsigned int step = 0; step < parameter.steps; ++step) {
+				const double value = parameter.steps == 1 ? parameter.from : parameter.from + (parameter.to - parameter.from) * step / (parameter.steps - 1);
+				axis.push_back(formatValue(parameter.integer ? std::round(value) : value));
+			}
+		}
+		pointCount *= axis.size();
+		axes.push_back(std::move(axis));
+	}
+
+	// mixed radix counting, the last parameter varies the fastest
+	m_points.reserve(pointCount);
+	std::vector<size_t> indices(axes.size(), 0);
+	for (size_t point = 0; point < pointCount; ++point) {
+		std::vector<std::string> values;
+		values.reserve(axes.size());
+		for (size_t i = 0; i < axes.size(); ++i) {
+			values.push_back(axes[i][indices[i]]);
+		}
+		m_points.push_back(std::move(values));
+
+		for (size_t i = axes.size(); i-- > 0;) {
+			if (++indices[i] < axes[i].size()) {
+				break;
+			}
+			indices[i] = 0;
+		}
+	}
+}
+
+void ParameterSweep::generateRandom(std::mt19937& randomGenerator) {
+	std::uniform_real_distribution<double> uniformDistribution(0.0, 1.0);
+	m_points.reserve(m_sampleCount);
+	for (unsigned int sample = 0; sample < m_sampleCount; ++sample) {
+		std::vector<std::string> values;
+		values.reserve(m_parameters.size());
+		for (const SweepParameter& parameter : m_parameters) {
+			values.push_back(valueAt(parameter, uniformDistribution(randomGenerator)));
+		}
+		m_points.push_back(std::move(values));
+	}
+}
+
+void ParameterSweep::generateLatinHypercube(std::mt19937& randomGenerator) {
+	// every parameter's range is cut into 'samples' strata, each stratum is used by exactly one point
+	std::uniform_real_distribution<double> uniformDistribution(0.0, 1.0);
+	m_points.assign(m_sampleCount, std::vector<std::string>());
+	std::vector<unsigned int> strata(m_sampleCount);
+	for (const SweepParameter& parameter : m_parameters) {
+		std::iota(strata.begin(), strata.end(), 0);
+		std::shuffle(strata.begin(), strata.end(), randomGenerator);
+		for (unsigned int sample = 0; sample < m_sampleCount; ++sample) {
+			const double quantile = (strata[sample] + uniformDistribution(randomGenerator)) / m_sampleCount;
+			m_points[sample].push_back(valueAt(parameter, quantile));
+		}
+	}
+}
+
+std::string ParameterSweep::valueAt(const SweepParameter& parameter, double quantile) const {
+	if (!parameter.values.empty()) {
+		const size_t index = std::min(parameter.values.size() - 1, (size_t)(quantile * parameter.values.size()));
+		return parameter.values[index];
+	}
+
+	if (parameter.integer) {
+		// every integer of the inclusive range is equally likely
+		const double value = std::floor(parameter.from + (parameter.to - parameter.from + 1.0) * quantile);
+		return formatValue(std::min(value, parameter.to));
+	}
+
+	return formatValue(parameter.from + (parameter.to - parameter.from) * quantile);
+}
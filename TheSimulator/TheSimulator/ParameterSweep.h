@@ -0,0 +1,80 @@
+#pragma once
+
+#include "IConfigurable.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+class ParameterStorage;
+
+enum class SweepMode {
+	Grid,
+	Random,
+	LatinHypercube
+};
+
+struct SweepParameter {
+	std::string name;
+
+	// either a list of values, or a [from, to] range
+	std::vector<std::string> values;
+	double from;
+	double to;
+	unsigned int steps; // grid points of a range in the grid mode
+	bool integer;       // range values are rounded to integers
+};
+
+// The points of a parameter sweep, read from a <Sweep> element:
+//
+//   <Sweep mode="grid|random|lhs" samples="..." replicates="..." seed="..." outputDirectory="..." summary="..." statistics="...">
+//       <Parameter name="alpha" values="0.1,0.2,0.5" />
+//       <Parameter name="spread" from="0.1" to="1.0" steps="10" />
+//   </Sweep>
+//
+// The grid mode runs the cartesian product of the values (a range contributes 'steps' evenly spaced values), the random
+// mode draws 'samples' points uniformly and the lhs mode draws 'samples' points by Latin hypercube sampling. Every point
+// is run 'replicates' times, run r simulates point r / replicates. The summary has a row per run with the statistics of
+// the StatsAgents of the run as columns named <agent>.<statistic>, only the statistics listed in 'statistics' (comma
+// separated) if it is set.
+class ParameterSweep : public IConfigurable {
+public:
+	ParameterSweep();
+
+	// Inherited via IConfigurable
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	unsigned int pointCount() const { return (unsigned int)m_points.size(); }
+	unsigned int replicateCount() const { return m_replicateCount; }
+	unsigned int runCount() const { return pointCount() * m_replicateCount; }
+
+	const std::vector<SweepParameter>& parameters() const { return m_parameters; }
+	const std::vector<std::string>& point(unsigned int pointIndex) const { return m_points[pointIndex]; }
+
+	std::mt19937::result_type runSeed(unsigned int runIndex) const;
+	// empty if the runs are not given their own output directories
+	std::string runOutputDirectory(unsigned int runIndex) const;
+	const std::string& summaryPath() const { return m_summaryPath; }
+	// the StatsAgent statistics to collect into the summary, all of them if empty
+	const std::vector<std::string>& statistics() const { return m_statistics; }
+
+	// sets the point's values along with runIndex, pointIndex, replicate, seed and outputDirectory
+	void applyRun(unsigned int runIndex, ParameterStorage& parameters) const;
+private:
+	SweepMode m_mode;
+	unsigned int m_sampleCount;
+	unsigned int m_replicateCount;
+	std::mt19937::result_type m_seed;
+	std::string m_outputDirectory;
+	std::string m_summaryPath;
+	std::vector<std::string> m_statistics;
+
+	std::vector<SweepParameter> m_parameters;
+	std::vector<std::vector<std::string>> m_points;
+
+	void generateGrid();
+	void generateRandom(std::mt19937& randomGenerator);
+	void generateLatinHypercube(std::mt19937& randomGenerator);
+	// value of the parameter at the given quantile of its range or list
+	std::string valueAt(const SweepParameter& parameter, double quantile) const;
+};
@@ -13,13 +13,13 @@ void PriceTimeBook::processAgainstTheBuyQueue(const OrderPtr& order, Money minPr
 		if(usedVolume > 0) {
 			logTrade(OrderDirection::Sell, order->id(), iop->id(), usedVolume, bestBuyDeque->price());
 		}
-		if (iop->volume() == 0) {
+		if (iop->volume() == 0 && !replenishOrder(*bestBuyDeque, bestBuyDeque->begin())) {
 			bestBuyDeque->pop_front();
 			unregisterLimitOrder(iop);
 		}
 
 		if (bestBuyDeque->empty()) {
-			m_buyQueue.pop_back();
+			popBestLevel(OrderDirection::Buy);
 			if (m_buyQueue.empty()) {
 				break;
 			}
@@ -38,13 +38,13 @@ void PriceTimeBook::processAgainstTheSellQueue(const OrderPtr& order, Money maxP
 		if (usedVolume > 0) {
 			logTrade(OrderDirection::Buy, order->id(), iop->id(), usedVolume, bestSellDeque->price());
 		}
-		if (iop->volume() == 0) {
+		if (iop->volume() == 0 && !replenishOrder(*bestSellDeque, bestSellDeque->begin())) {
 			bestSellDeque->pop_front();
 			unregisterLimitOrder(iop);
 		}
 
 		if (bestSellDeque->empty()) {
-			m_sellQueue.pop_front();
+			popBestLevel(OrderDirection::Sell);
 			if (m_sellQueue.empty()) {
 				break;
 			}
@@ -5,7 +5,7 @@ PriorityProRataBook::PriorityProRataBook(OrderFactoryPtr orderFactory, TradeFact
 
 void PriorityProRataBook::processAgainstTheBuyQueue(const OrderPtr& order, Money minPrice) {
 	const auto& bestBuyList = m_buyQueue.back();
-	if (order->volume() > 0 && bestBuyList.price() >= minPrice && m_lastBetteringBuyOrder->volume() > 0) {
+	if (order->volume() > 0 && bestBuyList.price() >= minPrice && m_lastBetteringBuyOrder != nullptr && m_lastBetteringBuyOrder->volume() > 0) {
 		const Volume effectiveVolume = std::min(order->volume(), m_lastBetteringBuyOrder->volume());
 		order->removeVolume(effectiveVolume);
 		m_lastBetteringBuyOrder->removeVolume(effectiveVolume);
@@ -14,7 +14,14 @@ void PriorityProRataBook::processAgainstTheBuyQueue(const OrderPtr& order, Money
 		}
 
 		if (m_lastBetteringBuyOrder->volume() == 0) {
-			m_buyQueue.back().remove(m_lastBetteringBuyOrder);
+			auto& bestLevel = m_buyQueue.back();
+			auto it = std::find(bestLevel.begin(), bestLevel.end(), m_lastBetteringBuyOrder);
+			if (it != bestLevel.end() && replenishOrder(bestLevel, it)) {
+				// a new peak of an iceberg order has no priority
+				m_lastBetteringBuyOrder = nullptr;
+			} else {
+				bestLevel.remove(m_lastBetteringBuyOrder);
+			}
 		}
 	}
 
@@ -23,7 +30,7 @@ void PriorityProRataBook::processAgainstTheBuyQueue(const OrderPtr& order, Money
 
 void PriorityProRataBook::processAgainstTheSellQueue(const OrderPtr& order, Money maxPrice) {
 	const auto& bestSellList = m_sellQueue.front();
-	if (order->volume() > 0 && bestSellList.price() <= maxPrice && m_lastBetteringSellOrder->volume() > 0) {
+	if (order->volume() > 0 && bestSellList.price() <= maxPrice && m_lastBetteringSellOrder != nullptr && m_lastBetteringSellOrder->volume() > 0) {
 		const Volume effectiveVolume = std::min(order->volume(), m_lastBetteringSellOrder->volume());
 		order->removeVolume(effectiveVolume);
 		m_lastBetteringSellOrder->removeVolume(effectiveVolume);
@@ -32,7 +39,13 @@ void PriorityProRataBook::processAgainstTheSellQueue(const OrderPtr& order, Mone
 		}
 
 		if (m_lastBetteringSellOrder->volume() == 0) {
-			m_sellQueue.back().remove(m_lastBetteringSellOrder);
+			auto& bestLevel = m_sellQueue.front();
+			auto it = std::find(bestLevel.begin(), bestLevel.end(), m_lastBetteringSellOrder);
+			if (it != bestLevel.end() && replenishOrder(bestLevel, it)) {
+				m_lastBetteringSellOrder = nullptr;
+			} else {
+				bestLevel.remove(m_lastBetteringSellOrder);
+			}
 		}
 	}
 
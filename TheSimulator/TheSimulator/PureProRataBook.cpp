@@ -30,8 +30,10 @@ void PureProRataBook::processAgainstTheBuyQueue(const OrderPtr& order, Money min
 			}
 
 			if ((*it)->volume() == 0) {
-				unregisterLimitOrder(*it);
-				bestBuyList->erase(it);
+				if (!replenishOrder(*bestBuyList, it)) {
+					unregisterLimitOrder(*it);
+					bestBuyList->erase(it);
+				}
 				it = bestBuyList->begin();
 			} else {
 				++it;
@@ -39,7 +41,7 @@ void PureProRataBook::processAgainstTheBuyQueue(const OrderPtr& order, Money min
 		}
 
 		if (bestBuyList->empty()) {
-			m_buyQueue.pop_back();
+			popBestLevel(OrderDirection::Buy);
 			if (m_buyQueue.empty()) {
 				break;
 			}
@@ -72,8 +74,10 @@ void PureProRataBook::processAgainstTheSellQueue(const OrderPtr& order, Money ma
 			}
 
 			if ((*it)->volume() == 0) {
-				unregisterLimitOrder(*it);
-				bestSellList->erase(it);
+				if (!replenishOrder(*bestSellList, it)) {
+					unregisterLimitOrder(*it);
+					bestSellList->erase(it);
+				}
 				it = bestSellList->begin();
 			} else {
 				++it;
@@ -81,7 +85,7 @@ void PureProRataBook::processAgainstTheSellQueue(const OrderPtr& order, Money ma
 		}
 
 		if (bestSellList->empty()) {
-			m_sellQueue.pop_front();
+			popBestLevel(OrderDirection::Sell);
 			if (m_sellQueue.empty()) {
 				break;
 			}
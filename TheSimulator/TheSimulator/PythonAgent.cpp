@@ -1,46 +1,266 @@
-// #include "PythonAgent.h"
-// #include "Simulation.h"
-
-// #include <pybind11/stl.h>
-
-// PythonAgent::PythonAgent(const Simulation* simulation, const std::string& pythonClass, const std::string& file)
-// 	: Agent(simulation), m_class(pythonClass), m_file(file) { }
-
-// PythonAgent::PythonAgent(const Simulation* simulation, const std::string& name)
-// 	: Agent(simulation, name), m_class(""), m_file("") { }
-
-// void PythonAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
-// 	Agent::configure(node, configurationPath);
-
-// 	for (const pugi::xml_attribute& attr : node.attributes()) {
-// 		if (std::string(attr.name()) != "file" && std::string(attr.name()) != "name") {
-// 			m_parameters[std::string(attr.name())] = simulation()->parameters().processString(attr.as_string());
-// 		}
-// 	}
-
-// 	py::object agentClass;
-// 	if (m_file == "") {
-// 		py::module m = py::module::import(m_class.c_str());
-// 		agentClass = m.attr(m_class.c_str());
-// 	} else {
-// 		py::object result = py::eval_file(m_file);
-// 		agentClass = result.attr(m_class.c_str());
-// 	}
-
-// 	py::cpp_function nameStringFunction = [this]() {
-// 		return this->name();
-// 	};
-// 	//py::object nameStringObject = py::str(name());
-// 	agentClass.attr("name") = nameStringFunction;
-// 	m_instance = agentClass();
-
-// 	py::function fun = py::reinterpret_borrow<py::function>(m_instance.attr("configure"));
-// 	py::object _ret = fun(m_parameters);
-// }
-
-// #include <iostream>
-
-// void PythonAgent::receiveMessage(const MessagePtr& msg) {
-// 	py::function receiveMessageFunction = py::reinterpret_borrow<py::function>(m_instance.attr("receiveMessage"));
-// 	py::object _ret = receiveMessageFunction(simulation(), msg->type, py::dict()/*, msg.toDict()*/);
-// }
+#include "PythonAgent.h"
+
+#ifdef MAXE_WITH_PYTHON
+#include "Simulation.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "SimulationException.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <pybind11/stl.h>
+
+void definePythonAgentBindings(py::module& m) {
+	PYBIND11_NUMPY_DTYPE(PythonMessageRecord, occurrence, type, direction, orderId, restingOrderId, volume, price, bidPrice, bidVolume, askPrice, askVolume);
+	PYBIND11_NUMPY_DTYPE(PythonRequestRecord, type, direction, orderId, volume, price, delay);
+
+	m.attr("MESSAGE_DTYPE") = py::dtype::of<PythonMessageRecord>();
+	m.attr("REQUEST_DTYPE") = py::dtype::of<PythonRequestRecord>();
+
+	m.attr("BUY") = (uint32_t)OrderDirection::Buy;
+	m.attr("SELL") = (uint32_t)OrderDirection::Sell;
+
+	m.attr("MESSAGE_OTHER") = (uint32_t)PythonMessageType::Other;
+	m.attr("MESSAGE_SIMULATION_START") = (uint32_t)PythonMessageType::SimulationStart;
+	m.attr("MESSAGE_SIMULATION_STOP") = (uint32_t)PythonMessageType::SimulationStop;
+	m.attr("MESSAGE_WAKEUP") = (uint32_t)PythonMessageType::Wakeup;
+	m.attr("MESSAGE_L1") = (uint32_t)PythonMessageType::L1;
+	m.attr("MESSAGE_LIMIT_ORDER_PLACED") = (uint32_t)PythonMessageType::LimitOrderPlaced;
+	m.attr("MESSAGE_MARKET_ORDER_PLACED") = (uint32_t)PythonMessageType::MarketOrderPlaced;
+	m.attr("MESSAGE_ORDER_CANCELLED") = (uint32_t)PythonMessageType::OrderCancelled;
+	m.attr("MESSAGE_TRADE") = (uint32_t)PythonMessageType::Trade;
+	m.attr("MESSAGE_LIMIT_ORDER_EVENT") = (uint32_t)PythonMessageType::LimitOrderEvent;
+	m.attr("MESSAGE_MARKET_ORDER_EVENT") = (uint32_t)PythonMessageType::MarketOrderEvent;
+
+	m.attr("REQUEST_PLACE_LIMIT_ORDER") = (uint32_t)PythonRequestType::PlaceLimitOrder;
+	m.attr("REQUEST_PLACE_MARKET_ORDER") = (uint32_t)PythonRequestType::PlaceMarketOrder;
+	m.attr("REQUEST_CANCEL_ORDER") = (uint32_t)PythonRequestType::CancelOrder;
+	m.attr("REQUEST_RETRIEVE_L1") = (uint32_t)PythonRequestType::RetrieveL1;
+	m.attr("REQUEST_WAKEUP") = (uint32_t)PythonRequestType::Wakeup;
+	m.attr("REQUEST_SUBSCRIBE_TRADES") = (uint32_t)PythonRequestType::SubscribeTrades;
+	m.attr("REQUEST_SUBSCRIBE_ORDER_TRADES") = (uint32_t)PythonRequestType::SubscribeOrderTrades;
+	m.attr("REQUEST_SUBSCRIBE_LIMIT_ORDERS") = (uint32_t)PythonRequestType::SubscribeLimitOrders;
+	m.attr("REQUEST_SUBSCRIBE_MARKET_ORDERS") = (uint32_t)PythonRequestType::SubscribeMarketOrders;
+}
+
+PythonAgent::PythonAgent(const Simulation* simulation, const std::string& pythonClass, const std::string& file)
+	: Agent(simulation), m_class(pythonClass), m_file(file), m_exchange(""), m_batchPending(false) { }
+
+PythonAgent::PythonAgent(const Simulation* simulation, const std::string& name)
+	: Agent(simulation, name), m_class(""), m_file(""), m_exchange(""), m_batchPending(false) { }
+
+PythonAgent::~PythonAgent() {
+	if (!Py_IsInitialized()) {
+		// the interpreter is gone already, the references can only be leaked
+		m_receiveMessages.release();
+		m_instance.release();
+		return;
+	}
+
+	py::gil_scoped_acquire acquire;
+	m_receiveMessages = py::object();
+	m_instance = py::object();
+}
+
+void PythonAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	Agent::configure(node, configurationPath);
+
+	pugi::xml_attribute att;
+	if (!(att = node.attribute("exchange")).empty()) {
+		m_exchange = simulation()->parameters().processString(att.as_string());
+	}
+
+	py::gil_scoped_acquire acquire;
+
+	py::dict parameters;
+	for (const pugi::xml_attribute& attr : node.attributes()) {
+		if (std::string(attr.name()) != "file" && std::string(attr.name()) != "name") {
+			parameters[attr.name()] = simulation()->parameters().processString(attr.as_string());
+		}
+	}
+
+	try {
+		py::object agentClass;
+		if (m_file == "") {
+			agentClass = py::module::import(m_class.c_str()).attr(m_class.c_str());
+		} else {
+			py::dict scope;
+			scope["__file__"] = m_file;
+			py::eval_file(m_file, scope);
+			agentClass = scope[m_class.c_str()];
+		}
+
+		m_instance = agentClass();
+
+		const std::string agentName = name();
+		m_instance.attr("name") = py::cpp_function([agentName]() { return agentName; });
+
+		if (py::hasattr(m_instance, "configure")) {
+			m_instance.attr("configure")(parameters);
+		}
+		m_receiveMessages = m_instance.attr("receiveMessages");
+	} catch (const py::error_already_set& e) {
+		throw SimulationException("PythonAgent::configure(): failed to set up the Python class '" + m_class + "': " + e.what());
+	}
+}
+
+void PythonAgent::receiveMessage(const MessagePtr& msg) {
+	appendRecords(msg);
+
+	if (!m_batchPending) {
+		m_batchPending = true;
+		simulation()->deferToEndOfTimestamp(this);
+	}
+}
+
+void PythonAgent::endOfTimestamp() {
+	m_batchPending = false;
+	if (m_inbox.empty()) {
+		return;
+	}
+
+	{
+		py::gil_scoped_acquire acquire;
+
+		// the array borrows the inbox, the capsule only marks it as not owning the memory
+		py::array messages(py::dtype::of<PythonMessageRecord>(), { (py::ssize_t)m_inbox.size() }, { (py::ssize_t)sizeof(PythonMessageRecord) }, m_inbox.data(), py::capsule(m_inbox.data(), [](void*) { }));
+		messages.attr("setflags")(py::arg("write") = false);
+
+		try {
+			py::object result = m_receiveMessages(simulation()->currentTimestamp(), messages);
+			if (!result.is_none()) {
+				auto requests = py::array_t<PythonRequestRecord, py::array::c_style | py::array::forcecast>::ensure(result);
+				if (!requests || requests.ndim() != 1) {
+					throw SimulationException("PythonAgent::endOfTimestamp(): '" + name() + "' returned something else than a 1-dimensional array of REQUEST_DTYPE");
+				}
+
+				m_outbox.assign(requests.data(), requests.data() + requests.size());
+			}
+		} catch (const py::error_already_set& e) {
+			throw SimulationException("PythonAgent::endOfTimestamp(): '" + name() + "' raised: " + e.what());
+		}
+	}
+
+	m_inbox.clear();
+	dispatchRequests();
+}
+
+void PythonAgent::appendRecords(const MessagePtr& msg) {
+	PythonMessageRecord record = {};
+	record.occurrence = msg->occurrence;
+
+	if (msg->type == "RESPONSE_RETRIEVE_L1") {
+		auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(msg->payload);
+		record.type = (uint32_t)PythonMessageType::L1;
+		record.bidPrice = (double)pptr->bestBidPrice;
+		record.bidVolume = pptr->bestBidVolume;
+		record.askPrice = (double)pptr->bestAskPrice;
+		record.askVolume = pptr->bestAskVolume;
+	} else if (msg->type == "EVENT_TRADE") {
+		const Trade& trade = std::dynamic_pointer_cast<EventTradePayload>(msg->payload)->trade;
+		record.type = (uint32_t)PythonMessageType::Trade;
+		record.direction = (uint32_t)trade.direction();
+		record.orderId = trade.aggressingOrderID();
+		record.restingOrderId = trade.restingOrderID();
+		record.volume = trade.volume();
+		record.price = (double)trade.price();
+	} else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
+		auto pptr = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(msg->payload);
+		record.type = (uint32_t)PythonMessageType::LimitOrderPlaced;
+		record.orderId = pptr->id;
+		record.direction = (uint32_t)pptr->requestPayload->direction;
+		record.volume = pptr->requestPayload->volume;
+		record.price = (double)pptr->requestPayload->price;
+	} else if (msg->type == "RESPONSE_PLACE_ORDER_MARKET") {
+		auto pptr = std::dynamic_pointer_cast<PlaceOrderMarketResponsePayload>(msg->payload);
+		record.type = (uint32_t)PythonMessageType::MarketOrderPlaced;
+		record.orderId = pptr->id;
+		record.direction = (uint32_t)pptr->requestPayload->direction;
+		record.volume = pptr->requestPayload->volume;
+	} else if (msg->type == "RESPONSE_CANCEL_ORDERS") {
+		auto pptr = std::dynamic_pointer_cast<CancelOrdersPayload>(msg->payload);
+		record.type = (uint32_t)PythonMessageType::OrderCancelled;
+		for (const auto& cancellation : pptr->cancellations) {
+			record.orderId = cancellation.id;
+			record.volume = cancellation.volume;
+			m_inbox.push_back(record);
+		}
+		return;
+	} else if (msg->type == "EVENT_ORDER_LIMIT") {
+		const LimitOrder& order = std::dynamic_pointer_cast<EventOrderLimitPayload>(msg->payload)->order;
+		record.type = (uint32_t)PythonMessageType::LimitOrderEvent;
+		record.orderId = order.id();
+		record.direction = (uint32_t)order.direction();
+		record.volume = order.volume();
+		record.price = (double)order.price();
+	} else if (msg->type == "EVENT_ORDER_MARKET") {
+		const MarketOrder& order = std::dynamic_pointer_cast<EventOrderMarketPayload>(msg->payload)->order;
+		record.type = (uint32_t)PythonMessageType::MarketOrderEvent;
+		record.orderId = order.id();
+		record.direction = (uint32_t)order.direction();
+		record.volume = order.volume();
+	} else if (msg->type == "WAKEUP_FOR_PYTHON") {
+		record.type = (uint32_t)PythonMessageType::Wakeup;
+	} else if (msg->type == "EVENT_SIMULATION_START") {
+		record.type = (uint32_t)PythonMessageType::SimulationStart;
+	} else if (msg->type == "EVENT_SIMULATION_STOP") {
+		record.type = (uint32_t)PythonMessageType::SimulationStop;
+	} else {
+		record.type = (uint32_t)PythonMessageType::Other;
+	}
+
+	m_inbox.push_back(record);
+}
+
+void PythonAgent::dispatchRequests() {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	std::shared_ptr<CancelOrdersPayload> cancellations;
+	for (const PythonRequestRecord& request : m_outbox) {
+		const Timestamp delay = std::max<Timestamp>(request.delay, 1);
+		if (request.direction > (uint32_t)OrderDirection::Sell) {
+			throw SimulationException("PythonAgent::dispatchRequests(): '" + name() + "' requested an unknown order direction " + std::to_string(request.direction));
+		}
+		const OrderDirection direction = (OrderDirection)request.direction;
+
+		switch ((PythonRequestType)request.type) {
+		case PythonRequestType::PlaceLimitOrder:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "PLACE_ORDER_LIMIT", std::make_shared<PlaceOrderLimitPayload>(direction, request.volume, Money(request.price)));
+			break;
+		case PythonRequestType::PlaceMarketOrder:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "PLACE_ORDER_MARKET", std::make_shared<PlaceOrderMarketPayload>(direction, request.volume));
+			break;
+		case PythonRequestType::CancelOrder:
+			// gathered into a single CANCEL_ORDERS message, sent with the delay of the first cancellation
+			if (cancellations == nullptr) {
+				cancellations = std::make_shared<CancelOrdersPayload>();
+				simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "CANCEL_ORDERS", cancellations);
+			}
+			cancellations->cancellations.push_back(CancelOrdersCancellation(request.orderId, request.volume == 0 ? std::numeric_limits<Volume>::max() : request.volume));
+			break;
+		case PythonRequestType::RetrieveL1:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+			break;
+		case PythonRequestType::Wakeup:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), name(), "WAKEUP_FOR_PYTHON", std::make_shared<EmptyPayload>());
+			break;
+		case PythonRequestType::SubscribeTrades:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "SUBSCRIBE_EVENT_TRADE", std::make_shared<EmptyPayload>());
+			break;
+		case PythonRequestType::SubscribeOrderTrades:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_TRADE", std::make_shared<SubscribeEventTradeByOrderPayload>(request.orderId));
+			break;
+		case PythonRequestType::SubscribeLimitOrders:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_LIMIT", std::make_shared<EmptyPayload>());
+			break;
+		case PythonRequestType::SubscribeMarketOrders:
+			simulation()->dispatchMessage(currentTimestamp, delay, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_MARKET", std::make_shared<EmptyPayload>());
+			break;
+		default:
+			throw SimulationException("PythonAgent::dispatchRequests(): '" + name() + "' requested an unknown request type " + std::to_string(request.type));
+		}
+	}
+
+	m_outbox.clear();
+}
+#endif
@@ -1,23 +1,99 @@
-// #pragma once
-// #include "Agent.h"
-// #include <map>
+#pragma once
+#include "Agent.h"
 
-// #include <pybind11/embed.h>
-// namespace py = pybind11;
+#include <cstdint>
+#include <vector>
 
-// class PythonAgent : public Agent {
-// public:
-// 	PythonAgent(const Simulation* simulation, const std::string& pythonClass, const std::string& file);
-// 	PythonAgent(const Simulation* simulation, const std::string& name);
+// Python agents are only available when the parent project provides pybind11, see CMakeLists.txt
+#ifdef MAXE_WITH_PYTHON
+#include <pybind11/embed.h>
+#include <pybind11/numpy.h>
+namespace py = pybind11;
 
-// 	void configure(const pugi::xml_node& node, const std::string& configurationPath);
+// what a PythonMessageRecord describes, the record fields that do not apply to the type are zero
+enum class PythonMessageType : uint32_t {
+	Other,
+	SimulationStart,
+	SimulationStop,
+	Wakeup,
+	L1,                 // bidPrice, bidVolume, askPrice, askVolume
+	LimitOrderPlaced,   // orderId, direction, volume, price
+	MarketOrderPlaced,  // orderId, direction, volume
+	OrderCancelled,     // orderId, volume (left in the book), one record per cancellation
+	Trade,              // orderId (aggressing), restingOrderId, direction, volume, price
+	LimitOrderEvent,    // orderId, direction, volume, price
+	MarketOrderEvent    // orderId, direction, volume
+};
 
-// 	// Inherited via Agent
-// 	void receiveMessage(const MessagePtr& msg) override;
-// private:
-// 	std::string m_class;
-// 	std::string m_file;
-// 	std::map<std::string, std::string> m_parameters;
+// one message received by a Python agent, exposed to Python as a row of a NumPy structured array
+struct PythonMessageRecord {
+	uint64_t occurrence;
+	uint32_t type;
+	uint32_t direction;
+	uint64_t orderId;
+	uint64_t restingOrderId;
+	uint64_t volume;
+	double price;
+	double bidPrice;
+	uint64_t bidVolume;
+	double askPrice;
+	uint64_t askVolume;
+};
 
-// 	py::object m_instance;
-// };
+enum class PythonRequestType : uint32_t {
+	PlaceLimitOrder,        // direction, volume, price
+	PlaceMarketOrder,       // direction, volume
+	CancelOrder,            // orderId, volume (0 cancels the whole order)
+	RetrieveL1,
+	Wakeup,                 // delay
+	SubscribeTrades,
+	SubscribeOrderTrades,   // orderId
+	SubscribeLimitOrders,
+	SubscribeMarketOrders
+};
+
+// one request returned by a Python agent, every request is sent 'delay' (at least 1) after the current time
+struct PythonRequestRecord {
+	uint32_t type;
+	uint32_t direction;
+	uint64_t orderId;
+	uint64_t volume;
+	double price;
+	uint64_t delay;
+};
+
+// registers the record dtypes and the type constants, called once from the module initialization
+void definePythonAgentBindings(py::module& m);
+
+// Agent implemented by a Python class. The messages received during one timestamp are gathered as PythonMessageRecords
+// and handed over in a single call to receiveMessages(timestamp, messages) once the timestamp is over, the messages array
+// is a read-only view of the agent's buffer and is only valid for the duration of the call. The call may return an array
+// of PythonRequestRecords (or None), which are translated to messages to the configured exchange. The GIL is held for
+// the duration of one such call only.
+class PythonAgent : public Agent {
+public:
+	PythonAgent(const Simulation* simulation, const std::string& pythonClass, const std::string& file);
+	PythonAgent(const Simulation* simulation, const std::string& name);
+	~PythonAgent();
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	// Inherited via Agent
+	void receiveMessage(const MessagePtr& msg) override;
+	void endOfTimestamp() override;
+private:
+	std::string m_class;
+	std::string m_file;
+	std::string m_exchange;
+
+	py::object m_instance;
+	py::object m_receiveMessages;
+
+	std::vector<PythonMessageRecord> m_inbox;
+	std::vector<PythonRequestRecord> m_outbox;
+	bool m_batchPending;
+
+	void appendRecords(const MessagePtr& msg);
+	void dispatchRequests();
+};
+#endif
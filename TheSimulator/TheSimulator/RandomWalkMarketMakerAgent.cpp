@@ -55,43 +55,7 @@ void RandomWalkMarketMakerAgent::receiveMessage(const MessagePtr& msg) {
 
 	if (msg->type == "EVENT_SIMULATION_START") {
 		// trigger immediate market making
-		simulation()->dispatchMessage(currentTimestamp, 0, this->name(), this->name(), "WAKEUP_FOR_MARKETMAKING", std::make_shared<EmptyPayload>());
-	} else if (msg->type == "WAKEUP_FOR_MARKETMAKING") {
-		// cancel the outstanding orders
-		auto cpptr = std::make_shared<CancelOrdersPayload>();
-		if (m_outstandingBuyOrder != 0) {
-			cpptr->cancellations.push_back(CancelOrdersCancellation(m_outstandingBuyOrder, m_depth));
-		}
-		if (m_outstandingSellOrder != 0) {
-			cpptr->cancellations.push_back(CancelOrdersCancellation(m_outstandingSellOrder, m_depth));
-		}
-		if (cpptr->cancellations.size() > 0) {
-			simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "CANCEL_ORDERS", cpptr);
-		}
-
-		// walk a step
-		std::bernoulli_distribution stepTypeDistribution(m_p);
-		Money step = stepTypeDistribution(simulation()->randomGenerator()) ? m_priceStep : -m_priceStep;
-		m_currentMidPrice += step;
-		if (m_currentMidPrice < m_lb) {
-			m_currentMidPrice = m_lb;
-		}
-		if (m_currentMidPrice > m_ub) {
-			m_currentMidPrice = m_ub;
-		}
-
-		// place new orders
-		Money newSellPrice = m_currentMidPrice + m_halfSpread;
-		Money newBuyPrice = m_currentMidPrice - m_halfSpread;
-
-		auto pptr = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, m_depth, newSellPrice);
-		simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
-
-		pptr = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Buy, m_depth, newBuyPrice);
-		simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
-
-		// schedule next marketMaking
-		scheduleMarketMaking();
+		simulation()->scheduleWakeup(this, currentTimestamp);
 	} else if (msg->type == "RESPONSE_PLACE_ORDER_LIMIT") {
 		auto payload = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(msg->payload);
 		if (payload->requestPayload->direction == OrderDirection::Buy) {
@@ -102,7 +66,47 @@ void RandomWalkMarketMakerAgent::receiveMessage(const MessagePtr& msg) {
 	}
 }
 
+void RandomWalkMarketMakerAgent::receiveWakeup(WakeupTag /*tag*/) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	// cancel the outstanding orders
+	auto cpptr = std::make_shared<CancelOrdersPayload>();
+	if (m_outstandingBuyOrder != 0) {
+		cpptr->cancellations.push_back(CancelOrdersCancellation(m_outstandingBuyOrder, m_depth));
+	}
+	if (m_outstandingSellOrder != 0) {
+		cpptr->cancellations.push_back(CancelOrdersCancellation(m_outstandingSellOrder, m_depth));
+	}
+	if (cpptr->cancellations.size() > 0) {
+		simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "CANCEL_ORDERS", cpptr);
+	}
+
+	// walk a step
+	std::bernoulli_distribution stepTypeDistribution(m_p);
+	Money step = stepTypeDistribution(simulation()->randomGenerator()) ? m_priceStep : -m_priceStep;
+	m_currentMidPrice += step;
+	if (m_currentMidPrice < m_lb) {
+		m_currentMidPrice = m_lb;
+	}
+	if (m_currentMidPrice > m_ub) {
+		m_currentMidPrice = m_ub;
+	}
+
+	// place new orders
+	Money newSellPrice = m_currentMidPrice + m_halfSpread;
+	Money newBuyPrice = m_currentMidPrice - m_halfSpread;
+
+	auto pptr = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, m_depth, newSellPrice);
+	simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
+
+	pptr = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Buy, m_depth, newBuyPrice);
+	simulation()->dispatchMessage(currentTimestamp, 0, this->name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
+
+	// schedule next marketMaking
+	scheduleMarketMaking();
+}
+
 void RandomWalkMarketMakerAgent::scheduleMarketMaking() {
 	const Timestamp currentTimestamp = simulation()->currentTimestamp();
-	simulation()->dispatchMessage(currentTimestamp, m_timeStep, this->name(), this->name(), "WAKEUP_FOR_MARKETMAKING", std::make_shared<EmptyPayload>());
+	simulation()->scheduleWakeup(this, currentTimestamp + m_timeStep);
 }
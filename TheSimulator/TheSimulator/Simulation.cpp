@@ -1,23 +1,9 @@
 #include "Simulation.h"
 
-#include "ExchangeAgent.h"
-#include "TradeLogAgent.h"
-#include "OrderLogAgent.h"
-#include "L1LogAgent.h"
-#include "BouchaudAgent.h"
-#include "ImpactAgent.h"
-#include "SetupAgent.h"
-#include "AdaptiveOfferingAgent.h"
-#include "RandomWalkMarketMakerAgent.h"
-#include "DoobAgent.h"
-#include "AngusAgents/Noise.h"
-#include "AngusAgents/ExchangePopulator.h"
-#include "AngusAgents/DownwardShock.h"
-#include "AngusAgents/Fundamental.h"
-#include "AngusAgents/MarketMaker.h"
-#include "AngusAgents/Momentum.h"
-
-// #include "PythonAgent.h"
+#include "AgentFactory.h"
+#include "ExpandedConfiguration.h"
+
+#include "PythonAgent.h"
 
 #include <algorithm>
 #include <filesystem>
@@ -32,7 +18,7 @@ Simulation::Simulation(ParameterStorage* parameters)
 }
 
 Simulation::Simulation(ParameterStorage* parameters, Timestamp startTimestamp, Timestamp duration, const std::string& directory)
-	: IMessageable(this, "SIMULATION"), m_parameters(parameters), m_startTimestamp(startTimestamp), m_currentTimestamp(startTimestamp), m_durationTimestamp(duration), m_messageQueue(std::make_unique <std::priority_queue<MessagePtr, std::vector<MessagePtr>, CompareArrival>>()), m_state(SimulationState::INACTIVE), m_randomDevice(), m_randomGenerator(std::make_unique<std::mt19937>(m_randomDevice())) {
+	: IMessageable(this, "SIMULATION"), m_state(SimulationState::INACTIVE), m_startTimestamp(startTimestamp), m_durationTimestamp(duration), m_currentTimestamp(startTimestamp), m_deliveredMessageCount(0), m_parameters(parameters), m_randomDevice(), m_randomGenerator(std::make_unique<std::mt19937>(m_randomDevice())), m_messageQueue(std::make_unique <std::priority_queue<MessagePtr, std::vector<MessagePtr>, CompareArrival>>()), m_endOfTimestampAgents(std::make_unique<std::vector<Agent*>>()), m_wakeups(std::make_unique<std::vector<Wakeup>>()), m_topics(std::make_unique<std::vector<Topic>>()), m_topicIds(std::make_unique<std::unordered_map<std::string, TopicID>>()), m_latency(std::make_unique<LatencyRegistry>()) {
 }
 
 void Simulation::simulate() {
@@ -53,10 +39,165 @@ void Simulation::simulate(Timestamp howMuch) {
 		step(toSimulate);
 	}
 
-	this->stop();
+	// only stop once the whole duration has been covered, so that the simulation can be advanced in chunks
+	if (m_currentTimestamp >= m_startTimestamp + m_durationTimestamp) {
+		this->stop();
+	}
+}
+
+void Simulation::publish(Timestamp occurrence, Timestamp delay, const std::string& source, TopicID topic, const std::string& type, MessagePayloadPtr payload) const {
+	Topic& t = (*m_topics)[topic];
+	if (t.subscribers.empty()) {
+		return;
+	}
+
+	++t.publishedCount;
+	if (t.subscriberGroups.empty()) {
+		MessagePtr messagePtr(new Message(occurrence, occurrence + delay, source, topic, t.publishedCount, t.name, type, payload));
+		queueMessage(messagePtr);
+		if (!t.conflatingSubscribers.empty()) {
+			holdConflatedEvent(t, messagePtr);
+		}
+		return;
+	}
+
+	const LatencyGroupID sourceGroup = m_latency->group(source);
+	for (size_t i = 0; i < t.subscriberGroups.size(); ++i) {
+		const LatencyGroupID group = t.subscriberGroups[i];
+		// a shorter sample than the previous event's would overtake it, the group's events stay in sequence
+		const Timestamp arrival = std::max(occurrence + delay + m_latency->sample(sourceGroup, group), t.lastGroupArrivals[i]);
+		t.lastGroupArrivals[i] = arrival;
+		MessagePtr messagePtr(new Message(occurrence, arrival, source, topic, t.publishedCount, t.name, type, payload));
+		messagePtr->topicGroup = group;
+		messagePtr->latency = arrival - occurrence - delay;
+		queueMessage(messagePtr);
+		if (!t.conflatingSubscribers.empty()) {
+			holdConflatedEvent(t, messagePtr);
+		}
+	}
+}
+
+// in place of a sequence, the event on its way to a conflating subscriber is one held for it, sent on to it alone
+static constexpr uint64_t HELD_EVENT_IN_FLIGHT = UINT64_MAX;
+
+void Simulation::holdConflatedEvent(Topic& topic, const MessagePtr& messagePtr) const {
+	for (AgentHandle subscriber : topic.conflatingSubscribers) {
+		if (messagePtr->topicGroup != LATENCYGROUP_NONE && m_latency->group(subscriber) != messagePtr->topicGroup) {
+			continue;
+		}
+		if (topic.inFlightSequences[subscriber] == 0) {
+			topic.inFlightSequences[subscriber] = messagePtr->topicSequence;
+		} else {
+			topic.heldEvents[subscriber] = messagePtr;
+		}
+	}
+}
+
+void Simulation::sendHeldEvent(Topic& topic, AgentHandle subscriber) const {
+	MessagePtr heldPtr = std::move(topic.heldEvents[subscriber]);
+	if (heldPtr == nullptr) {
+		topic.inFlightSequences[subscriber] = 0;
+		return;
+	}
+
+	// the event goes out now and takes as long as its publishing would have, so it never arrives before that would
+	MessagePtr messagePtr(new Message(*heldPtr));
+	messagePtr->arrival = m_currentTimestamp + (heldPtr->arrival - heldPtr->occurrence);
+	messagePtr->targetHandle = subscriber;
+	topic.inFlightSequences[subscriber] = HELD_EVENT_IN_FLIGHT;
+	queueMessage(messagePtr);
+}
+
+TopicID Simulation::registerTopic(const std::string& name) const {
+	auto it = m_topicIds->find(name);
+	if (it != m_topicIds->end()) {
+		return it->second;
+	}
+
+	const TopicID topic = (TopicID)m_topics->size();
+	m_topics->push_back(Topic{ name, SubscriberSet(), SubscriberSet(), 0, std::vector<uint64_t>(), std::vector<uint64_t>(), std::vector<MessagePtr>(), std::vector<LatencyGroupID>(), std::vector<Timestamp>() });
+	m_topicIds->emplace(name, topic);
+	return topic;
+}
+
+bool Simulation::subscribeToTopic(TopicID topic, AgentHandle subscriber, bool conflate) const {
+	Topic& t = (*m_topics)[topic];
+	if (!t.subscribers.insert(subscriber)) {
+		return false;
+	}
+	if (conflate) {
+		t.conflatingSubscribers.insert(subscriber);
+		if (subscriber >= t.inFlightSequences.size()) {
+			t.inFlightSequences.resize((size_t)subscriber + 1, 0);
+			t.heldEvents.resize((size_t)subscriber + 1);
+		}
+	}
+	// the events in the queue already went out before the subscription
+	if (subscriber >= t.firstSequences.size()) {
+		t.firstSequences.resize((size_t)subscriber + 1, 0);
+	}
+	t.firstSequences[subscriber] = t.publishedCount + 1;
+
+	if (!m_latency->empty()) {
+		const LatencyGroupID group = m_latency->group(subscriber);
+		if (std::find(t.subscriberGroups.begin(), t.subscriberGroups.end(), group) == t.subscriberGroups.end()) {
+			t.subscriberGroups.push_back(group);
+			t.lastGroupArrivals.push_back(0);
+		}
+	}
+	return true;
+}
+
+void Simulation::scheduleWakeup(const Agent* agent, Timestamp at, WakeupTag tag) const {
+	m_wakeups->push_back(Wakeup{ std::max(at, m_currentTimestamp), agent->handle(), tag });
+	std::push_heap(m_wakeups->begin(), m_wakeups->end(), CompareWakeup());
+}
+
+AgentHandle Simulation::deliverWakeup() {
+	std::pop_heap(m_wakeups->begin(), m_wakeups->end(), CompareWakeup());
+	const Wakeup wakeup = m_wakeups->back();
+	m_wakeups->pop_back();
+
+	// the duplicates are next in the heap; a wakeup the agent schedules anew while being woken up is not one of them
+	while (!m_wakeups->empty() && !CompareWakeup()(m_wakeups->front(), wakeup)) {
+		std::pop_heap(m_wakeups->begin(), m_wakeups->end(), CompareWakeup());
+		m_wakeups->pop_back();
+	}
+
+	m_agentList[wakeup.agent]->receiveWakeup(wakeup.tag);
+	return wakeup.agent;
 }
 
 void Simulation::deliverMessage(const MessagePtr& messagePtr) {
+	if (messagePtr->targetHandle != AGENTHANDLE_INVALID) {
+		if (messagePtr->topic != TOPICID_INVALID) {
+			// a held event sent on to its conflating subscriber
+			sendHeldEvent((*m_topics)[messagePtr->topic], messagePtr->targetHandle);
+		}
+		m_agentList[messagePtr->targetHandle]->receiveMessage(messagePtr);
+		return;
+	}
+
+	if (messagePtr->topic != TOPICID_INVALID) {
+		Topic& topic = (*m_topics)[messagePtr->topic];
+		m_fanOut.assign(topic.subscribers.begin(), topic.subscribers.end());
+		for (AgentHandle subscriber : m_fanOut) {
+			if (messagePtr->topicSequence < topic.firstSequences[subscriber]
+				|| (messagePtr->topicGroup != LATENCYGROUP_NONE && m_latency->group(subscriber) != messagePtr->topicGroup)) {
+				continue;
+			}
+			if (topic.conflatingSubscribers.contains(subscriber)) {
+				// the events published while another was on its way to the subscriber are held for it instead
+				if (topic.inFlightSequences[subscriber] != messagePtr->topicSequence) {
+					continue;
+				}
+				sendHeldEvent(topic, subscriber);
+			}
+			m_agentList[subscriber]->receiveMessage(messagePtr);
+		}
+		return;
+	}
+
 	for (const std::string& target : messagePtr->targets) {
 		if (target == "*") {
 			receiveMessage(messagePtr);
@@ -98,6 +239,33 @@ void Simulation::deliverMessage(const MessagePtr& messagePtr) {
 	}
 }
 
+Agent* Simulation::findAgent(const std::string& name) const {
+	auto it = std::lower_bound(m_agentList.begin(), m_agentList.end(), name, [](const auto& agentPtr, const std::string& val) {
+		return agentPtr->name() < val;
+	});
+
+	return it != m_agentList.end() && (*it)->name() == name ? it->get() : nullptr;
+}
+
+AgentHandle Simulation::findAgentHandle(const std::string& name) const {
+	auto it = std::lower_bound(m_agentList.begin(), m_agentList.end(), name, [](const auto& agentPtr, const std::string& val) {
+		return agentPtr->name() < val;
+	});
+
+	return it != m_agentList.end() && (*it)->name() == name ? (AgentHandle)(it - m_agentList.begin()) : AGENTHANDLE_INVALID;
+}
+
+std::vector<MessagePtr> Simulation::peekMessages(size_t count) const {
+	std::vector<MessagePtr> messages;
+	auto queue = *m_messageQueue;
+	while (messages.size() < count && !queue.empty()) {
+		messages.push_back(queue.top());
+		queue.pop();
+	}
+
+	return messages;
+}
+
 void Simulation::receiveMessage(const MessagePtr& msg) {
 	// TODO: do something
 }
@@ -111,14 +279,59 @@ void Simulation::start() {
 
 void Simulation::step(Timestamp step) {
 	Timestamp cutoff = m_currentTimestamp + step;
+	m_breakpoints.resetHit();
+
+	Timestamp topMessageTimestamp = 0;
+	while (true) {
+		const bool hasMessage = !m_messageQueue->empty() && (topMessageTimestamp = m_messageQueue->top()->arrival) < cutoff;
+		// the wakeups of a timestamp come after its messages
+		const bool isWakeupNext = !m_wakeups->empty() && m_wakeups->front().at < cutoff
+			&& (!hasMessage || m_wakeups->front().at < topMessageTimestamp);
+		const Timestamp nextTimestamp = isWakeupNext ? m_wakeups->front().at : topMessageTimestamp;
+
+		// the deferred agents run before the time moves on, what they dispatch with no delay is still delivered in this timestamp
+		if (!m_endOfTimestampAgents->empty() && ((!hasMessage && !isWakeupNext) || nextTimestamp != m_currentTimestamp)) {
+			flushEndOfTimestamp();
+			continue;
+		}
+
+		if (isWakeupNext) {
+			m_currentTimestamp = nextTimestamp;
+			const AgentHandle woken = deliverWakeup();
+
+			// a wakeup of an exchange changes its book too, e.g. when good-till-date orders expire
+			if (!m_breakpoints.empty() && m_breakpoints.checkBooks(m_agentList[woken]->name())) {
+				return;
+			}
+			continue;
+		}
+
+		if (!hasMessage) {
+			break;
+		}
 
-	Timestamp topMessageTimestamp;
-	while (!m_messageQueue->empty() && (topMessageTimestamp = m_messageQueue->top()->arrival) < cutoff) {
 		m_currentTimestamp = topMessageTimestamp;
 
 		MessagePtr topMessage = m_messageQueue->top();
 		m_messageQueue->pop(); // ordering intentional
 		deliverMessage(topMessage);
+		++m_deliveredMessageCount;
+
+		// the time stays at the message that hit, the next step carries on with the rest of the timestamp
+		if (!m_breakpoints.empty() && m_breakpoints.check(*topMessage)) {
+			return;
+		}
+	}
+
+	m_currentTimestamp = cutoff;
+}
+
+void Simulation::flushEndOfTimestamp() {
+	// agents may defer themselves again while being flushed
+	std::vector<Agent*> agents;
+	agents.swap(*m_endOfTimestampAgents);
+	for (Agent* agent : agents) {
+		agent->endOfTimestamp();
 	}
 }
 
@@ -126,161 +339,167 @@ void Simulation::stop() {
 	m_state = SimulationState::STOPPED;
 }
 
-void Simulation::setupChildConfiguration(const pugi::xml_node& node, const std::string& configurationPath) {
+void Simulation::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	ExpandedConfiguration configuration;
+	configuration.configure(node, configurationPath);
+	configure(configuration);
+}
 
-	// Change this to scale up population of agents without changing XML file (For experiments)
-	int population_scale = 10;
+void Simulation::prepareBranching() {
+	for (const auto& agent : m_agentList) {
+		agent->prepareBranching();
+	}
+}
 
-	for (pugi::xml_node_iterator nit = node.begin(); nit != node.end(); ++nit) {
-		std::string nodeName = nit->name();
-		if (nodeName == "Generator") {
-			pugi::xml_attribute att;
-			std::string forwardPath = configurationPath;
-			if (!(att = nit->attribute("count")).empty()) {
-				ConfigurationIndex maxIndex = (ConfigurationIndex)att.as_uint();
-				for (ConfigurationIndex index = 1; index <= maxIndex; ++index) {
-					setupChildConfiguration(*nit, forwardPath + std::to_string(index));
+void Simulation::reseedBranch(std::mt19937::result_type seed) {
+	reseed(seed);
+	if (!m_latency->empty()) {
+		m_latency->reseed(seed);
+	}
+
+	for (const auto& agent : m_agentList) {
+		agent->beginBranch();
+	}
+}
+
+void Simulation::configure(const ExpandedConfiguration& configuration) {
+	if (configuration.hasStartTimestamp()) {
+		m_startTimestamp = configuration.startTimestamp();
+		m_currentTimestamp = m_startTimestamp;
+	}
+
+	if (configuration.hasDuration()) {
+		m_durationTimestamp = configuration.duration();
+	}
+
+	std::string seed;
+	if (m_parameters->tryGet("seed", seed)) {
+		reseed((std::mt19937::result_type)std::stoul(seed));
+	}
+
+	const AgentFactory& agentFactory = AgentFactory::instance();
+	m_agentList.reserve(configuration.entries().size());
+	for (size_t entryIndex = 0; entryIndex < configuration.entries().size(); ++entryIndex) {
+		const AgentNodeEntry& entry = configuration.entries()[entryIndex];
+		// the resolved copy lives as long as the agents configure from it
+		std::shared_ptr<const pugi::xml_document> resolvedDocument;
+		const pugi::xml_node node = configuration.resolvedNode(entryIndex, *m_parameters, resolvedDocument);
+		if (entry.kind == AgentNodeKind::Python) {
+#ifdef MAXE_WITH_PYTHON
+			// the class named after the node is taken from 'file', '<node>.py' or the Python path
+			pugi::xml_attribute att = node.attribute("file");
+			std::string filePath = "";
+			if (!att.empty()) {
+				filePath = m_parameters->processString(att.as_string());
+				if (!std::filesystem::exists(filePath)) {
+					throw SimulationException("Simulation::configure(): unrecognized node '"
+						+ entry.nodeName
+						+ "', tried looking into the file '"
+						+ filePath
+						+ "', but it does not exist"
+					);
 				}
+			} else if (std::filesystem::exists(entry.nodeName + ".py")) {
+				filePath = entry.nodeName + ".py";
 			}
-		} else if (nodeName == "ExchangeAgent") {
-			auto eaptr = std::make_unique<ExchangeAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "TradeLogAgent") {
-			auto eaptr = std::make_unique<TradeLogAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "OrderLogAgent") {
-			auto eaptr = std::make_unique<OrderLogAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "L1LogAgent") {
-			auto eaptr = std::make_unique<L1LogAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "BouchaudAgent") {
-			auto eaptr = std::make_unique<BouchaudAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "ImpactAgent") {
-			auto eaptr = std::make_unique<ImpactAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "SetupAgent") {
-			auto eaptr = std::make_unique<SetupAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "AdaptiveOfferingAgent") {
-			auto eaptr = std::make_unique<AdaptiveOfferingAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "RandomWalkMarketMakerAgent") {
-			auto eaptr = std::make_unique<RandomWalkMarketMakerAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "DoobAgent") {
-			auto eaptr = std::make_unique<DoobAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "NoiseAgent") {
-			for (int i = 0; i < population_scale; ++i) {
-				auto eaptr = std::make_unique<NoiseAgent>(this);
-				pugi::xml_attribute attr = nit->attribute("name");
-				std::stringstream ss;
-				ss << attr.value() << i;
-				attr.set_value(ss.str().c_str());
-				eaptr->configure(*nit, configurationPath);
-				m_agentList.push_back(std::move(eaptr));
-			}
-		} else if (nodeName == "DownwardShockAgent") {
-			auto eaptr = std::make_unique<DownwardShockAgent>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "FundamentalAgent") {
-			for (int i = 0; i < population_scale; ++i) {
-				auto eaptr = std::make_unique<FundamentalAgent>(this);
-				pugi::xml_attribute attr = nit->attribute("name");
-				std::stringstream ss;
-				ss << attr.value() << i;
-				attr.set_value(ss.str().c_str());
-				eaptr->configure(*nit, configurationPath);
-				m_agentList.push_back(std::move(eaptr));
-			}
-		} else if (nodeName == "MarketMakerAgent") {
-			for (int i = 0; i < population_scale; ++i) {
-				auto eaptr = std::make_unique<MarketMakerAgent>(this);
-				pugi::xml_attribute attr = nit->attribute("name");
-				std::stringstream ss;
-				ss << attr.value() << i;
-				attr.set_value(ss.str().c_str());
-				eaptr->configure(*nit, configurationPath);
-				m_agentList.push_back(std::move(eaptr));
-			}
-		} else if (nodeName == "MomentumAgent") {
-			for (int i = 0; i < population_scale; ++i) {
-				auto eaptr = std::make_unique<MomentumAgent>(this);
-				pugi::xml_attribute attr = nit->attribute("name");
-				std::stringstream ss;
-				ss << attr.value() << i;
-				attr.set_value(ss.str().c_str());
-				eaptr->configure(*nit, configurationPath);
-				m_agentList.push_back(std::move(eaptr));
+
+			auto agentPtr = std::make_unique<PythonAgent>(this, entry.nodeName, filePath);
+			agentPtr->configure(node, entry.configurationPath);
+			m_agentList.push_back(std::move(agentPtr));
+#endif
+			continue;
+		}
+
+		// a 'count' attribute turns the node into a population of agents suffixed 0..count-1
+		pugi::xml_attribute att;
+		if ((att = node.attribute("count")).empty()) {
+			auto agentPtr = agentFactory.create(entry.nodeName, this);
+			agentPtr->configure(node, entry.configurationPath);
+			m_agentList.push_back(std::move(agentPtr));
+			continue;
+		}
+
+		const ConfigurationIndex count = (ConfigurationIndex)std::stoul(m_parameters->processString(att.as_string()));
+		m_agentList.reserve(m_agentList.size() + count);
+		if (entry.kind == AgentNodeKind::Clonable) {
+			// the node is parsed once, every member of the population is a renamed copy of the prototype
+			auto prototypePtr = agentFactory.create(entry.nodeName, this);
+			prototypePtr->configure(node, entry.configurationPath);
+			const std::string baseName = prototypePtr->name();
+			for (ConfigurationIndex index = 0; index < count; ++index) {
+				m_agentList.push_back(agentFactory.clone(entry.nodeName, *prototypePtr, baseName + std::to_string(index)));
 			}
-		} else if (nodeName == "ExchangePopulator") {
-			auto eaptr = std::make_unique<ExchangePopulator>(this);
-			eaptr->configure(*nit, configurationPath);
-			m_agentList.push_back(std::move(eaptr));
-		} else if (nodeName == "PythonAgent") {
 		} else {
-		// 	pugi::xml_attribute att = node.attribute("file");
-		// 	if (!att.empty()) {
-		// 		std::string filePath = att.as_string();
-		// 		if (!std::filesystem::exists(filePath)) {
-		// 			throw SimulationException("Simulation::configure(): unrecognized node '" 
-		// 				+ nodeName 
-		// 				+ "', tried looking into the file '"
-		// 				+ filePath
-		// 				+ "', but it does not exist"
-		// 			);
-		// 		} else {
-		// 			auto eaptr = std::make_unique<PythonAgent>(this, nodeName, filePath);
-		// 			eaptr->configure(*nit, configurationPath);
-		// 			m_agentList.push_back(std::move(eaptr));
-		// 		}
-		// 	} else {
-		// 		std::string filePath = nodeName + ".py";
-		// 		if (!std::filesystem::exists(filePath)) {
-		// 			throw SimulationException("Simulation::configure(): unrecognized node '"
-		// 				+ nodeName
-		// 				+ "', tried looking into the file '"
-		// 				+ filePath
-		// 				+ "', but it does not exist"
-		// 			);
-		// 		} else {
-		// 			auto eaptr = std::make_unique<PythonAgent>(this, nodeName, "");
-		// 			eaptr->configure(*nit, configurationPath);
-		// 			m_agentList.push_back(std::move(eaptr));
-		// 		}
-		// 	}
+			for (ConfigurationIndex index = 0; index < count; ++index) {
+				auto agentPtr = agentFactory.create(entry.nodeName, this);
+				agentPtr->configure(node, entry.configurationPath + std::to_string(index));
+				m_agentList.push_back(std::move(agentPtr));
+			}
 		}
 	}
 
 	std::sort(m_agentList.begin(), m_agentList.end(), [](const auto& agentAPtr, const auto& agentBPtr) {
 		return agentAPtr->name() < agentBPtr->name();
 	});
+	for (size_t index = 0; index < m_agentList.size(); ++index) {
+		m_agentList[index]->m_handle = (AgentHandle)index;
+	}
+
+	if (!configuration.latency().empty()) {
+		configureLatency(configuration.latency());
+	}
 }
 
-#include <iostream>
+void Simulation::configureLatency(const pugi::xml_node& node) {
+	*m_latency = LatencyRegistry();
+	for (size_t index = 0; index < m_agentList.size(); ++index) {
+		m_latency->setGroup((AgentHandle)index, m_agentList[index]->name(), m_agentList[index]->latencyGroup());
+	}
 
-void Simulation::configure(const pugi::xml_node& node, const std::string& configurationPath) {
-	pugi::xml_attribute att;
-	if (!(att = node.attribute("start")).empty()) {
-		m_startTimestamp = (Timestamp)att.as_ullong();
+	for (pugi::xml_node linkNode : node.children("Link")) {
+		auto attribute = [this, &linkNode](const char* name) {
+			pugi::xml_attribute att = linkNode.attribute(name);
+			if (att.empty()) {
+				throw SimulationException("Simulation::configureLatency(): a <Link> is missing the attribute '" + std::string(name) + "'");
+			}
+			return m_parameters->processString(att.as_string());
+		};
+
+		const std::string model = attribute("model");
+		if (model == "constant") {
+			m_latency->addLink(attribute("source"), attribute("target"), LatencyModel::constant(std::stoull(attribute("delay"))));
+		} else if (model == "uniform") {
+			m_latency->addLink(attribute("source"), attribute("target"), LatencyModel::uniform(std::stoull(attribute("min")), std::stoull(attribute("max"))));
+		} else if (model == "lognormal") {
+			m_latency->addLink(attribute("source"), attribute("target"), LatencyModel::lognormal(std::stod(attribute("mu")), std::stod(attribute("sigma"))));
+		} else if (model == "empirical") {
+			std::vector<Timestamp> delays;
+			for (const std::string& delay : split(attribute("delays"), ',')) {
+				delays.push_back(std::stoull(delay));
+			}
+			std::vector<double> weights;
+			for (const std::string& weight : split(attribute("weights"), ',')) {
+				weights.push_back(std::stod(weight));
+			}
+			m_latency->addLink(attribute("source"), attribute("target"), LatencyModel::empirical(delays, weights));
+		} else {
+			throw SimulationException("Simulation::configureLatency(): unknown latency model '" + model + "'");
+		}
 	}
 
-	if (!(att = node.attribute("duration")).empty()) {
-		m_durationTimestamp = (Timestamp)att.as_ullong();
+	// the links draw from streams of their own, the agents' draws do not depend on the links
+	std::string seed;
+	m_latency->build(m_parameters->tryGet("seed", seed) ? std::stoull(seed) : ((uint64_t)m_randomDevice() << 32 | m_randomDevice()));
+}
+
+void Simulation::addLinkLatency(Message& message) const {
+	// a message to several agents (or all of them) or to its sender does not go over a link
+	if (message.targets.size() != 1 || message.targets[0] == message.source) {
+		return;
 	}
 
-	setupChildConfiguration(node, configurationPath);
+	const LatencyGroupID target = message.targetHandle != AGENTHANDLE_INVALID ? m_latency->group(message.targetHandle) : m_latency->group(message.targets[0]);
+	const Timestamp latency = m_latency->sample(m_latency->group(message.source), target);
+	message.arrival += latency;
+	message.latency = latency;
 }
@@ -6,16 +6,19 @@
 #include "Agent.h"
 #include "IConfigurable.h"
 #include "ParameterStorage.h"
+#include "BreakpointSet.h"
+#include "SubscriberSet.h"
+#include "LatencyModel.h"
 
+#include <cstdint>
 #include <string>
 #include <queue>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include <random>
-
-// #include <pybind11/embed.h>
-// namespace py = pybind11;
+#include <tuple>
 
 enum class SimulationState {
 	INACTIVE,
@@ -31,7 +34,44 @@ struct CompareArrival {
 	}
 };
 
+// A channel of events registered with the simulation: an event published on it is one message in the queue, handed to
+// every subscriber when it is delivered that was subscribed when it was published
+struct Topic {
+	std::string name;
+	SubscriberSet subscribers;
+	// the subscribers taking the latest event only: at most one event is on its way to each of them, the events published
+	// meanwhile are conflated into the latest of them, sent on to the subscriber alone once that one is delivered
+	SubscriberSet conflatingSubscribers;
+	uint64_t publishedCount;
+	// by subscriber handle, the sequence of the first event published after the subscription
+	std::vector<uint64_t> firstSequences;
+	// by conflating subscriber handle, the sequence of the published event on its way to it, 0 if none is, and the latest
+	// event published since, if any
+	std::vector<uint64_t> inFlightSequences;
+	std::vector<MessagePtr> heldEvents;
+	// the latency groups of the subscribers, only kept while the simulation has latency models, and the arrival of the
+	// latest event's message for each
+	std::vector<LatencyGroupID> subscriberGroups;
+	std::vector<Timestamp> lastGroupArrivals;
+};
+
+// An agent's wakeup as scheduled through Simulation::scheduleWakeup, 16 bytes where a self-addressed Message would take
+// hundreds with its strings
+struct Wakeup {
+	Timestamp at;
+	AgentHandle agent;
+	WakeupTag tag;
+};
+
+struct CompareWakeup {
+	bool operator()(const Wakeup& a, const Wakeup& b) const {
+		// return true if b comes before a, the equal wakeups of an agent come up in a row
+		return std::tie(a.at, a.agent, a.tag) > std::tie(b.at, b.agent, b.tag);
+	}
+};
+
 class ParameterStorage;
+class ExpandedConfiguration;
 
 class Simulation : public IMessageable, public IConfigurable {
 public:
@@ -43,42 +83,112 @@ public:
 	void simulate(Timestamp howMuch);
 
 	void queueMessage(const MessagePtr& messagePtr) const { m_messageQueue->push(messagePtr); }
+	// the dispatched messages arrive later by the latency of the link between their source and target, if it has a model
 	void dispatchMessage(Timestamp occurrence, Timestamp delay, const std::string& source, const std::string& target, const std::string& type, MessagePayloadPtr payload) const {
-		queueMessage(MessagePtr(new Message(occurrence, occurrence + delay, source, target, type, payload)));
+		queueMessageOverLink(MessagePtr(new Message(occurrence, occurrence + delay, source, target, type, payload)));
+	}
+	void dispatchMessage(Timestamp occurrence, Timestamp delay, const std::string& source, AgentHandle target, const std::string& type, MessagePayloadPtr payload) const {
+		queueMessageOverLink(MessagePtr(new Message(occurrence, occurrence + delay, source, target, m_agentList[target]->name(), type, payload)));
 	}
 	void dispatchGenericMessage(Timestamp occurrence, Timestamp delay, const std::string& source, const std::string& target, const std::string& type, const std::map<std::string, std::string>& payload) {
-		queueMessage(MessagePtr(new Message(occurrence, occurrence + delay, source, target, type, std::make_unique<GenericPayload>(payload))));
+		queueMessageOverLink(MessagePtr(new Message(occurrence, occurrence + delay, source, target, type, std::make_unique<GenericPayload>(payload))));
 	}
 
+	// one message for all the subscribers of the topic, delivered to the ones subscribed at its publishing; nothing is queued
+	// while the topic has no subscribers. With latency models, one message per latency group of the subscribers instead,
+	// each later by its own sample of the link from the source's group to the subscribers' one; a message never arrives
+	// before the one of the previous event for the same group, the messages arriving at the same time come in any order
+	void publish(Timestamp occurrence, Timestamp delay, const std::string& source, TopicID topic, const std::string& type, MessagePayloadPtr payload) const;
+	// the topic of the given name, registered on the first call with the name
+	TopicID registerTopic(const std::string& name) const;
+	// false if the agent is subscribed to the topic already
+	bool subscribeToTopic(TopicID topic, AgentHandle subscriber, bool conflate = false) const;
+	const Topic& topic(TopicID topic) const { return (*m_topics)[topic]; }
+
 	void deliverMessage(const MessagePtr& messagePtr);
+	// calls agent->receiveWakeup(tag) at the given time, after the messages arriving then; the wakeups of an agent with the
+	// same time and tag pending together are merged into one, a time already passed is taken as the current one
+	void scheduleWakeup(const Agent* agent, Timestamp at, WakeupTag tag = 0) const;
+	// the agent's endOfTimestamp() is called before the simulation time moves past the current timestamp
+	void deferToEndOfTimestamp(Agent* agent) const { m_endOfTimestampAgents->push_back(agent); }
 
 	SimulationState state() const { return m_state; }
+	Timestamp startTimestamp() const { return m_startTimestamp; }
+	Timestamp duration() const { return m_durationTimestamp; }
 	Timestamp currentTimestamp() const { return m_currentTimestamp; }
+	uint64_t deliveredMessageCount() const { return m_deliveredMessageCount; }
 	ParameterStorage& parameters() const { return *m_parameters; }
+	const std::vector<std::unique_ptr<Agent>>& agents() const { return m_agentList; }
+	// the agent of the given name, nullptr if there is none; the agents are only sorted by name once configured
+	Agent* findAgent(const std::string& name) const;
+	// the handle of the agent of the given name, AGENTHANDLE_INVALID if there is none; only valid once the agents are configured
+	AgentHandle findAgentHandle(const std::string& name) const;
+
+	// the interactive mode's breakpoints, a hit ends simulate() early at the message that hit
+	BreakpointSet& breakpoints() { return m_breakpoints; }
+	size_t pendingMessageCount() const { return m_messageQueue->size(); }
+	size_t pendingWakeupCount() const { return m_wakeups->size(); }
+	// the next (at most) count messages in the order of their delivery, copies the queue
+	std::vector<MessagePtr> peekMessages(size_t count) const;
 
 	std::mt19937 & randomGenerator() const { return *m_randomGenerator; };
+	void reseed(std::mt19937::result_type seed) { m_randomGenerator->seed(seed); }
+	// before forking the simulated prefix of a run into branches: the agents write out what they buffer themselves, so
+	// that it is not written again by every branch
+	void prepareBranching();
+	// in the process of a branch, once its parameters are set: reseeds the simulation's generator and the streams of the
+	// latency links, then has the agents drop the random numbers they drew ahead and move to the branch's outputs
+	void reseedBranch(std::mt19937::result_type seed);
 
 	// Inherited via IMessageable
 	virtual void receiveMessage(const MessagePtr& msg) override;
 
 	// Inherited via IConfigurable
 	virtual void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+	// creates the agents of a configuration expanded beforehand, which any number of runs can share
+	void configure(const ExpandedConfiguration& configuration);
 private:
 	SimulationState m_state;
 	void start();
 	void step(Timestamp step);
 	void stop();
+	void flushEndOfTimestamp();
+	// returns the agent woken up
+	AgentHandle deliverWakeup();
+	// the <Latency> element holds a <Link source="<group>" target="<group>" model="..."/> per link, with the attributes of its
+	// model: constant (delay), uniform (min, max), lognormal (mu, sigma) or empirical (delays, weights, comma separated)
+	void configureLatency(const pugi::xml_node& node);
+
+	void queueMessageOverLink(const MessagePtr& messagePtr) const {
+		if (!m_latency->empty()) {
+			addLinkLatency(*messagePtr);
+		}
+		queueMessage(messagePtr);
+	}
+	void addLinkLatency(Message& message) const;
+	// the event is on its way to the conflating subscribers of its latency group with none on its way yet, and held for the others
+	void holdConflatedEvent(Topic& topic, const MessagePtr& messagePtr) const;
+	// once the event on its way to a conflating subscriber is delivered, the one held for it goes out to it alone
+	void sendHeldEvent(Topic& topic, AgentHandle subscriber) const;
 
 	Timestamp m_startTimestamp;
 	Timestamp m_durationTimestamp;
 	Timestamp m_currentTimestamp;
+	uint64_t m_deliveredMessageCount;
 	ParameterStorage* m_parameters;
 
 	std::random_device m_randomDevice;
 	std::unique_ptr<std::mt19937> m_randomGenerator;
 
-	void setupChildConfiguration(const pugi::xml_node& node, const std::string& configurationPath);
-
 	std::unique_ptr<std::priority_queue<MessagePtr, std::vector<MessagePtr>, CompareArrival>> m_messageQueue;
 	std::vector<std::unique_ptr<Agent>> m_agentList;
+	std::unique_ptr<std::vector<Agent*>> m_endOfTimestampAgents;
+	// a binary heap, the next wakeup at the front
+	std::unique_ptr<std::vector<Wakeup>> m_wakeups;
+	std::unique_ptr<std::vector<Topic>> m_topics;
+	std::unique_ptr<std::unordered_map<std::string, TopicID>> m_topicIds;
+	// the subscribers a topic message is being delivered to, the topic's own list may change meanwhile
+	std::vector<AgentHandle> m_fanOut;
+	std::unique_ptr<LatencyRegistry> m_latency;
+	BreakpointSet m_breakpoints;
 };
@@ -0,0 +1,306 @@
+#include "StatsAgent.h"
+
+#include "Simulation.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "SimulationException.h"
+
+#include <filesystem>
+#include <iostream>
+
+StatsAgent::StatsAgent(const Simulation* simulation)
+	: StatsAgent(simulation, "") { }
+
+StatsAgent::StatsAgent(const Simulation* simulation, const std::string& name)
+	: Agent(simulation, name), m_aggregationPeriod(0), m_snapshotPeriod(0), m_outputPath(""), m_snapshotFile(),
+	m_tradeCount(0), m_lastPrice(0.0), m_totalVolume(0.0), m_totalNotional(0.0), m_signedVolume(0.0),
+	m_midPrice(std::numeric_limits<double>::quiet_NaN()), m_impactHorizon(0), m_isInBurst(false), m_lastShockTimestamp(0),
+	m_burstStartMidPrice(std::numeric_limits<double>::quiet_NaN()), m_burstCount(0) { }
+
+void StatsAgent::receiveMessage(const MessagePtr& messagePtr) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	if (messagePtr->type == "EVENT_SIMULATION_START") {
+		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_TRADE", std::make_shared<EmptyPayload>());
+		if (m_aggregationPeriod) {
+			simulation()->scheduleWakeup(this, currentTimestamp + m_aggregationPeriod, (WakeupTag)WakeupKind::Aggregation);
+		} else {
+			simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "SUBSCRIBE_EVENT_BOOK_DELTA", std::make_shared<EmptyPayload>());
+		}
+		if (!m_shockAgent.empty()) {
+			simulation()->dispatchMessage(currentTimestamp, 0, name(), m_shockAgent, "SUBSCRIBE_EVENT_SHOCK", std::make_shared<EmptyPayload>());
+		}
+		if (m_snapshotPeriod) {
+			writeSnapshotHeader();
+			simulation()->scheduleWakeup(this, currentTimestamp + m_snapshotPeriod, (WakeupTag)WakeupKind::Snapshot);
+		}
+	} else if (messagePtr->type == "EVENT_TRADE") {
+		const Trade& trade = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload)->trade;
+		const double price = (double)trade.price();
+		const double volume = (double)trade.volume();
+
+		if (m_tradeCount > 0 && m_lastPrice > 0.0 && price > 0.0) {
+			const double logReturn = std::log(price / m_lastPrice);
+			m_returns.add(logReturn);
+			m_returnAutocorrelation.add(logReturn);
+		}
+		++m_tradeCount;
+		m_lastPrice = price;
+		m_priceEwma.add(price);
+		m_rollingVwap.add(currentTimestamp, price, volume);
+		m_totalVolume += volume;
+		m_totalNotional += price * volume;
+
+		m_tradeSizes.add(volume);
+		m_tradeSizeEwma.add(volume);
+		m_tradeSizeDigest.add(volume);
+
+		// the direction of a trade is the direction of its aggressing order
+		const double signedVolume = trade.direction() == OrderDirection::Buy ? volume : -volume;
+		m_signedVolume += signedVolume;
+		m_orderFlowImbalanceEwma.add(signedVolume);
+	} else if (messagePtr->type == "EVENT_BOOK_DELTA") {
+		// the first batch is the snapshot of the resting orders, as adds
+		for (const BookDelta& delta : std::dynamic_pointer_cast<EventBookDeltaPayload>(messagePtr->payload)->deltas) {
+			applyBookDelta(delta);
+		}
+		const bool hasBid = !m_bidLevels.empty(), hasAsk = !m_askLevels.empty();
+		sampleL1(hasBid ? m_bidLevels.rbegin()->first : Money(0), hasBid ? m_bidLevels.rbegin()->second : 0,
+			hasAsk ? m_askLevels.begin()->first : Money(0), hasAsk ? m_askLevels.begin()->second : 0);
+	} else if (messagePtr->type == "RESPONSE_RETRIEVE_L1") {
+		auto pptr = std::dynamic_pointer_cast<RetrieveL1ResponsePayload>(messagePtr->payload);
+		sampleL1(pptr->bestBidPrice, pptr->bestBidVolume, pptr->bestAskPrice, pptr->bestAskVolume);
+	} else if (messagePtr->type == "EVENT_SHOCK") {
+		if (!m_isInBurst) {
+			m_isInBurst = true;
+			m_burstStartMidPrice = m_midPrice;
+		}
+		m_lastShockTimestamp = currentTimestamp;
+		simulation()->scheduleWakeup(this, currentTimestamp + m_impactHorizon, (WakeupTag)WakeupKind::Impact);
+	} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+		if (m_outputPath.empty()) {
+			std::cout << name() << ": statistics at " << currentTimestamp << std::endl;
+			writeSummary(std::cout, currentTimestamp);
+		} else {
+			std::ofstream outputFile(m_outputPath);
+			writeSummary(outputFile, currentTimestamp);
+		}
+	}
+}
+
+void StatsAgent::receiveWakeup(WakeupTag tag) {
+	const Timestamp currentTimestamp = simulation()->currentTimestamp();
+
+	if (tag == (WakeupTag)WakeupKind::Aggregation) {
+		simulation()->dispatchMessage(currentTimestamp, 0, name(), m_exchange, "RETRIEVE_L1", std::make_shared<EmptyPayload>());
+		simulation()->scheduleWakeup(this, currentTimestamp + m_aggregationPeriod, (WakeupTag)WakeupKind::Aggregation);
+	} else if (tag == (WakeupTag)WakeupKind::Snapshot) {
+		writeSnapshot(currentTimestamp);
+		simulation()->scheduleWakeup(this, currentTimestamp + m_snapshotPeriod, (WakeupTag)WakeupKind::Snapshot);
+	} else if (tag == (WakeupTag)WakeupKind::Impact) {
+		// a later spike has moved the end of the burst
+		if (!m_isInBurst || currentTimestamp != m_lastShockTimestamp + m_impactHorizon) {
+			return;
+		}
+		m_isInBurst = false;
+		++m_burstCount;
+		if (!std::isnan(m_burstStartMidPrice) && !std::isnan(m_midPrice)) {
+			m_shockImpacts.add(m_midPrice - m_burstStartMidPrice);
+		}
+	}
+}
+
+void StatsAgent::applyBookDelta(const BookDelta& delta) {
+	std::map<Money, Volume>& levels = delta.direction == OrderDirection::Buy ? m_bidLevels : m_askLevels;
+	if (delta.type == BookDeltaType::Add) {
+		levels[delta.price] += delta.volume;
+	} else if (delta.type == BookDeltaType::LevelDelete) {
+		levels.erase(delta.price);
+	} else {
+		auto it = levels.find(delta.price);
+		if (it != levels.end()) {
+			it->second -= std::min(it->second, delta.volume);
+			if (it->second == 0) {
+				levels.erase(it);
+			}
+		}
+	}
+}
+
+void StatsAgent::sampleL1(Money bestBidPrice, Volume bestBidVolume, Money bestAskPrice, Volume bestAskVolume) {
+	// the spread is only defined while both sides of the book are quoted
+	if (bestAskVolume > 0 && bestBidVolume > 0) {
+		const double spread = (double)bestAskPrice - (double)bestBidPrice;
+		m_spreads.add(spread);
+		m_spreadEwma.add(spread);
+		m_spreadDigest.add(spread);
+		m_midPrice = 0.5 * ((double)bestAskPrice + (double)bestBidPrice);
+	}
+
+	const double quotedVolume = (double)bestBidVolume + (double)bestAskVolume;
+	if (quotedVolume > 0.0) {
+		m_l1ImbalanceEwma.add(((double)bestBidVolume - (double)bestAskVolume) / quotedVolume);
+	}
+}
+
+void StatsAgent::prepareBranching() {
+	m_snapshotFile.flush();
+}
+
+void StatsAgent::beginBranch() {
+	// the summary is only written at the end, the snapshots so far are the common prefix's
+	if (!m_outputPath.empty()) {
+		m_outputPath = branchOutputPath(m_outputPathTemplate, m_outputPath);
+	}
+
+	if (!m_snapshotPath.empty()) {
+		const std::string path = branchOutputPath(m_snapshotPathTemplate, m_snapshotPath);
+		if (path != m_snapshotPath) {
+			m_snapshotFile.close();
+			std::filesystem::copy_file(m_snapshotPath, path, std::filesystem::copy_options::overwrite_existing);
+			m_snapshotFile.open(path, std::ios::app);
+			m_snapshotPath = path;
+		}
+	}
+}
+
+void StatsAgent::writeSnapshotHeader() {
+	m_snapshotFile << "timestamp,trades,lastPrice,vwap,rollingVwap,returnMean,returnStdDev,returnAutocorrelation,"
+		"tradeSizeEwma,spreadEwma,spreadMedian,signedVolume,orderFlowImbalanceEwma,l1ImbalanceEwma,shockImpactMean" << std::endl;
+}
+
+void StatsAgent::writeSnapshot(Timestamp timestamp) {
+	m_snapshotFile << timestamp << ','
+		<< m_tradeCount << ','
+		<< m_lastPrice << ','
+		<< (m_totalVolume > 0.0 ? m_totalNotional / m_totalVolume : std::numeric_limits<double>::quiet_NaN()) << ','
+		<< m_rollingVwap.value(timestamp) << ','
+		<< m_returns.mean() << ','
+		<< m_returns.standardDeviation() << ','
+		<< m_returnAutocorrelation.value() << ','
+		<< m_tradeSizeEwma.value() << ','
+		<< m_spreadEwma.value() << ','
+		<< m_spreadDigest.quantile(0.5) << ','
+		<< m_signedVolume << ','
+		<< m_orderFlowImbalanceEwma.value() << ','
+		<< m_l1ImbalanceEwma.value() << ','
+		<< m_shockImpacts.mean() << '\n';
+}
+
+std::vector<std::pair<std::string, double>> StatsAgent::summary(Timestamp timestamp) {
+	std::vector<std::pair<std::string, double>> rows;
+	auto row = [&rows](const std::string& statistic, double value) {
+		rows.emplace_back(statistic, value);
+	};
+
+	row("timestamp", (double)timestamp);
+	row("trades", (double)m_tradeCount);
+	row("volume", m_totalVolume);
+	row("lastPrice", m_lastPrice);
+	row("priceEwma", m_priceEwma.value());
+	row("vwap", m_totalVolume > 0.0 ? m_totalNotional / m_totalVolume : std::numeric_limits<double>::quiet_NaN());
+	row("rollingVwap", m_rollingVwap.value(timestamp));
+
+	row("returnMean", m_returns.mean());
+	row("returnStdDev", m_returns.standardDeviation());
+	row("returnMin", m_returns.min());
+	row("returnMax", m_returns.max());
+	row("returnAutocorrelation", m_returnAutocorrelation.value());
+
+	row("tradeSizeMean", m_tradeSizes.mean());
+	row("tradeSizeStdDev", m_tradeSizes.standardDeviation());
+	row("tradeSizeEwma", m_tradeSizeEwma.value());
+	for (double q : { 0.5, 0.9, 0.99 }) {
+		row("tradeSizeP" + std::to_string((int)std::round(q * 100)), m_tradeSizeDigest.quantile(q));
+	}
+
+	row("spreadSamples", (double)m_spreads.count());
+	row("spreadMean", m_spreads.mean());
+	row("spreadStdDev", m_spreads.standardDeviation());
+	row("spreadMin", m_spreads.min());
+	row("spreadMax", m_spreads.max());
+	row("spreadEwma", m_spreadEwma.value());
+	for (double q : { 0.05, 0.25, 0.5, 0.75, 0.95, 0.99 }) {
+		row("spreadP" + std::to_string((int)std::round(q * 100)), m_spreadDigest.quantile(q));
+	}
+
+	row("signedVolume", m_signedVolume);
+	row("orderFlowImbalanceEwma", m_orderFlowImbalanceEwma.value());
+	row("l1ImbalanceEwma", m_l1ImbalanceEwma.value());
+
+	row("shockBursts", (double)m_burstCount);
+	row("shockImpactMean", m_shockImpacts.mean());
+	row("shockImpactStdDev", m_shockImpacts.standardDeviation());
+	row("shockImpactMin", m_shockImpacts.min());
+	row("shockImpactMax", m_shockImpacts.max());
+
+	return rows;
+}
+
+void StatsAgent::writeSummary(std::ostream& stream, Timestamp timestamp) {
+	const std::streamsize precision = stream.precision(10);
+	stream << "statistic,value\n";
+	for (const auto& row : summary(timestamp)) {
+		stream << row.first << ',' << row.second << '\n';
+	}
+
+	stream.flush();
+	stream.precision(precision);
+}
+
+#include "ParameterStorage.h"
+
+void StatsAgent::configure(const pugi::xml_node& node, const std::string& configurationPath) {
+	Agent::configure(node, configurationPath);
+
+	pugi::xml_attribute att;
+	if (!(att = node.attribute("exchange")).empty()) {
+		m_exchange = simulation()->parameters().processString(att.as_string());
+	}
+
+	if (!(att = node.attribute("aggregationPeriod")).empty()) {
+		m_aggregationPeriod = std::stoull(simulation()->parameters().processString(att.as_string()));
+	}
+
+	if (!(att = node.attribute("outputFile")).empty()) {
+		m_outputPathTemplate = att.as_string();
+		m_outputPath = simulation()->parameters().processString(m_outputPathTemplate);
+	}
+
+	if (!(att = node.attribute("snapshotPeriod")).empty()) {
+		m_snapshotPeriod = std::stoull(simulation()->parameters().processString(att.as_string()));
+	}
+
+	if (!(att = node.attribute("snapshotFile")).empty()) {
+		m_snapshotPathTemplate = att.as_string();
+		m_snapshotPath = simulation()->parameters().processString(m_snapshotPathTemplate);
+		m_snapshotFile.open(m_snapshotPath);
+		m_snapshotFile.precision(10);
+	} else if (m_snapshotPeriod) {
+		throw SimulationException("StatsAgent::configure(): '" + name() + "' has a 'snapshotPeriod' but no 'snapshotFile' to write the snapshots to");
+	}
+
+	if (!(att = node.attribute("shockAgent")).empty()) {
+		m_shockAgent = simulation()->parameters().processString(att.as_string());
+		if ((att = node.attribute("impactHorizon")).empty()) {
+			throw SimulationException("StatsAgent::configure(): '" + name() + "' has a 'shockAgent' but no 'impactHorizon' to measure the impact of its bursts at");
+		}
+		m_impactHorizon = std::stoull(simulation()->parameters().processString(att.as_string()));
+	}
+
+	if (!(att = node.attribute("ewmaAlpha")).empty()) {
+		const double alpha = std::stod(simulation()->parameters().processString(att.as_string()));
+		for (EwmaAccumulator* ewma : { &m_priceEwma, &m_tradeSizeEwma, &m_spreadEwma, &m_orderFlowImbalanceEwma, &m_l1ImbalanceEwma }) {
+			ewma->setAlpha(alpha);
+		}
+	}
+
+	if (!(att = node.attribute("compression")).empty()) {
+		const double compression = std::stod(simulation()->parameters().processString(att.as_string()));
+		m_tradeSizeDigest = TDigest(compression);
+		m_spreadDigest = TDigest(compression);
+	}
+
+	if (!(att = node.attribute("vwapWindow")).empty()) {
+		m_rollingVwap.setWindow(std::stoull(simulation()->parameters().processString(att.as_string())));
+	}
+}
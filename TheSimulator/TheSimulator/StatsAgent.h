@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Agent.h"
+#include "Book.h"
+#include "OnlineStatistics.h"
+
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Maintains statistics of an exchange's trades and L1 online, instead of logging the raw events for offline analysis:
+//  - trade log-returns: Welford mean/variance and lag-1 autocorrelation
+//  - trade prices: EWMA, VWAP over the whole simulation and over the last 'vwapWindow' time units
+//  - trade sizes and spreads: Welford, EWMA and t-digest quantiles
+//  - order flow imbalance: signed (buyer initiated minus seller initiated) trade volume, cumulative and EWMA
+//  - L1 volume imbalance (bid - ask) / (bid + ask) as an EWMA
+//  - realized impact of the bursts of the DownwardShockAgent 'shockAgent': the change of the mid price from before a
+//    burst to 'impactHorizon' time units after its last spike, spikes closer than that making one burst
+// A summary is written at EVENT_SIMULATION_STOP to 'outputFile' (stdout if not set), and if 'snapshotPeriod' is set, the
+// running statistics are written every 'snapshotPeriod' time units to 'snapshotFile'. The L1 is sampled every
+// 'aggregationPeriod' time units if that is set, otherwise it is read off a mirror of the price levels kept from the book
+// delta feed, once for every batch of deltas, which costs O(log levels) per delta and no request to the exchange.
+class StatsAgent : public Agent {
+public:
+	StatsAgent(const Simulation* simulation);
+	StatsAgent(const Simulation* simulation, const std::string& name);
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override;
+
+	// Inherited via Agent
+	void receiveMessage(const MessagePtr& msg) override;
+	void receiveWakeup(WakeupTag tag) override;
+	void prepareBranching() override;
+	void beginBranch() override;
+
+	// the statistics of the summary as of the given time, in the order they are written
+	std::vector<std::pair<std::string, double>> summary(Timestamp timestamp);
+private:
+	enum class WakeupKind : WakeupTag {
+		Aggregation,
+		Snapshot,
+		Impact
+	};
+
+	std::string m_exchange;
+	Timestamp m_aggregationPeriod;
+	Timestamp m_snapshotPeriod;
+	std::string m_outputPath;
+	std::string m_outputPathTemplate;
+	std::ofstream m_snapshotFile;
+	std::string m_snapshotPath;
+	std::string m_snapshotPathTemplate;
+
+	size_t m_tradeCount;
+	double m_lastPrice;
+	double m_totalVolume;
+	double m_totalNotional;
+	double m_signedVolume;
+
+	WelfordAccumulator m_returns;
+	LagOneAutocorrelation m_returnAutocorrelation;
+	EwmaAccumulator m_priceEwma;
+	RollingVwap m_rollingVwap;
+
+	WelfordAccumulator m_tradeSizes;
+	EwmaAccumulator m_tradeSizeEwma;
+	TDigest m_tradeSizeDigest;
+
+	WelfordAccumulator m_spreads;
+	EwmaAccumulator m_spreadEwma;
+	TDigest m_spreadDigest;
+
+	EwmaAccumulator m_orderFlowImbalanceEwma;
+	EwmaAccumulator m_l1ImbalanceEwma;
+
+	// the visible volume of every price level, from the book delta feed
+	std::map<Money, Volume> m_bidLevels;
+	std::map<Money, Volume> m_askLevels;
+	// the last one quoted on both sides, a shock emptying a side of the book leaves it as it was
+	double m_midPrice;
+
+	std::string m_shockAgent;
+	Timestamp m_impactHorizon;
+	bool m_isInBurst;
+	Timestamp m_lastShockTimestamp;
+	double m_burstStartMidPrice;
+	size_t m_burstCount;
+	WelfordAccumulator m_shockImpacts;
+
+	void applyBookDelta(const BookDelta& delta);
+	void sampleL1(Money bestBidPrice, Volume bestBidVolume, Money bestAskPrice, Volume bestAskVolume);
+
+	void writeSnapshotHeader();
+	void writeSnapshot(Timestamp timestamp);
+	void writeSummary(std::ostream& stream, Timestamp timestamp);
+};
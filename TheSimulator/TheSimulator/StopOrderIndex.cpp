@@ -0,0 +1,51 @@
+#include "StopOrderIndex.h"
+
+void StopOrderIndex::add(const StopOrder& order) {
+	m_ids[order.id] = std::make_pair(order.direction, order.stopPrice);
+	if (order.direction == OrderDirection::Buy) {
+		m_buyStops.emplace(order.stopPrice, order);
+	} else {
+		m_sellStops.emplace(order.stopPrice, order);
+	}
+}
+
+template<class Index>
+static bool removeFromIndex(Index& index, Money stopPrice, OrderID id) {
+	auto range = index.equal_range(stopPrice);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second.id == id) {
+			index.erase(it);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool StopOrderIndex::remove(OrderID id) {
+	auto it = m_ids.find(id);
+	if (it == m_ids.end()) {
+		return false;
+	}
+
+	const auto [direction, stopPrice] = it->second;
+	m_ids.erase(it);
+	return direction == OrderDirection::Buy ? removeFromIndex(m_buyStops, stopPrice, id) : removeFromIndex(m_sellStops, stopPrice, id);
+}
+
+void StopOrderIndex::collectTriggered(Money lowestTradePrice, Money highestTradePrice, std::vector<StopOrder>& triggered) {
+	// both indexes are ordered so that the triggered orders are a prefix
+	auto sellEnd = m_sellStops.upper_bound(lowestTradePrice);
+	for (auto it = m_sellStops.begin(); it != sellEnd; ++it) {
+		triggered.push_back(it->second);
+		m_ids.erase(it->second.id);
+	}
+	m_sellStops.erase(m_sellStops.begin(), sellEnd);
+
+	auto buyEnd = m_buyStops.upper_bound(highestTradePrice);
+	for (auto it = m_buyStops.begin(); it != buyEnd; ++it) {
+		triggered.push_back(it->second);
+		m_ids.erase(it->second.id);
+	}
+	m_buyStops.erase(m_buyStops.begin(), buyEnd);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Order.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A stop (or stop-limit) order held by the exchange until a trade reaches its stop price, it then enters the book as a
+// market (or limit) order of the owner
+struct StopOrder {
+	OrderID id;
+	std::string owner;
+	OrderDirection direction;
+	Volume volume;
+	Money stopPrice;
+	bool isLimit;
+	Money limitPrice;
+};
+
+// The pending stop orders of an exchange, indexed by stop price per direction: buy stops trigger on a trade at or above
+// their stop price, sell stops at or below it, so the orders a trade triggers are one range of the index. Finding them
+// is O(log n + triggered), cancelling an order O(log n).
+class StopOrderIndex {
+public:
+	bool empty() const { return m_ids.empty(); }
+	size_t size() const { return m_ids.size(); }
+
+	void add(const StopOrder& order);
+	// false if there is no such pending order
+	bool remove(OrderID id);
+
+	// removes the stop orders triggered by trades between the two prices and appends them to triggered, the sell stops
+	// from the highest stop price down and then the buy stops from the lowest up, in the order they came in among equals
+	void collectTriggered(Money lowestTradePrice, Money highestTradePrice, std::vector<StopOrder>& triggered);
+private:
+	std::multimap<Money, StopOrder> m_buyStops;
+	// the highest stop price first, as the first one a falling price reaches
+	std::multimap<Money, StopOrder, std::greater<Money>> m_sellStops;
+	// the stop price of every pending order, to find it for a cancellation
+	std::unordered_map<OrderID, std::pair<OrderDirection, Money>> m_ids;
+};
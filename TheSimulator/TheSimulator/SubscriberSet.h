@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Message.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// The subscribers of one kind of event, as the handles of the agents: contiguous in handle (and so name) order for the
+// notifications to walk, with a bitset over the handles for O(1) membership tests. The bitset only grows as far as the
+// highest handle subscribed.
+class SubscriberSet {
+public:
+	using const_iterator = std::vector<AgentHandle>::const_iterator;
+
+	bool empty() const { return m_handles.empty(); }
+	size_t size() const { return m_handles.size(); }
+	const_iterator begin() const { return m_handles.cbegin(); }
+	const_iterator end() const { return m_handles.cend(); }
+
+	bool contains(AgentHandle handle) const {
+		const size_t word = handle / 64;
+		return word < m_bits.size() && (m_bits[word] >> (handle % 64) & 1) != 0;
+	}
+
+	// false if the agent is subscribed already
+	bool insert(AgentHandle handle) {
+		if (contains(handle)) {
+			return false;
+		}
+
+		const size_t word = handle / 64;
+		if (word >= m_bits.size()) {
+			m_bits.resize(word + 1, 0);
+		}
+		m_bits[word] |= (uint64_t)1 << (handle % 64);
+		m_handles.insert(std::upper_bound(m_handles.begin(), m_handles.end(), handle), handle);
+		return true;
+	}
+
+	void clear() {
+		m_handles.clear();
+		std::fill(m_bits.begin(), m_bits.end(), 0);
+	}
+private:
+	std::vector<AgentHandle> m_handles;
+	std::vector<uint64_t> m_bits;
+};
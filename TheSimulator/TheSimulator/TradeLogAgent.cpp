@@ -6,10 +6,10 @@
 #include <iostream>
 
 TradeLogAgent::TradeLogAgent(const Simulation* simulation)
-	: Agent(simulation) { }
+	: Agent(simulation), m_outputFile(nullptr) { }
 
 TradeLogAgent::TradeLogAgent(const Simulation* simulation, const std::string& name)
-	: Agent(simulation, name) { }
+	: Agent(simulation, name), m_outputFile(nullptr) { }
 
 void TradeLogAgent::receiveMessage(const MessagePtr& messagePtr) {
 	const Timestamp currentTimestamp = simulation()->currentTimestamp();
@@ -19,6 +19,19 @@ void TradeLogAgent::receiveMessage(const MessagePtr& messagePtr) {
 	} else if (messagePtr->type == "EVENT_TRADE") {
 		auto pptr = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload);
 		const auto& trade = pptr->trade;
+
+		if (m_outputFile != nullptr) {
+			m_row.clear();
+			m_row.append(std::to_string(trade.id())).append(",")
+				.append(std::to_string(trade.timestamp())).append(",")
+				.append(std::to_string(trade.aggressingOrderID())).append(",")
+				.append(trade.direction() == OrderDirection::Sell ? "SELL" : "BUY").append(",")
+				.append(std::to_string(trade.restingOrderID())).append(",")
+				.append(std::to_string(trade.volume())).append(",")
+				.append(trade.price().toFullString()).append("\n");
+			m_outputFile->write(m_row);
+			return;
+		}
 		
 		std::cout << name() << ": ";
 		trade.printHuman();
@@ -35,4 +48,16 @@ void TradeLogAgent::configure(const pugi::xml_node& node, const std::string& con
 	if (!(att = node.attribute("exchange")).empty()) {
 		m_exchange = simulation()->parameters().processString(att.as_string());
 	}
-}
\ No newline at end of file
+
+	if (!(att = node.attribute("outputFile")).empty()) {
+		m_outputPathTemplate = att.as_string();
+		m_outputFile = AsyncLogWriter::instance().open(simulation()->parameters().processString(m_outputPathTemplate));
+		m_outputFile->write("id,timestamp,aggressingOrderId,direction,restingOrderId,volume,price\n");
+	}
+}
+
+void TradeLogAgent::beginBranch() {
+	if (m_outputFile != nullptr) {
+		m_outputFile = AsyncLogWriter::instance().branch(m_outputFile, branchOutputPath(m_outputPathTemplate, m_outputFile->path()));
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Agent.h"
+#include "AsyncLogWriter.h"
 
 class TradeLogAgent : public Agent {
 public:
@@ -11,6 +12,12 @@ public:
 
 	// Inherited via Agent
 	void receiveMessage(const MessagePtr& msg) override;
+	void beginBranch() override;
 private:
 	std::string m_exchange;
+
+	// CSV rows go to the 'outputFile' if given, human readable lines to stdout otherwise
+	LogStreamPtr m_outputFile;
+	std::string m_outputPathTemplate;
+	std::string m_row;
 };
@@ -1,17 +1,35 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
 
 #include "Simulation.h"
 #include "SimulationException.h"
 #include "ParameterStorage.h"
+#include "ParameterSweep.h"
+#include "ExpandedConfiguration.h"
+#include "AsyncLogWriter.h"
+#include "ExchangeAgent.h"
+#include "StatsAgent.h"
 
 #include "pugi/pugixml.hpp"
 #include "dimcli/cli.h"
 
-// #include <pybind11/embed.h> // everything needed for embedding
-// #include <pybind11/stl.h> // MUST BE
-// namespace py = pybind11;
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#ifdef MAXE_WITH_PYTHON
+#include <pybind11/embed.h> // everything needed for embedding
+namespace py = pybind11;
+#endif
 
 static bool silent = false;
 void trace(const std::string& msg);
@@ -20,11 +38,16 @@ void etrace(const std::string& msg);
 void etraceLine(const std::string& msg);
 
 void invokeInteractiveMode(Simulation* simulation);
-void runSimulations(std::pair<unsigned int, unsigned int> runIndexRange, bool interactive, pugi::xml_node configurationNode, const ParameterStorage& parameterBase);
+void runSimulations(std::pair<unsigned int, unsigned int> runIndexRange, bool interactive, const ExpandedConfiguration& configuration, const ParameterStorage& parameterBase);
+void runBranchedSimulations(unsigned int runCount, unsigned int processCount, Timestamp branchTimestamp, const ExpandedConfiguration& configuration, const ParameterStorage& parameterBase);
+void runSweep(const ParameterSweep& sweep, unsigned int threadCount, const ExpandedConfiguration& configuration, const ParameterStorage& parameterBase);
 
 int main(int argc, char* argv[]) {
-	// start the interpreter and keep it alive
-	// py::scoped_interpreter guard {};
+#ifdef MAXE_WITH_PYTHON
+	// start the interpreter and keep it alive, the GIL is released so that the Python agents of all threads can take it per batch
+	py::scoped_interpreter guard {};
+	py::gil_scoped_release release;
+#endif
 
 	// handle the command line argument parsing
 	Dim::Cli cli;
@@ -33,6 +56,8 @@ int main(int argc, char* argv[]) {
 	auto& silencio = cli.opt<bool>("s silent", false).desc("supresses all verbose trace output, error traces remain enabled");
 	auto& runCount = cli.opt<unsigned int>("r runs", 1).desc("Number of times the simulation is to be run");
 	auto& threadCount = cli.opt<unsigned int>("t threads", 1).desc("The maximum number of threads to use for evaluating different runs");
+	auto& branchAt = cli.opt<Timestamp>("b branch-at", 0).desc("Simulates the common prefix up to the given time once, then forks every run from that snapshot (Linux only)");
+	auto& sweepFile = cli.opt<std::string>("sweep", "").desc("Runs every point of the parameter sweep specified in the given file instead of --runs, see ParameterSweep.h");
 	auto& simParameters = cli.optVec<std::string>("[params]").desc("Parameters to be passed to the simulation configuration & the simulation itself");
 	if (!cli.parse(std::cerr, argc, argv)) {
 		return cli.exitCode();
@@ -49,6 +74,16 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 
+	if (*branchAt > 0 && *interactive) {
+		etraceLine("Error: can not branch runs in the interactive mode");
+		return 1;
+	}
+
+	if (!sweepFile->empty() && (*interactive || *branchAt > 0)) {
+		etraceLine("Error: a sweep can be combined neither with the interactive mode nor with branching");
+		return 1;
+	}
+
 	ParameterStorage parameterBase;
 	for (const std::string& simParamPair : *simParameters) {
 		auto pos = simParamPair.find('=');
@@ -86,6 +121,39 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 
+	// expand the generators and check the node names once, all runs create their agents from the same nodes
+	ExpandedConfiguration configuration;
+	try {
+		configuration.configure(node, "");
+	} catch (const SimulationException& ex) {
+		etraceLine(" - error: " + std::string(ex.what()));
+		return 1;
+	}
+
+	// parse the sweep specification, if any
+	ParameterSweep sweep;
+	if (!sweepFile->empty()) {
+		pugi::xml_document sweepDoc;
+		if (!sweepDoc.load_file(sweepFile->c_str())) {
+			etraceLine(" - error: could not parse the file '" + (*sweepFile) + "'");
+			return 1;
+		}
+
+		auto sweepNode = sweepDoc.child("Sweep");
+		if (sweepNode.empty()) {
+			etraceLine(" - error: when parsing '" + *sweepFile + "' - the 'Sweep' element was not found");
+			return 1;
+		}
+
+		try {
+			sweep.configure(sweepNode, "");
+		} catch (const SimulationException& ex) {
+			etraceLine(" - error: " + std::string(ex.what()));
+			return 1;
+		}
+		traceLine(" - '" + *sweepFile + "' loaded successfully, " + std::to_string(sweep.pointCount()) + " points x " + std::to_string(sweep.replicateCount()) + " replicates");
+	}
+
 	// distribute the loads among all threads
 	std::vector<std::pair<unsigned int, unsigned int>> loads;
 	loads.reserve(*threadCount);
@@ -106,16 +174,20 @@ int main(int argc, char* argv[]) {
 				traceLine(" - entering the interactive mode, type 'help' to retrieve the list of available commands");
 			}
 
-			if (loads.size() == 1) {
+			if (!sweepFile->empty()) {
+				runSweep(sweep, *threadCount, configuration, parameterBase);
+			} else if (*branchAt > 0) {
+				runBranchedSimulations(*runCount, *threadCount, *branchAt, configuration, parameterBase);
+			} else if (loads.size() == 1) {
 				auto start = std::chrono::high_resolution_clock::now();
-				runSimulations(loads.front(), *interactive, node, parameterBase);
+				runSimulations(loads.front(), *interactive, configuration, parameterBase);
 				auto end = std::chrono::high_resolution_clock::now();
 				std::chrono::duration<double> elapsed = end - start;
                 std::cout << "Duration: " << elapsed.count() << std::endl;
 			} else {
 				std::vector<std::unique_ptr<std::thread>> threads;
 				for (const auto& load : loads) {
-					threads.push_back(std::make_unique<std::thread>(runSimulations, load, false, node, parameterBase));
+					threads.push_back(std::make_unique<std::thread>(runSimulations, load, false, std::cref(configuration), std::cref(parameterBase)));
 				}
 
 				for (const auto& threadptr : threads) {
@@ -138,39 +210,135 @@ int main(int argc, char* argv[]) {
 
 #include <sstream>
 
+static void traceBreakpointHit(Simulation* simulation) {
+	const Breakpoint* hit = simulation->breakpoints().lastHit();
+	if (hit != nullptr) {
+		traceLine(" - breakpoint " + std::to_string(hit->id) + " hit at " + std::to_string(simulation->currentTimestamp()) + ": " + hit->description);
+	}
+}
+
 void invokeInteractiveMode(Simulation* simulation) { 
+	std::string lastCommandLine;
 	while (true) {
 		trace("r" + simulation->parameters()["runId"] + ":" + std::to_string(simulation->currentTimestamp()) + "> ");
 		std::string commandLine;
-		std::getline(std::cin, commandLine);
+		if (!std::getline(std::cin, commandLine)) {
+			break;
+		}
+
+		// an empty line repeats the last command, e.g. to keep stepping
+		if (commandLine.empty()) {
+			commandLine = lastCommandLine;
+		}
+		lastCommandLine = commandLine;
 
 		std::stringstream ss(commandLine);
 		std::string command;
 		std::getline(ss, command, ' ');
-		if (command == "help") { 
-			traceLine("\thelp\t\t\tdisplays this information");
-			traceLine("\tstop, exit\t\tstops the simulation and exits the program");
-			traceLine("\trun \t\t\tcontinues the simulation until it finishes");
-			traceLine("\tstep <step>\t\tsimulates over <step> time units");
-		} else if (command == "stop" || command == "exit") {
-			traceLine(" - simulation stopped, exiting");
-			break;
-		} else if (command == "run") { 
-			simulation->simulate();
-		} else if (command == "step") {
-			Timestamp step = 0;
-			ss >> step;
-			simulation->simulate(step);
+		try {
+			if (command == "help") { 
+				traceLine("\thelp\t\t\tdisplays this information");
+				traceLine("\tstop, exit\t\tstops the simulation and exits the program");
+				traceLine("\trun \t\t\tcontinues the simulation until it finishes or hits a breakpoint");
+				traceLine("\tstep <step>\t\tsimulates over <step> time units or until a breakpoint is hit");
+				traceLine("\tbreak <condition>\tsets a breakpoint, the conditions are");
+				traceLine("\t\t\t\t  type <message type>, agent <agent name>,");
+				traceLine("\t\t\t\t  spread <exchange> [symbol] >|< <price>,");
+				traceLine("\t\t\t\t  mid <exchange> [symbol] >|< <price>");
+				traceLine("\tbreakpoints\t\tlists the breakpoints");
+				traceLine("\tdelete <id>\t\tremoves a breakpoint");
+				traceLine("\tbook <exchange> [depth] [symbol]\n\t\t\t\tprints the book of an exchange's symbol, 0 by default");
+				traceLine("\tagents [prefix]\t\tlists the agents");
+				traceLine("\tagent <name>\t\tprints the state of an agent");
+				traceLine("\tqueue [count]\t\tprints the next messages to be delivered");
+				traceLine("\t<empty line>\t\trepeats the last command");
+			} else if (command == "stop" || command == "exit") {
+				traceLine(" - simulation stopped, exiting");
+				break;
+			} else if (command == "run") { 
+				simulation->simulate();
+				traceBreakpointHit(simulation);
+			} else if (command == "step") {
+				Timestamp step = 0;
+				ss >> step;
+				simulation->simulate(step);
+				traceBreakpointHit(simulation);
+			} else if (command == "break") {
+				std::string condition;
+				std::getline(ss, condition);
+				const unsigned int id = simulation->breakpoints().add(condition, *simulation);
+				traceLine(" - breakpoint " + std::to_string(id) + " set: " + condition);
+			} else if (command == "breakpoints") {
+				for (const Breakpoint& breakpoint : simulation->breakpoints().breakpoints()) {
+					traceLine("\t" + std::to_string(breakpoint.id) + "\t" + breakpoint.description);
+				}
+			} else if (command == "delete") {
+				unsigned int id = 0;
+				ss >> id;
+				if (!simulation->breakpoints().remove(id)) {
+					traceLine(" - there is no breakpoint " + std::to_string(id));
+				}
+			} else if (command == "book") {
+				std::string exchange;
+				unsigned int depth = 5;
+				SymbolID symbol = 0;
+				ss >> exchange >> depth >> symbol;
+				auto exchangePtr = dynamic_cast<ExchangeAgent*>(simulation->findAgent(exchange));
+				if (exchangePtr == nullptr || exchangePtr->book() == nullptr) {
+					traceLine(" - there is no exchange named '" + exchange + "'");
+				} else if (symbol >= exchangePtr->symbolCount()) {
+					traceLine(" - '" + exchange + "' does not host the symbol " + std::to_string(symbol));
+				} else {
+					exchangePtr->hostedBook(symbol)->printHuman(depth);
+				}
+			} else if (command == "agents") {
+				std::string prefix;
+				ss >> prefix;
+				for (const auto& agentPtr : simulation->agents()) {
+					if (agentPtr->name().compare(0, prefix.size(), prefix) == 0) {
+						traceLine("\t" + agentPtr->name());
+					}
+				}
+			} else if (command == "agent") {
+				std::string name;
+				ss >> name;
+				const Agent* agentPtr = simulation->findAgent(name);
+				if (agentPtr == nullptr) {
+					traceLine(" - there is no agent named '" + name + "'");
+				} else {
+					const auto pending = simulation->peekMessages(simulation->pendingMessageCount());
+					const auto queuedForAgent = std::count_if(pending.begin(), pending.end(), [&name](const MessagePtr& messagePtr) {
+						return std::find(messagePtr->targets.begin(), messagePtr->targets.end(), name) != messagePtr->targets.end();
+					});
+					traceLine(name + ": " + std::to_string(queuedForAgent) + " messages queued for the agent");
+					agentPtr->printState();
+				}
+			} else if (command == "queue") {
+				size_t count = 10;
+				ss >> count;
+				traceLine(std::to_string(simulation->pendingMessageCount()) + " messages queued");
+				for (const MessagePtr& messagePtr : simulation->peekMessages(count)) {
+					std::string targets;
+					for (const std::string& target : messagePtr->targets) {
+						targets += (targets.empty() ? "" : "|") + target;
+					}
+					traceLine("\t" + std::to_string(messagePtr->arrival) + "\t" + messagePtr->source + " -> " + targets + "\t" + messagePtr->type);
+				}
+			} else if (!command.empty()) {
+				traceLine(" - unknown command '" + command + "', type 'help' to retrieve the list of available commands");
+			}
+		} catch (const SimulationException& ex) {
+			traceLine(std::string(" - ") + ex.what());
 		}
 	}
 }
 
-void runSimulations(std::pair<unsigned int, unsigned int> runIndexRange, bool interactive, pugi::xml_node configurationNode, const ParameterStorage& parameterBase) {
+void runSimulations(std::pair<unsigned int, unsigned int> runIndexRange, bool interactive, const ExpandedConfiguration& configuration, const ParameterStorage& parameterBase) {
 	for(unsigned int runIndex = runIndexRange.first;runIndex < runIndexRange.second;++runIndex) {
 		ParameterStorage* parameters = new ParameterStorage(parameterBase);
 		parameters->set("runIndex", std::to_string(runIndex));
 		Simulation* simulation = new Simulation(parameters);
-		simulation->configure(configurationNode, "");
+		simulation->configure(configuration);
 
 		if (interactive) {
 			invokeInteractiveMode(simulation);
@@ -183,6 +351,240 @@ void runSimulations(std::pair<unsigned int, unsigned int> runIndexRange, bool in
 	}
 }
 
+void runBranchedSimulations(unsigned int runCount, unsigned int processCount, Timestamp branchTimestamp, const ExpandedConfiguration& configuration, const ParameterStorage& parameterBase) {
+#if defined(__linux__)
+	// the prefix is simulated under the first run's parameters, every branch then only differs in the seed and its run index
+	ParameterStorage* parameters = new ParameterStorage(parameterBase);
+	parameters->set("runIndex", "0");
+	parameters->set("branchIndex", "0");
+	Simulation* simulation = new Simulation(parameters);
+	simulation->configure(configuration);
+
+	const Timestamp startTimestamp = simulation->startTimestamp();
+	const Timestamp endTimestamp = startTimestamp + simulation->duration();
+	if (branchTimestamp < startTimestamp || branchTimestamp >= endTimestamp) {
+		delete simulation;
+		delete parameters;
+		throw SimulationException("runBranchedSimulations(): the branch time " + std::to_string(branchTimestamp) + " is not within the simulated time ["
+			+ std::to_string(startTimestamp) + ", " + std::to_string(endTimestamp) + ")");
+	}
+	simulation->simulate(branchTimestamp - simulation->currentTimestamp());
+	traceLine(" - common prefix simulated up to " + std::to_string(simulation->currentTimestamp()) + ", branching " + std::to_string(runCount) + " runs");
+
+	std::string seedString;
+	const std::mt19937::result_type baseSeed = parameters->tryGet("seed", seedString) ? (std::mt19937::result_type)std::stoul(seedString) : std::random_device()();
+
+	// anything still buffered would otherwise be written out once per child
+	std::cout.flush();
+	std::cerr.flush();
+	simulation->prepareBranching();
+
+	unsigned int runningCount = 0;
+	unsigned int failedCount = 0;
+	auto reapChild = [&runningCount, &failedCount]() {
+		int status = 0;
+		if (wait(&status) > 0) {
+			--runningCount;
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				++failedCount;
+			}
+		}
+	};
+
+	for (unsigned int runIndex = 0; runIndex < runCount; ++runIndex) {
+		if (runningCount == processCount) {
+			reapChild();
+		}
+
+		// the log writer thread does not survive fork(), its buffers are written out before and the child starts its own
+		AsyncLogWriter::instance().prepareFork();
+		const pid_t pid = fork();
+		if (pid != 0) {
+			AsyncLogWriter::instance().parentAfterFork();
+		}
+
+		if (pid < 0) {
+			throw SimulationException("runBranchedSimulations(): fork() failed for run " + std::to_string(runIndex));
+		} else if (pid == 0) {
+			AsyncLogWriter::instance().childAfterFork();
+			int exitCode = 0;
+			try {
+				parameters->set("runIndex", std::to_string(runIndex));
+				parameters->set("branchIndex", std::to_string(runIndex));
+				std::seed_seq branchSeedSequence{ baseSeed, (std::mt19937::result_type)runIndex };
+				std::mt19937::result_type branchSeed;
+				branchSeedSequence.generate(&branchSeed, &branchSeed + 1);
+				simulation->reseedBranch(branchSeed);
+				simulation->simulate();
+			} catch (const std::exception& ex) {
+				std::cout << ex.what() << std::endl;
+				exitCode = 1;
+			}
+			// _exit() skips the static destructors, i.e. the log writer's final flush
+			AsyncLogWriter::instance().flush();
+			std::cout.flush();
+			std::cerr.flush();
+			_exit(exitCode);
+		}
+
+		++runningCount;
+	}
+
+	while (runningCount > 0) {
+		reapChild();
+	}
+
+	delete simulation;
+	delete parameters;
+
+	if (failedCount > 0) {
+		throw SimulationException("runBranchedSimulations(): " + std::to_string(failedCount) + " of " + std::to_string(runCount) + " branches failed");
+	}
+#else
+	throw SimulationException("runBranchedSimulations(): branching from a snapshot requires fork() and is only available on Linux");
+#endif
+}
+
+struct SweepRunSummary {
+	uint64_t deliveredMessageCount = 0;
+	Timestamp endTimestamp = 0;
+	double seconds = 0.0;
+	std::string error;
+	// the StatsAgent statistics of the run, as <agent>.<statistic> and value
+	std::vector<std::pair<std::string, double>> statistics;
+};
+
+static std::string csvQuoted(const std::string& text) {
+	std::string quoted = "\"";
+	for (char c : text) {
+		quoted += c;
+		if (c == '"') {
+			quoted += '"';
+		}
+	}
+	return quoted + "\"";
+}
+
+void runSweep(const ParameterSweep& sweep, unsigned int threadCount, const ExpandedConfiguration& configuration, const ParameterStorage& parameterBase) {
+	// the runs are handed out one at a time, so that long and short runs balance out over the threads
+	const unsigned int runCount = sweep.runCount();
+	std::atomic<unsigned int> nextRunIndex(0);
+	std::vector<SweepRunSummary> summaries(runCount);
+
+	auto runWorker = [&]() {
+		unsigned int runIndex;
+		while ((runIndex = nextRunIndex.fetch_add(1)) < runCount) {
+			SweepRunSummary& summary = summaries[runIndex];
+			auto start = std::chrono::high_resolution_clock::now();
+			try {
+				const std::string outputDirectory = sweep.runOutputDirectory(runIndex);
+				if (!outputDirectory.empty()) {
+					std::filesystem::create_directories(outputDirectory);
+				}
+
+				ParameterStorage parameters(parameterBase);
+				sweep.applyRun(runIndex, parameters);
+				auto simulation = std::make_unique<Simulation>(&parameters);
+				simulation->configure(configuration);
+				simulation->simulate();
+
+				summary.deliveredMessageCount = simulation->deliveredMessageCount();
+				summary.endTimestamp = simulation->currentTimestamp();
+				for (const auto& agentPtr : simulation->agents()) {
+					auto statsAgent = dynamic_cast<StatsAgent*>(agentPtr.get());
+					if (statsAgent == nullptr) {
+						continue;
+					}
+					for (const auto& row : statsAgent->summary(summary.endTimestamp)) {
+						if (sweep.statistics().empty() || std::find(sweep.statistics().begin(), sweep.statistics().end(), row.first) != sweep.statistics().end()) {
+							summary.statistics.emplace_back(statsAgent->name() + "." + row.first, row.second);
+						}
+					}
+				}
+			} catch (const std::exception& ex) {
+				summary.error = ex.what();
+			}
+			std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+			summary.seconds = elapsed.count();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int threadIndex = 1; threadIndex < std::min(threadCount, runCount); ++threadIndex) {
+		threads.emplace_back(runWorker);
+	}
+	runWorker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	// one row per run: its identification, the point's values and the run's statistics
+	std::ofstream summaryFile;
+	if (!sweep.summaryPath().empty()) {
+		const std::filesystem::path summaryDirectory = std::filesystem::path(sweep.summaryPath()).parent_path();
+		if (!summaryDirectory.empty()) {
+			std::filesystem::create_directories(summaryDirectory);
+		}
+		summaryFile.open(sweep.summaryPath());
+	}
+	std::ostream& out = summaryFile.is_open() ? summaryFile : std::cout;
+
+	// the statistics columns in the order they first come up, a run failed before its end leaves them empty
+	std::vector<std::string> statisticColumns;
+	std::unordered_map<std::string, size_t> statisticColumnIndices;
+	for (const SweepRunSummary& summary : summaries) {
+		for (const auto& statistic : summary.statistics) {
+			if (statisticColumnIndices.emplace(statistic.first, statisticColumns.size()).second) {
+				statisticColumns.push_back(statistic.first);
+			}
+		}
+	}
+
+	out << "runIndex,pointIndex,replicate,seed";
+	for (const SweepParameter& parameter : sweep.parameters()) {
+		out << "," << parameter.name;
+	}
+	out << ",deliveredMessages,endTimestamp,seconds,error";
+	for (const std::string& column : statisticColumns) {
+		out << "," << column;
+	}
+	out << std::endl;
+
+	unsigned int failedCount = 0;
+	for (unsigned int runIndex = 0; runIndex < runCount; ++runIndex) {
+		const SweepRunSummary& summary = summaries[runIndex];
+		const unsigned int pointIndex = runIndex / sweep.replicateCount();
+		out << runIndex << "," << pointIndex << "," << runIndex % sweep.replicateCount() << "," << sweep.runSeed(runIndex);
+		for (const std::string& value : sweep.point(pointIndex)) {
+			out << "," << value;
+		}
+		out << "," << summary.deliveredMessageCount << "," << summary.endTimestamp << "," << summary.seconds << "," << csvQuoted(summary.error);
+
+		std::vector<std::string> statisticCells(statisticColumns.size());
+		for (const auto& statistic : summary.statistics) {
+			std::ostringstream cell;
+			cell << std::setprecision(10) << statistic.second;
+			statisticCells[statisticColumnIndices[statistic.first]] = cell.str();
+		}
+		for (const std::string& cell : statisticCells) {
+			out << "," << cell;
+		}
+		out << std::endl;
+
+		if (!summary.error.empty()) {
+			++failedCount;
+		}
+	}
+
+	if (summaryFile.is_open()) {
+		traceLine(" - sweep summary written to '" + sweep.summaryPath() + "'");
+	}
+
+	if (failedCount > 0) {
+		throw SimulationException("runSweep(): " + std::to_string(failedCount) + " of " + std::to_string(runCount) + " runs failed, see the error column of the summary");
+	}
+}
+
 void trace(const std::string& msg) {
 	if (silent) {
 		return;
@@ -0,0 +1,146 @@
+#include "BernoulliSampler.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// The cancellation draws of the agents went from one uniform per order to BernoulliSampler's geometric skips, the
+// selections have to stay distributed as before: per call, the number of selected indices out of n is Binomial(n, p),
+// and over the concatenation of the calls the runs of unselected indices are Geometric(p), whatever the batch of
+// uniforms carried over from one call to the next.
+
+// the chi-square statistic of the observed counts against the expected ones, adjacent bins merged until each expects at
+// least 5; false if the statistic is beyond the 0.001 upper quantile of its distribution
+static bool chiSquareAccepts(const std::vector<double>& observed, const std::vector<double>& expected, const std::string& what) {
+	std::vector<double> binObserved(1, 0.0), binExpected(1, 0.0);
+	for (size_t index = 0; index < expected.size(); ++index) {
+		if (binExpected.back() >= 5.0) {
+			binObserved.push_back(0.0);
+			binExpected.push_back(0.0);
+		}
+		binObserved.back() += observed[index];
+		binExpected.back() += expected[index];
+	}
+	// the rest goes with the last full bin
+	if (binExpected.back() < 5.0 && binExpected.size() > 1) {
+		binObserved[binObserved.size() - 2] += binObserved.back();
+		binExpected[binExpected.size() - 2] += binExpected.back();
+		binObserved.pop_back();
+		binExpected.pop_back();
+	}
+
+	double statistic = 0.0;
+	for (size_t bin = 0; bin < binExpected.size(); ++bin) {
+		statistic += (binObserved[bin] - binExpected[bin]) * (binObserved[bin] - binExpected[bin]) / binExpected[bin];
+	}
+
+	// Wilson-Hilferty, z = 3.09 for 0.001
+	const double degrees = (double)std::max<size_t>(binExpected.size(), 2) - 1.0;
+	const double critical = degrees * std::pow(1.0 - 2.0 / (9.0 * degrees) + 3.09 * std::sqrt(2.0 / (9.0 * degrees)), 3.0);
+	std::cout << what << ": chi-square " << statistic << " over " << degrees << " degrees of freedom, critical " << critical << std::endl;
+	return statistic <= critical;
+}
+
+static double binomialProbability(size_t n, size_t k, double p) {
+	return std::exp(std::lgamma((double)n + 1.0) - std::lgamma((double)k + 1.0) - std::lgamma((double)(n - k) + 1.0)
+		+ (double)k * std::log(p) + (double)(n - k) * std::log1p(-p));
+}
+
+// calls of n indices each: the selection counts against Binomial(n, p), the gaps over the concatenated calls against Geometric(p)
+static void checkDistribution(double p, size_t n, size_t callCount, uint32_t seed) {
+	const std::string name = "p=" + std::to_string(p) + " n=" + std::to_string(n);
+	BernoulliSampler sampler(p);
+	std::mt19937 randomGenerator(seed);
+
+	std::vector<double> countHistogram(n + 1, 0.0);
+	// the tail of the gaps is one bin, which Geometric(p) gives 1% of the mass
+	const size_t gapBinCount = (size_t)std::ceil(std::log(0.01) / std::log1p(-p)) + 1;
+	std::vector<double> gapHistogram(gapBinCount, 0.0);
+	size_t gapCount = 0;
+	uint64_t position = 0, lastSelected = 0;
+	bool hasSelected = false;
+	bool isIncreasing = true;
+
+	for (size_t call = 0; call < callCount; ++call) {
+		size_t selected = 0;
+		int64_t previousIndex = -1;
+		sampler.sample(n, randomGenerator, [&](size_t index) {
+			isIncreasing = isIncreasing && (int64_t)index > previousIndex && index < n;
+			previousIndex = (int64_t)index;
+			++selected;
+
+			const uint64_t at = position + index;
+			if (hasSelected) {
+				++gapHistogram[std::min<uint64_t>(at - lastSelected - 1, gapBinCount - 1)];
+				++gapCount;
+			}
+			lastSelected = at;
+			hasSelected = true;
+		});
+		++countHistogram[selected];
+		position += n;
+	}
+	check(isIncreasing, name + ": the indices are increasing and below n");
+
+	std::vector<double> expectedCounts(n + 1);
+	for (size_t k = 0; k <= n; ++k) {
+		expectedCounts[k] = (double)callCount * binomialProbability(n, k, p);
+	}
+	check(chiSquareAccepts(countHistogram, expectedCounts, name + " counts"), name + ": the counts per call are Binomial(n, p)");
+
+	std::vector<double> expectedGaps(gapBinCount);
+	for (size_t gap = 0; gap + 1 < gapBinCount; ++gap) {
+		expectedGaps[gap] = (double)gapCount * p * std::pow(1.0 - p, (double)gap);
+	}
+	expectedGaps[gapBinCount - 1] = (double)gapCount * std::pow(1.0 - p, (double)(gapBinCount - 1));
+	check(chiSquareAccepts(gapHistogram, expectedGaps, name + " gaps"), name + ": the gaps across calls are Geometric(p)");
+}
+
+static void checkDegenerate() {
+	std::mt19937 randomGenerator(1);
+	for (double p : { 1.0, 1.5 }) {
+		BernoulliSampler sampler(p);
+		std::vector<size_t> indices;
+		sampler.sample(100, randomGenerator, [&indices](size_t index) { indices.push_back(index); });
+		bool isAll = indices.size() == 100;
+		for (size_t index = 0; isAll && index < indices.size(); ++index) {
+			isAll = indices[index] == index;
+		}
+		check(isAll, "p=" + std::to_string(p) + ": every index is selected");
+	}
+
+	for (double p : { 0.0, -0.5 }) {
+		BernoulliSampler sampler(p);
+		check(sampler.count(1000000, randomGenerator) == 0, "p=" + std::to_string(p) + ": no index is selected");
+	}
+
+	BernoulliSampler sampler(0.5);
+	check(sampler.count(0, randomGenerator) == 0, "n=0: no index is selected");
+
+	// close to 0, a handful of selections over 10^10 indices: Poisson(10), 27 is beyond its 0.9999 quantile
+	sampler.setProbability(1e-9);
+	size_t selected = 0;
+	for (size_t call = 0; call < 10000; ++call) {
+		selected += sampler.count(1000000, randomGenerator);
+	}
+	std::cout << "p=1e-9: " << selected << " selections out of 1e10, 10 expected" << std::endl;
+	check(selected >= 1 && selected <= 27, "p=1e-9: the selections are Poisson(10)");
+}
+
+int main() {
+	return runChecks([] {
+		// close to 0 and 1, and calls shorter than a batch of uniforms so that the batches carry over between calls
+		checkDistribution(1e-4, 100000, 2000, 11);
+		checkDistribution(0.01, 1000, 20000, 12);
+		checkDistribution(0.3, 3, 200000, 13);
+		checkDistribution(0.3, 50, 20000, 14);
+		checkDistribution(0.9, 7, 100000, 15);
+		checkDistribution(0.999, 20, 50000, 16);
+		checkDegenerate();
+	});
+}
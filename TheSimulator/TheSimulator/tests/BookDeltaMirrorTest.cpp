@@ -0,0 +1,155 @@
+#include "Agent.h"
+#include "AgentFactory.h"
+#include "ExchangeAgent.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+// An agent subscribing to the book delta feed of an exchange at any time gets a snapshot of the resting orders, then
+// every delta after it exactly once and in sequence: a mirror built from the feed equals the exchange's book whenever it
+// has caught up with it. Mirrors subscribing at the start and mid-run, to exchanges with and without a processing delay;
+// with one, the book has mostly moved on by the time a batch arrives, the deltas still have to follow each other.
+
+class MirrorAgent : public Agent {
+public:
+	MirrorAgent(const Simulation* simulation)
+		: Agent(simulation), m_subscribeAt(0), m_isCatchingUp(false), m_sequence(0), m_hasSnapshot(false), m_comparisonCount(0) { }
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override {
+		Agent::configure(node, configurationPath);
+		m_exchange = node.attribute("exchange").as_string();
+		m_subscribeAt = node.attribute("subscribeAt").as_ullong();
+		m_isCatchingUp = node.attribute("catchesUp").as_bool();
+	}
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		if (messagePtr->type == "EVENT_SIMULATION_START") {
+			simulation()->scheduleWakeup(this, m_subscribeAt);
+		} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+			std::cout << name() << ": " << m_comparisonCount << " comparisons with the book, up to delta " << m_sequence << std::endl;
+			check(m_hasSnapshot, name() + ": the snapshot arrived");
+			check(!m_isCatchingUp || m_comparisonCount > 0, name() + ": the mirror caught up with the book");
+		} else if (messagePtr->type == "EVENT_BOOK_DELTA") {
+			auto pptr = std::dynamic_pointer_cast<EventBookDeltaPayload>(messagePtr->payload);
+			if (!m_hasSnapshot) {
+				applySnapshot(pptr->deltas);
+			} else {
+				for (const BookDelta& delta : pptr->deltas) {
+					applyDelta(delta);
+				}
+			}
+			compareWithBook();
+		}
+	}
+
+	void receiveWakeup(WakeupTag /*tag*/) override {
+		simulation()->dispatchMessage(simulation()->currentTimestamp(), 0, name(), m_exchange, "SUBSCRIBE_EVENT_BOOK_DELTA", std::make_shared<EmptyPayload>());
+	}
+private:
+	std::string m_exchange;
+	Timestamp m_subscribeAt;
+	bool m_isCatchingUp;
+	// by order id, the price and the remaining volume
+	std::map<OrderID, std::pair<Money, Volume>> m_orders;
+	uint64_t m_sequence;
+	bool m_hasSnapshot;
+	size_t m_comparisonCount;
+
+	void applySnapshot(const std::vector<BookDelta>& deltas) {
+		check(!deltas.empty(), name() + ": the snapshot has the resting orders");
+		for (const BookDelta& delta : deltas) {
+			check(delta.type == BookDeltaType::Add && delta.sequence == deltas.front().sequence, name() + ": the snapshot is adds at one sequence");
+			m_orders[delta.orderId] = { delta.price, delta.remainingVolume };
+		}
+		m_sequence = deltas.empty() ? 0 : deltas.front().sequence;
+		m_hasSnapshot = true;
+	}
+
+	void applyDelta(const BookDelta& delta) {
+		check(delta.sequence == m_sequence + 1, name() + ": delta " + std::to_string(delta.sequence) + " follows " + std::to_string(m_sequence));
+		m_sequence = delta.sequence;
+
+		if (delta.type == BookDeltaType::Add) {
+			check(m_orders.count(delta.orderId) == 0, name() + ": order " + std::to_string(delta.orderId) + " is added once");
+			m_orders[delta.orderId] = { delta.price, delta.remainingVolume };
+		} else if (delta.type != BookDeltaType::LevelDelete) {
+			auto it = m_orders.find(delta.orderId);
+			if (it == m_orders.end()) {
+				check(false, name() + ": order " + std::to_string(delta.orderId) + " of delta " + std::to_string(delta.sequence) + " is in the mirror");
+				return;
+			}
+			check(it->second.second == delta.volume + delta.remainingVolume, name() + ": delta " + std::to_string(delta.sequence) + " starts from the mirrored volume");
+			it->second.second = delta.remainingVolume;
+			if (delta.remainingVolume == 0) {
+				m_orders.erase(it);
+			}
+		}
+	}
+
+	void compareWithBook() {
+		const BookPtr book = dynamic_cast<ExchangeAgent*>(simulation()->findAgent(m_exchange))->book();
+		if (book->deltaSequence() != m_sequence) {
+			return;
+		}
+
+		std::map<OrderID, std::pair<Money, Volume>> orders;
+		for (const auto* queue : { &book->buyQueue(), &book->sellQueue() }) {
+			for (const TickContainer& level : *queue) {
+				for (const LimitOrderPtr& order : level) {
+					if (order->volume() > 0) {
+						orders[order->id()] = { order->price(), order->volume() };
+					}
+				}
+			}
+		}
+		check(orders == m_orders, name() + ": the mirror equals the book at delta " + std::to_string(m_sequence));
+		++m_comparisonCount;
+	}
+};
+
+static const char* const CONFIGURATION = R"(
+<Simulation start="0" duration="3000">
+	<ExchangeAgent name="MARKET1" algorithm="%ALGORITHM%" processingDelay="%DELAY%"/>
+	<MomentumAgent name="MOMENTUM_AGENT" count="10" exchange_1="MARKET1" cancel_probability="0.3" market_to_limit_ratio="5.0"
+		num_momentum_traders="10" demand_saturation="9.0" alpha="0.7" beta="0.02"/>
+	<FundamentalAgent name="FUNDAMENTAL_AGENT" count="10" exchange_1="MARKET1" fundamental_value_expectation="50.0"
+		fundamental_value_std="5.0" k1="5.0" k2="0.02" num_fundamental_traders="10"/>
+	<MarketMakerAgent name="MARKET_MAKER_AGENT" count="10" exchange_1="MARKET1" num_market_makers="10" limit_order_probability="0.6"
+		cancel_probability="0.2" restart_interval="20" spread="0.5" max_risk="300"/>
+	<NoiseAgent name="NOISE_AGENT" count="10" exchange_1="MARKET1" cancel_probability="0.3" market_to_limit_ratio="5.0"
+		num_noise_traders="10" sigma="0.6"/>
+	<ExchangePopulator name="EXCHANGE_POPULATOR" exchange="MARKET1" initial_price="50.0" quantity_per_level="100"
+		num_levels_both_sides="1000" level_spacing="0.5"/>
+	<MirrorAgent name="MIRROR_START" exchange="MARKET1" subscribeAt="0" catchesUp="%CATCHUP%"/>
+	<MirrorAgent name="MIRROR_EARLY" exchange="MARKET1" subscribeAt="1" catchesUp="%CATCHUP%"/>
+	<MirrorAgent name="MIRROR_MID" exchange="MARKET1" subscribeAt="1500" catchesUp="%CATCHUP%"/>
+	<MirrorAgent name="MIRROR_LATE" exchange="MARKET1" subscribeAt="2711" catchesUp="%CATCHUP%"/>
+</Simulation>
+)";
+
+static void runMirrors(const std::string& algorithm, const std::string& delay) {
+	std::string text = CONFIGURATION;
+	replaceAll(text, "%ALGORITHM%", algorithm);
+	replaceAll(text, "%DELAY%", delay);
+	replaceAll(text, "%CATCHUP%", delay == "0" ? "true" : "false");
+
+	std::cout << algorithm << ", processing delay " << delay << std::endl;
+	runConfiguration(text);
+}
+
+int main() {
+	AgentFactory::instance().registerAgent<MirrorAgent>("MirrorAgent");
+
+	return runChecks([] {
+		for (const char* algorithm : { "PriceTime", "PureProRata", "TimeProRata", "PriorityProRata" }) {
+			runMirrors(algorithm, "0");
+			runMirrors(algorithm, "3");
+		}
+	});
+}
@@ -0,0 +1,340 @@
+#include "Agent.h"
+#include "AgentFactory.h"
+#include "Book.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "PriceTimeBook.h"
+#include "PriorityProRataBook.h"
+#include "PureProRataBook.h"
+#include "Simulation.h"
+#include "StopOrderIndex.h"
+#include "TimeProRataBook.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The matching of the books of every algorithm, order by order: how a replacement keeps or loses the priority of an
+// order, where the new peaks of an iceberg order go, and what is left of the orders with a time in force. The priority
+// of an order is its place in its level, the pro-rata books share a fill by it too. The stop orders of an exchange enter
+// its book in the order their trigger came, and those triggered by the fills of triggered ones in the next round of the
+// cascade.
+
+// a book of the algorithm logging its trades to trades
+template<class BookType>
+BookPtr makeBook(std::vector<TradePtr>& trades) {
+	BookPtr book = std::make_shared<BookType>(std::make_shared<OrderFactory>(), std::make_shared<TradeFactory>());
+	book->registerTradeLoggingCallback([&trades](TradePtr trade) {
+		trades.push_back(trade);
+	});
+	return book;
+}
+
+// the ids of the orders of a level, front first
+static std::vector<OrderID> levelOrders(const BookPtr& book, OrderDirection direction, Money price) {
+	std::vector<OrderID> ids;
+	if (const TickContainer* level = book->findLevel(direction, price)) {
+		for (const LimitOrderPtr& order : *level) {
+			ids.push_back(order->id());
+		}
+	}
+	return ids;
+}
+
+// cancelled orders are left in their level with no volume until the matching gets to them
+static Volume restingVolume(const BookPtr& book, OrderDirection direction) {
+	Volume volume = 0;
+	for (const TickContainer& level : direction == OrderDirection::Buy ? book->buyQueue() : book->sellQueue()) {
+		volume += level.volume();
+	}
+	return volume;
+}
+
+static Volume tradedVolume(const std::vector<TradePtr>& trades, OrderID aggressorId) {
+	Volume volume = 0;
+	for (const TradePtr& trade : trades) {
+		if (trade->aggressingOrderID() == aggressorId) {
+			volume += trade->volume();
+		}
+	}
+	return volume;
+}
+
+template<class BookType>
+void checkReplace(const std::string& algorithm) {
+	std::vector<TradePtr> trades;
+	BookPtr book = makeBook<BookType>(trades);
+	const OrderID a = book->placeLimitOrder(OrderDirection::Sell, 1, 10, 50)->id();
+	const OrderID b = book->placeLimitOrder(OrderDirection::Sell, 2, 10, 50)->id();
+
+	// less volume at the same price keeps the place and the timestamp
+	check(book->replaceOrder(a, 3, 50, 5) == 5, algorithm + ": a decrease leaves the order with its new volume");
+	check(levelOrders(book, OrderDirection::Sell, 50) == std::vector<OrderID>{ a, b }, algorithm + ": a decrease keeps the priority");
+	LimitOrderPtr order;
+	check(book->tryGetOrder(a, order) && order->volume() == 5 && order->timestamp() == 1,
+		algorithm + ": a decreased order keeps its timestamp");
+
+	// a move, even back to the same price, goes to the back of the level
+	check(book->replaceOrder(a, 4, 51, 8) == 8, algorithm + ": a move leaves the order with its new volume");
+	check(levelOrders(book, OrderDirection::Sell, 50) == std::vector<OrderID>{ b }, algorithm + ": a move leaves the old level");
+	check(levelOrders(book, OrderDirection::Sell, 51) == std::vector<OrderID>{ a }, algorithm + ": a move joins the new level");
+	check(book->replaceOrder(a, 5, 50, 8) == 8, algorithm + ": a move back leaves the order with its volume");
+	check(levelOrders(book, OrderDirection::Sell, 50) == std::vector<OrderID>{ b, a }, algorithm + ": a move loses the priority");
+	check(book->findLevel(OrderDirection::Sell, 51) == nullptr, algorithm + ": the level the order left is gone");
+	check(book->tryGetOrder(a, order) && order->timestamp() == 5, algorithm + ": a moved order takes the timestamp of the move");
+
+	// so does more volume at the same price
+	check(book->replaceOrder(b, 6, 50, 12) == 12, algorithm + ": an increase leaves the order with its new volume");
+	check(levelOrders(book, OrderDirection::Sell, 50) == std::vector<OrderID>{ a, b }, algorithm + ": an increase loses the priority");
+
+	// a move crossing the book matches first, here in full, and leaves nothing to rest
+	const OrderID c = book->placeLimitOrder(OrderDirection::Buy, 7, 10, 49)->id();
+	check(book->replaceOrder(c, 8, 50, 10) == 0, algorithm + ": a move filled in full does not rest");
+	check(tradedVolume(trades, c) == 10, algorithm + ": a crossing move matches");
+	check(book->buyQueue().empty(), algorithm + ": a move filled in full leaves no level");
+	check(book->sellQueue().front().volume() == 10, algorithm + ": a crossing move takes what it matched from the book");
+	check(book->replaceOrder(c, 9, 49, 10) == 0, algorithm + ": a filled order cannot be replaced");
+}
+
+template<class BookType>
+void checkTimeInForce(const std::string& algorithm) {
+	std::vector<TradePtr> trades;
+	BookPtr book = makeBook<BookType>(trades);
+	const OrderID a = book->placeLimitOrder(OrderDirection::Sell, 1, 30, 50, TimeInForce::GTC, TIMESTAMP_INVALID, 10)->id();
+
+	// the hidden volume of an iceberg order counts for a FOK order, which fills from the peaks it shows one after the other
+	LimitOrderPtr fok = book->placeLimitOrder(OrderDirection::Buy, 2, 25, 50, TimeInForce::FOK);
+	check(tradedVolume(trades, fok->id()) == 25, algorithm + ": a FOK order is filled by the hidden volume");
+	check(fok->volume() == 0 && book->buyQueue().empty(), algorithm + ": a filled FOK order does not rest");
+	LimitOrderPtr order;
+	check(book->tryGetOrder(a, order) && order->volume() == 5 && order->hiddenVolume() == 0,
+		algorithm + ": the FOK order took its volume from the iceberg order");
+
+	fok = book->placeLimitOrder(OrderDirection::Buy, 3, 6, 50, TimeInForce::FOK);
+	check(tradedVolume(trades, fok->id()) == 0, algorithm + ": a FOK order beyond the volume of the book does not match");
+	check(fok->volume() == 0 && book->buyQueue().empty(), algorithm + ": an unfilled FOK order does not rest");
+	check(book->tryGetOrder(a, order) && order->volume() == 5, algorithm + ": an unfilled FOK order leaves the book as it is");
+
+	// the leftover of an IOC order is cancelled
+	LimitOrderPtr ioc = book->placeLimitOrder(OrderDirection::Buy, 4, 8, 50, TimeInForce::IOC);
+	check(tradedVolume(trades, ioc->id()) == 5, algorithm + ": an IOC order matches what it crosses");
+	check(ioc->volume() == 0 && book->buyQueue().empty() && !book->tryGetOrder(ioc->id(), order),
+		algorithm + ": the leftover of an IOC order does not rest");
+	check(book->sellQueue().empty(), algorithm + ": the IOC order took the rest of the iceberg order");
+
+	// a GTD order rests until its expiry, at which it is cancelled with whatever it has left
+	const OrderID d = book->placeLimitOrder(OrderDirection::Buy, 10, 10, 49, TimeInForce::GTD, 100)->id();
+	const OrderID e = book->placeLimitOrder(OrderDirection::Buy, 11, 10, 48, TimeInForce::GTD, 150)->id();
+	check(book->nextExpiry() == 100, algorithm + ": the first expiry is due next");
+	book->expireOrders(99);
+	check(book->tryGetOrder(d, order) && book->tryGetOrder(e, order), algorithm + ": GTD orders rest before their expiry");
+	book->expireOrders(100);
+	check(!book->tryGetOrder(d, order) && book->findLevel(OrderDirection::Buy, 49)->volume() == 0, algorithm + ": a GTD order expires at its expiry");
+	check(book->tryGetOrder(e, order) && book->nextExpiry() == 150, algorithm + ": a later GTD order still rests");
+	book->placeMarketOrder(OrderDirection::Sell, 120, 4);
+	check(book->tryGetOrder(e, order) && order->volume() == 6, algorithm + ": a GTD order fills like any other");
+	book->expireOrders(200);
+	check(!book->tryGetOrder(e, order) && restingVolume(book, OrderDirection::Buy) == 0, algorithm + ": the leftover of a GTD order expires after its expiry");
+	check(book->nextExpiry() == TIMESTAMP_INVALID, algorithm + ": no expiry is pending");
+
+	// with an expiry not after its timestamp, a GTD order is an IOC order
+	LimitOrderPtr late = book->placeLimitOrder(OrderDirection::Buy, 300, 10, 49, TimeInForce::GTD, 300);
+	check(late->volume() == 0 && !book->tryGetOrder(late->id(), order) && book->nextExpiry() == TIMESTAMP_INVALID,
+		algorithm + ": an expired GTD order does not rest");
+}
+
+template<class BookType>
+void checkIcebergRefill(const std::string& algorithm) {
+	std::vector<TradePtr> trades;
+	BookPtr book = makeBook<BookType>(trades);
+	const OrderID a = book->placeLimitOrder(OrderDirection::Sell, 1, 3, 50, TimeInForce::GTC, TIMESTAMP_INVALID, 1)->id();
+	const OrderID b = book->placeLimitOrder(OrderDirection::Sell, 2, 10, 50)->id();
+	check(levelOrders(book, OrderDirection::Sell, 50) == std::vector<OrderID>{ a, b }, algorithm + ": an iceberg order rests like any other");
+
+	// one lot is too little to share, it goes to the front of the level, the peak it fills is shown again behind b
+	book->placeMarketOrder(OrderDirection::Buy, 3, 1);
+	check(trades.size() == 1 && trades.back()->restingOrderID() == a, algorithm + ": the peak of the iceberg order is filled first");
+	check(levelOrders(book, OrderDirection::Sell, 50) == std::vector<OrderID>{ b, a }, algorithm + ": the new peak goes to the back of the level");
+	LimitOrderPtr order;
+	check(book->tryGetOrder(a, order) && order->volume() == 1 && order->hiddenVolume() == 1, algorithm + ": the new peak is shown");
+
+	book->placeMarketOrder(OrderDirection::Buy, 4, 1);
+	check(trades.size() == 2 && trades.back()->restingOrderID() == b, algorithm + ": the new peak has lost the priority");
+}
+
+static std::vector<OrderID> ids(const std::vector<StopOrder>& orders) {
+	std::vector<OrderID> ids;
+	for (const StopOrder& order : orders) {
+		ids.push_back(order.id);
+	}
+	return ids;
+}
+
+static void checkStopOrderIndex() {
+	StopOrderIndex index;
+	index.add(StopOrder{ 1, "", OrderDirection::Sell, 10, 49, false, 0 });
+	index.add(StopOrder{ 2, "", OrderDirection::Sell, 10, 48, false, 0 });
+	index.add(StopOrder{ 3, "", OrderDirection::Sell, 10, 49, false, 0 });
+	index.add(StopOrder{ 4, "", OrderDirection::Buy, 10, 52, false, 0 });
+	index.add(StopOrder{ 5, "", OrderDirection::Buy, 10, 51, false, 0 });
+	index.add(StopOrder{ 6, "", OrderDirection::Buy, 10, 51, false, 0 });
+	index.add(StopOrder{ 7, "", OrderDirection::Buy, 10, 53, false, 0 });
+
+	// the sell stops from the highest down, then the buy stops from the lowest up, in the order they came in among equals
+	std::vector<StopOrder> triggered;
+	index.collectTriggered(Money(48.5), Money(52), triggered);
+	check(ids(triggered) == std::vector<OrderID>{ 1, 3, 5, 6, 4 }, "StopOrderIndex: the triggered orders come in trigger order");
+	check(index.size() == 2, "StopOrderIndex: the triggered orders leave the index");
+
+	check(index.remove(7) && !index.remove(7) && !index.remove(1), "StopOrderIndex: only pending orders are cancelled");
+	triggered.clear();
+	index.collectTriggered(40, 60, triggered);
+	check(ids(triggered) == std::vector<OrderID>{ 2 } && index.empty(), "StopOrderIndex: a cancelled order does not trigger");
+}
+
+// Rests sell orders at 50, 51, 52 and 53 and buy stops above them, then buys at 50: the stops at 50 fill at 51 and 52,
+// which triggers the stops at 51 and 52 in the next round, and so on
+class StopCascadeAgent : public Agent {
+public:
+	StopCascadeAgent(const Simulation* simulation)
+		: Agent(simulation) { }
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override {
+		Agent::configure(node, configurationPath);
+		m_exchange = node.attribute("exchange").as_string();
+	}
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		const Timestamp now = simulation()->currentTimestamp();
+		if (messagePtr->topic != TOPICID_INVALID) {
+			const Trade& trade = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload)->trade;
+			m_fills[trade.aggressingOrderID()].emplace_back(trade.volume(), trade.price());
+		} else if (messagePtr->type == "EVENT_SIMULATION_START") {
+			simulation()->dispatchMessage(now, 0, name(), m_exchange, "SUBSCRIBE_EVENT_TRADE", std::make_shared<EmptyPayload>());
+			for (int price : { 50, 51, 52, 53 }) {
+				auto pptr = std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, 10, price);
+				simulation()->dispatchMessage(now, 0, name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
+			}
+			// the two stops at 50 trigger together, in the order they came in
+			m_stops = {
+				std::make_shared<PlaceOrderStopPayload>(OrderDirection::Buy, 10, 50),
+				std::make_shared<PlaceOrderStopPayload>(OrderDirection::Buy, 5, 50),
+				std::make_shared<PlaceOrderStopPayload>(OrderDirection::Buy, 10, 51),
+				std::make_shared<PlaceOrderStopPayload>(OrderDirection::Buy, 10, 52),
+				std::make_shared<PlaceOrderStopPayload>(OrderDirection::Sell, 10, 40)
+			};
+			m_stopIds.assign(m_stops.size(), 0);
+			// the messages arriving at the same time come in any order, the stops come one at a time
+			for (size_t stop = 0; stop < m_stops.size(); ++stop) {
+				simulation()->dispatchMessage(now, 1 + stop, name(), m_exchange, "PLACE_ORDER_STOP", m_stops[stop]);
+			}
+			simulation()->scheduleWakeup(this, 10);
+		} else if (messagePtr->type == "RESPONSE_PLACE_ORDER_STOP") {
+			auto pptr = std::dynamic_pointer_cast<PlaceOrderStopResponsePayload>(messagePtr->payload);
+			const size_t stop = std::find(m_stops.begin(), m_stops.end(), pptr->requestPayload) - m_stops.begin();
+			m_stopIds[stop] = pptr->id;
+		} else if (messagePtr->type == "EVENT_STOP_ORDER_TRIGGERED") {
+			auto pptr = std::dynamic_pointer_cast<EventStopOrderTriggeredPayload>(messagePtr->payload);
+			check(now == 10, name() + ": the cascade is over at the time of the trade starting it");
+			m_triggered.emplace_back(pptr->orderId, pptr->stopOrderId);
+		} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+			checkCascade();
+		}
+	}
+
+	void receiveWakeup(WakeupTag /*tag*/) override {
+		auto pptr = std::make_shared<PlaceOrderMarketPayload>(OrderDirection::Buy, 10);
+		simulation()->dispatchMessage(simulation()->currentTimestamp(), 0, name(), m_exchange, "PLACE_ORDER_MARKET", pptr);
+	}
+private:
+	std::string m_exchange;
+	std::vector<std::shared_ptr<PlaceOrderStopPayload>> m_stops;
+	std::vector<OrderID> m_stopIds;
+	// (order id, stop order id) of every triggered stop order
+	std::vector<std::pair<OrderID, OrderID>> m_triggered;
+	// the (volume, price) fills of every aggressing order, the trade events of one time come in any order too
+	std::map<OrderID, std::vector<std::pair<Volume, Money>>> m_fills;
+
+	void checkCascade() {
+		// the ids of the orders the stops became tell the order they entered the book in
+		std::sort(m_triggered.begin(), m_triggered.end());
+		std::vector<OrderID> triggered;
+		for (const auto& [orderId, stopOrderId] : m_triggered) {
+			triggered.push_back(stopOrderId);
+		}
+		check(triggered == std::vector<OrderID>{ m_stopIds[0], m_stopIds[1], m_stopIds[2], m_stopIds[3] },
+			name() + ": the stop orders entered the book in the order of the cascade");
+		if (m_triggered.size() != 4) {
+			return;
+		}
+
+		const std::vector<std::vector<std::pair<Volume, Money>>> expectedFills = {
+			{ { 10, 51 } },
+			{ { 5, 52 } },
+			{ { 5, 52 }, { 5, 53 } },
+			{ { 5, 53 } }
+		};
+		for (size_t stop = 0; stop < expectedFills.size(); ++stop) {
+			auto& fills = m_fills[m_triggered[stop].first];
+			std::sort(fills.begin(), fills.end());
+			check(fills == expectedFills[stop], name() + ": stop order " + std::to_string(stop)
+				+ " filled at its place in the cascade");
+		}
+	}
+};
+
+static const char* const CASCADE_CONFIGURATION = R"(
+<Simulation start="0" duration="20">
+	<ExchangeAgent name="MARKET1" algorithm="PriceTime"/>
+	<StopCascadeAgent name="STOP_CASCADE_AGENT" exchange="MARKET1"/>
+</Simulation>
+)";
+
+int main() {
+	AgentFactory::instance().registerAgent<StopCascadeAgent>("StopCascadeAgent");
+
+	return runChecks([] {
+		checkReplace<PriceTimeBook>("PriceTime");
+		checkReplace<PureProRataBook>("PureProRata");
+		checkReplace<PriorityProRataBook>("PriorityProRata");
+		checkReplace<TimeProRataBook>("TimeProRata");
+		checkTimeInForce<PriceTimeBook>("PriceTime");
+		checkTimeInForce<PureProRataBook>("PureProRata");
+		checkTimeInForce<PriorityProRataBook>("PriorityProRata");
+		checkTimeInForce<TimeProRataBook>("TimeProRata");
+		checkIcebergRefill<PriceTimeBook>("PriceTime");
+		checkIcebergRefill<PureProRataBook>("PureProRata");
+		checkIcebergRefill<PriorityProRataBook>("PriorityProRata");
+		checkIcebergRefill<TimeProRataBook>("TimeProRata");
+		checkStopOrderIndex();
+		runConfiguration(CASCADE_CONFIGURATION);
+
+		// by price and time the crossing move takes the front of the level first
+		std::vector<TradePtr> trades;
+		BookPtr book = makeBook<PriceTimeBook>(trades);
+		const OrderID a = book->placeLimitOrder(OrderDirection::Sell, 1, 10, 50)->id();
+		const OrderID b = book->placeLimitOrder(OrderDirection::Sell, 2, 10, 50)->id();
+		book->replaceOrder(a, 3, 50, 4);
+		const OrderID c = book->placeLimitOrder(OrderDirection::Buy, 4, 6, 49)->id();
+		book->replaceOrder(c, 5, 50, 6);
+		check(trades.size() == 2 && trades[0]->restingOrderID() == a && trades[0]->volume() == 4 && trades[1]->restingOrderID() == b
+			&& trades[1]->volume() == 2, "PriceTime: the decreased order is filled first");
+
+		// by price and time an order large enough to take several peaks of an iceberg order takes them between the others
+		trades.clear();
+		book = makeBook<PriceTimeBook>(trades);
+		const OrderID iceberg = book->placeLimitOrder(OrderDirection::Sell, 1, 3, 50, TimeInForce::GTC, TIMESTAMP_INVALID, 1)->id();
+		const OrderID other = book->placeLimitOrder(OrderDirection::Sell, 2, 2, 50)->id();
+		book->placeMarketOrder(OrderDirection::Buy, 3, 5);
+		std::vector<std::pair<OrderID, Volume>> fills;
+		for (const TradePtr& trade : trades) {
+			fills.emplace_back(trade->restingOrderID(), trade->volume());
+		}
+		check(fills == std::vector<std::pair<OrderID, Volume>>{ { iceberg, 1 }, { other, 2 }, { iceberg, 1 }, { iceberg, 1 } },
+			"PriceTime: each new peak is filled after the orders ahead of it");
+		check(book->sellQueue().empty(), "PriceTime: the filled iceberg order leaves the book");
+	});
+}
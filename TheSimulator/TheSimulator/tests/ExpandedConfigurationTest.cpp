@@ -0,0 +1,61 @@
+#include "ExpandedConfiguration.h"
+#include "ParameterStorage.h"
+#include "TestSupport.h"
+
+#include <memory>
+#include <string>
+
+// The nodes of an expanded configuration come with their references resolved against the parameters of the run, once
+// per combination of the values they name: the runs sharing those values share the resolved copy, the others get their
+// own, and a node naming a parameter that is not set is left to its agent, as is an attribute naming the branch.
+
+static const char* const CONFIGURATION = R"(
+<Simulation start="0" duration="10">
+	<ExchangeAgent name="MARKET${market}" algorithm="PriceTime" processingDelay="${delay}" outputFile="book_${branchIndex}.bin"/>
+	<ExchangeAgent name="PLAIN" algorithm="PriceTime"/>
+	<ExchangeAgent name="ESCAPED" algorithm="$PriceTime"/>
+</Simulation>
+)";
+
+int main() {
+	return runChecks([] {
+		pugi::xml_document document;
+		document.load_string(CONFIGURATION);
+		ExpandedConfiguration configuration;
+		configuration.configure(document.child("Simulation"), "");
+		check(configuration.entries().size() == 3, "the three agent nodes are entries");
+		check(configuration.entries()[0].references == std::vector<std::string>{ "market", "delay" }, "the references of the node are collected");
+
+		ParameterStorage parameters;
+		parameters.set("market", "1");
+		std::shared_ptr<const pugi::xml_document> holder;
+		pugi::xml_node node = configuration.resolvedNode(0, parameters, holder);
+		check(holder == nullptr && node == configuration.entries()[0].node, "a node naming a parameter not set is left as it is");
+
+		parameters.set("delay", "3");
+		node = configuration.resolvedNode(0, parameters, holder);
+		check(holder != nullptr && std::string(node.attribute("name").as_string()) == "MARKET1"
+			&& std::string(node.attribute("processingDelay").as_string()) == "3", "the references are resolved");
+		check(std::string(node.attribute("outputFile").as_string()) == "book_${branchIndex}.bin", "a reference to the branch is left to the agent");
+		std::shared_ptr<const pugi::xml_document> sameHolder;
+		configuration.resolvedNode(0, parameters, sameHolder);
+		check(sameHolder == holder, "the same values share the resolved node");
+
+		parameters.set("delay", "4");
+		std::shared_ptr<const pugi::xml_document> otherHolder;
+		node = configuration.resolvedNode(0, parameters, otherHolder);
+		check(otherHolder != holder && std::string(node.attribute("processingDelay").as_string()) == "4", "other values resolve a node of their own");
+
+		std::shared_ptr<const pugi::xml_document> plainHolder;
+		check(configuration.resolvedNode(1, parameters, plainHolder) == configuration.entries()[1].node && plainHolder == nullptr,
+			"a node without references is used as it is");
+		check(configuration.resolvedNode(2, parameters, plainHolder) == configuration.entries()[2].node && plainHolder == nullptr,
+			"a '$' without braces is no reference");
+
+		runConfiguration(R"(
+<Simulation start="0" duration="10">
+	<ExchangeAgent name="MARKET${seed}" algorithm="PriceTime"/>
+</Simulation>
+)");
+	});
+}
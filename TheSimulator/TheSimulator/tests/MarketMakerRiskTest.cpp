@@ -0,0 +1,146 @@
+#include "AgentFactory.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "Simulation.h"
+#include "AngusAgents/MarketMaker.h"
+#include "TestSupport.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// A market maker whose position goes beyond its max_risk flattens it with a market order, the fills of that order have to
+// reach the position as well as those of its quotes: the position is back within max_risk shortly after it has gone
+// beyond it, and it is the one the trades of the market maker's orders add up to, but for the fills still on their way.
+
+// A market maker also following the trade feed of the exchange, which it does not see itself, to check its position
+class CheckedMarketMaker : public MarketMakerAgent {
+public:
+	CheckedMarketMaker(const Simulation* simulation)
+		: MarketMakerAgent(simulation), m_riskLimit(0), m_inFlight(0), m_isBeyondRisk(false), m_beyondRiskSince(0),
+		m_episodeCount(0), m_longestEpisode(0), m_flattenCount(0) { }
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override {
+		MarketMakerAgent::configure(node, configurationPath);
+		m_exchange = node.attribute("exchange_1").as_string();
+		m_riskLimit = node.attribute("riskLimit").as_ullong();
+		m_inFlight = node.attribute("inFlight").as_ullong();
+	}
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		const Timestamp now = simulation()->currentTimestamp();
+		if (messagePtr->topic != TOPICID_INVALID) {
+			// the trade feed is the test's
+			m_trades.push_back(std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload)->trade);
+			return;
+		}
+
+		if (messagePtr->type == "EVENT_SIMULATION_START") {
+			simulation()->dispatchMessage(now, 0, name(), m_exchange, "SUBSCRIBE_EVENT_TRADE", std::make_shared<EmptyPayload>());
+		} else if (messagePtr->type == "RESPONSE_PLACE_ORDERS") {
+			for (OrderID id : std::dynamic_pointer_cast<PlaceOrdersResponsePayload>(messagePtr->payload)->ids) {
+				m_orders.insert(id);
+			}
+		} else if (messagePtr->type == "RESPONSE_PLACE_ORDER_MARKET") {
+			m_orders.insert(std::dynamic_pointer_cast<PlaceOrderMarketResponsePayload>(messagePtr->payload)->id);
+			++m_flattenCount;
+		}
+
+		MarketMakerAgent::receiveMessage(messagePtr);
+
+		if (messagePtr->type == "RESPONSE_RETRIEVE_L1") {
+			checkRisk(now);
+		} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+			checkRisk(now);
+			checkPosition(now);
+		}
+	}
+private:
+	std::string m_exchange;
+	Timestamp m_riskLimit;
+	Timestamp m_inFlight;
+
+	bool m_isBeyondRisk;
+	Timestamp m_beyondRiskSince;
+	size_t m_episodeCount;
+	Timestamp m_longestEpisode;
+	size_t m_flattenCount;
+
+	std::unordered_set<OrderID> m_orders;
+	std::vector<Trade> m_trades;
+
+	void checkRisk(Timestamp now) {
+		const bool isBeyondRisk = (uint64_t)std::llabs(position()) > maxRisk();
+		if (isBeyondRisk && !m_isBeyondRisk) {
+			m_beyondRiskSince = now;
+			++m_episodeCount;
+		}
+		m_isBeyondRisk = isBeyondRisk;
+
+		if (isBeyondRisk) {
+			m_longestEpisode = std::max(m_longestEpisode, now - m_beyondRiskSince);
+			check(now - m_beyondRiskSince <= m_riskLimit, name() + ": the position " + std::to_string(position()) + " has been beyond max_risk since "
+				+ std::to_string(m_beyondRiskSince) + ", it still is at " + std::to_string(now));
+		}
+	}
+
+	void checkPosition(Timestamp now) {
+		int64_t position = 0;
+		Volume recentVolume = 0;
+		for (const Trade& trade : m_trades) {
+			const bool isAggressing = m_orders.count(trade.aggressingOrderID()) > 0;
+			const bool isResting = m_orders.count(trade.restingOrderID()) > 0;
+			const int64_t bought = trade.direction() == OrderDirection::Buy ? (int64_t)trade.volume() : -(int64_t)trade.volume();
+			position += (isAggressing ? bought : 0) - (isResting ? bought : 0);
+			if ((isAggressing || isResting) && trade.timestamp() + m_inFlight >= now) {
+				recentVolume += trade.volume();
+			}
+		}
+
+		std::cout << name() << ": position " << this->position() << ", " << position << " by the trade feed; " << m_episodeCount
+			<< " times beyond max_risk, for at most " << m_longestEpisode << ", " << m_flattenCount << " flattening orders" << std::endl;
+		check((uint64_t)std::llabs(this->position() - position) <= recentVolume, name() + ": the position " + std::to_string(this->position())
+			+ " is the one of the trades, " + std::to_string(position) + " but for the last fills");
+		// one flattening order at a time, a second one only if the first one has left some of the position
+		check(m_flattenCount <= 2 * m_episodeCount, name() + ": " + std::to_string(m_flattenCount) + " flattening orders for "
+			+ std::to_string(m_episodeCount) + " times beyond max_risk");
+	}
+};
+
+static const char* const CONFIGURATION = R"(
+<Simulation start="0" duration="3000">
+	<ExchangeAgent name="MARKET1" algorithm="PriceTime" processingDelay="%DELAY%"/>
+	<MomentumAgent name="MOMENTUM_AGENT" count="10" exchange_1="MARKET1" cancel_probability="0.3" market_to_limit_ratio="5.0"
+		num_momentum_traders="10" demand_saturation="9.0" alpha="0.7" beta="0.02"/>
+	<CheckedMarketMaker name="MARKET_MAKER_AGENT" count="10" exchange_1="MARKET1" num_market_makers="10" limit_order_probability="0.6"
+		cancel_probability="0.2" restart_interval="20" spread="0.5" max_risk="20" riskLimit="%LIMIT%" inFlight="%INFLIGHT%"/>
+	<NoiseAgent name="NOISE_AGENT" count="10" exchange_1="MARKET1" cancel_probability="0.3" market_to_limit_ratio="5.0"
+		num_noise_traders="10" sigma="0.6"/>
+	<ExchangePopulator name="EXCHANGE_POPULATOR" exchange="MARKET1" initial_price="50.0" quantity_per_level="100"
+		num_levels_both_sides="1000" level_spacing="0.5"/>
+</Simulation>
+)";
+
+static void runMarketMakers(Timestamp delay, const std::string& seed) {
+	// the market maker polls every time unit and a message takes 1 there, plus the processing delay back: the flattening
+	// order is sent on the poll seeing the position beyond max_risk, the poll after its response sees its fills
+	std::string text = CONFIGURATION;
+	replaceAll(text, "%DELAY%", std::to_string(delay));
+	replaceAll(text, "%LIMIT%", std::to_string(4 + 2 * delay));
+	replaceAll(text, "%INFLIGHT%", std::to_string(2 + delay));
+
+	std::cout << "processing delay " << delay << ", seed " << seed << std::endl;
+	runConfiguration(text, seed);
+}
+
+int main() {
+	AgentFactory::instance().registerAgent<CheckedMarketMaker>("CheckedMarketMaker");
+
+	return runChecks([] {
+		for (const char* seed : { "5", "7" }) {
+			runMarketMakers(0, seed);
+			runMarketMakers(3, seed);
+		}
+	});
+}
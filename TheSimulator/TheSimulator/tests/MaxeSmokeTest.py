@@ -0,0 +1,92 @@
+# A tiny simulation run through maxe.run, with one Python agent placing its orders as REQUEST_DTYPE records: the orders
+# reach the exchange, the agent gets the responses and the trade as MESSAGE_DTYPE records, and the capture agent's
+# buffers come back as NumPy arrays. An agent returning anything but a 1-dimensional array of REQUEST_DTYPE records
+# fails the run.
+import sys
+import types
+
+import numpy as np
+
+import maxe
+
+
+class SmokeAgent:
+    # every instance, to look at what they received once the run is over
+    instances = []
+
+    def __init__(self):
+        self.records = []
+        self.writeable = []
+        self.isMalformed = False
+        SmokeAgent.instances.append(self)
+
+    def configure(self, parameters):
+        self.isMalformed = parameters.get("malformed") == "true"
+
+    def receiveMessages(self, timestamp, messages):
+        self.records.extend(messages.tolist())
+        self.writeable.append(messages.flags.writeable)
+        if self.isMalformed:
+            return np.zeros((2, 2), dtype=maxe.REQUEST_DTYPE)
+        if not np.any(messages["type"] == maxe.MESSAGE_SIMULATION_START):
+            return None
+
+        requests = np.zeros(4, dtype=maxe.REQUEST_DTYPE)
+        requests[0] = (maxe.REQUEST_SUBSCRIBE_TRADES, 0, 0, 0, 0.0, 1)
+        requests[1] = (maxe.REQUEST_PLACE_LIMIT_ORDER, maxe.SELL, 0, 10, 100.0, 1)
+        requests[2] = (maxe.REQUEST_PLACE_LIMIT_ORDER, maxe.BUY, 0, 10, 99.0, 1)
+        requests[3] = (maxe.REQUEST_PLACE_MARKET_ORDER, maxe.BUY, 0, 4, 0.0, 3)
+        return requests
+
+
+# the simulation imports the agent class named after its node, from the module of the same name
+module = types.ModuleType("SmokeAgent")
+module.SmokeAgent = SmokeAgent
+sys.modules["SmokeAgent"] = module
+
+CONFIGURATION = """
+<Simulation start="0" duration="20">
+    <ExchangeAgent name="MARKET1" algorithm="PriceTime"/>
+    <CaptureAgent name="CAPTURE" exchange="MARKET1"/>
+    <SmokeAgent name="PYTHON_AGENT" exchange="MARKET1" malformed="${malformed}"/>
+</Simulation>
+"""
+
+failures = []
+
+
+def check(condition, what):
+    if not condition:
+        print("FAILED: " + what, file=sys.stderr)
+        failures.append(what)
+
+
+result = maxe.run(CONFIGURATION, {"seed": 5, "malformed": "false"})
+agent = SmokeAgent.instances[-1]
+
+captured = result["CAPTURE"]
+check(captured["trades"].dtype == maxe.TRADE_DTYPE, "the trades come as TRADE_DTYPE records")
+check(captured["orders"].dtype == maxe.ORDER_DTYPE, "the order events come as ORDER_DTYPE records")
+trades = captured["trades"]
+check(len(trades) == 1 and trades[0]["volume"] == 4 and trades[0]["price"] == 100.0, "the market order traded with the resting sell order")
+check(len(captured["orders"]) == 3, "the three orders of the agent reached the exchange")
+
+records = np.array(agent.records, dtype=maxe.MESSAGE_DTYPE)
+messageTypes = list(records["type"])
+check(messageTypes.count(maxe.MESSAGE_LIMIT_ORDER_PLACED) == 2, "the agent got the responses to its limit orders")
+check(messageTypes.count(maxe.MESSAGE_MARKET_ORDER_PLACED) == 1, "the agent got the response to its market order")
+agentTrades = records[records["type"] == maxe.MESSAGE_TRADE]
+check(len(agentTrades) == 1 and agentTrades[0]["volume"] == 4 and agentTrades[0]["price"] == 100.0, "the agent got the trade")
+check(messageTypes.count(maxe.MESSAGE_SIMULATION_STOP) == 1, "the agent got the end of the simulation")
+check(not any(agent.writeable), "the messages are read-only")
+
+try:
+    maxe.run(CONFIGURATION, {"seed": 5, "malformed": "true"})
+    check(False, "an agent returning a 2-dimensional array fails the run")
+except maxe.SimulationError:
+    pass
+
+if failures:
+    print(str(len(failures)) + " checks failed", file=sys.stderr)
+    sys.exit(1)
+print("all checks passed")
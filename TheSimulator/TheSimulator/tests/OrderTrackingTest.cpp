@@ -0,0 +1,118 @@
+#include "Agent.h"
+#include "AgentFactory.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "OrderTracker.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// What an order tracker reports as filled: the fills of an order before its subscription come with the responses, the
+// rest of it as trade events. What an IOC order could not match, or what of a GTD order expired before its subscription
+// reached the exchange, is gone without having traded, none of it is a fill.
+
+// Places its orders on a script, tracks each of them under its own owner and sums up the fills the tracker reports
+class ScriptedTrackingAgent : public Agent {
+public:
+	ScriptedTrackingAgent(const Simulation* simulation)
+		: Agent(simulation) { }
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override {
+		Agent::configure(node, configurationPath);
+		m_exchange = node.attribute("exchange").as_string();
+	}
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		const Timestamp now = simulation()->currentTimestamp();
+		if (messagePtr->type == "EVENT_SIMULATION_START") {
+			// resting at 0, filled by the IOC order after its subscription
+			placeLimit(0, std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, 5, 100), RESTING);
+			// expires at 6, its subscription only reaches the exchange at 11; 4 of it trade at 3 with the market order
+			placeLimit(1, std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Sell, 10, 110, TimeInForce::GTD, 6), GTD);
+			// takes the 5 resting at 100, the other 3 are dropped
+			placeLimit(2, std::make_shared<PlaceOrderLimitPayload>(OrderDirection::Buy, 8, 100, TimeInForce::IOC), IOC);
+			simulation()->dispatchMessage(now, 3, name(), m_exchange, "PLACE_ORDER_MARKET", std::make_shared<PlaceOrderMarketPayload>(OrderDirection::Buy, 4));
+			// the IOC order takes the 2 of the order ahead of it in the same request, the other 1 is dropped
+			auto ordersptr = std::make_shared<PlaceOrdersPayload>(std::vector<PlaceOrdersOrder>{
+				PlaceOrdersOrder(OrderDirection::Buy, 2, 95),
+				PlaceOrdersOrder(OrderDirection::Sell, 3, 90, TimeInForce::IOC)
+			});
+			simulation()->dispatchMessage(now, 4, name(), m_exchange, "PLACE_ORDERS", ordersptr);
+		} else if (messagePtr->type == "RESPONSE_PLACE_ORDER_LIMIT") {
+			auto pptr = std::dynamic_pointer_cast<PlaceOrderLimitResponsePayload>(messagePtr->payload);
+			const OrderOwner owner = m_owners[pptr->requestPayload];
+			m_placedFills[owner] = pptr->filledVolume;
+			// the GTD order's subscription arrives after its expiry
+			const Timestamp delay = owner == GTD ? 10 : 0;
+			auto subscription = std::make_shared<OrderTrackingPayload>(pptr->id, pptr->requestPayload->direction, pptr->requestPayload->volume, owner);
+			simulation()->dispatchMessage(now, delay, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_TRADE", subscription);
+		} else if (messagePtr->type == "RESPONSE_PLACE_ORDERS") {
+			auto pptr = std::dynamic_pointer_cast<PlaceOrdersResponsePayload>(messagePtr->payload);
+			check(pptr->filledVolumes == std::vector<Volume>{ 0, 2 }, name() + ": the bulk response tells what each limit order traded on arrival");
+			for (size_t i = 0; i < pptr->ids.size(); ++i) {
+				const PlaceOrdersOrder& order = pptr->requestPayload->orders[i];
+				auto subscription = std::make_shared<OrderTrackingPayload>(pptr->ids[i], order.direction, order.volume, (OrderOwner)(BULK + i));
+				simulation()->dispatchMessage(now, 0, name(), m_exchange, "SUBSCRIBE_EVENT_ORDER_TRADE", subscription);
+			}
+		} else if (messagePtr->type == "RESPONSE_SUBSCRIBE_EVENT_ORDER_TRADE") {
+			m_orders.insertSubscribed(*messagePtr, [this](OrderOwner owner, OrderDirection, Volume volume) {
+				m_fills[owner] += volume;
+			});
+		} else if (messagePtr->type == "EVENT_TRADE") {
+			auto pptr = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload);
+			m_orders.fillTrade(pptr->trade, now, [this](OrderOwner owner, OrderDirection, Volume volume) {
+				m_fills[owner] += volume;
+			});
+		} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+			checkFills();
+		}
+	}
+private:
+	enum : OrderOwner { RESTING = 1, GTD, IOC, BULK };
+
+	std::string m_exchange;
+	OrderTracker m_orders;
+	std::map<std::shared_ptr<PlaceOrderLimitPayload>, OrderOwner> m_owners;
+	// what the responses placing the orders told, and what the tracker reported, by owner
+	std::map<OrderOwner, Volume> m_placedFills;
+	std::map<OrderOwner, Volume> m_fills;
+
+	void placeLimit(Timestamp delay, const std::shared_ptr<PlaceOrderLimitPayload>& pptr, OrderOwner owner) {
+		m_owners[pptr] = owner;
+		simulation()->dispatchMessage(simulation()->currentTimestamp(), delay, name(), m_exchange, "PLACE_ORDER_LIMIT", pptr);
+	}
+
+	void checkFills() {
+		check(m_placedFills[RESTING] == 0, name() + ": the resting order has not traded on arrival");
+		check(m_placedFills[GTD] == 0, name() + ": the GTD order has not traded on arrival");
+		check(m_placedFills[IOC] == 5, name() + ": the IOC response tells what it traded, not what it asked for");
+
+		check(m_fills[RESTING] == 5, name() + ": the fill of the resting order came as its trade event");
+		check(m_fills[GTD] == 4, name() + ": the expired rest of the GTD order is not a fill, "
+			+ std::to_string(m_fills[GTD]) + " reported");
+		check(m_fills[IOC] == 5, name() + ": the dropped rest of the IOC order is not a fill, "
+			+ std::to_string(m_fills[IOC]) + " reported");
+		check(m_fills[BULK] == 2, name() + ": the bulk limit order filled by the IOC order after it");
+		check(m_fills[BULK + 1] == 2, name() + ": the dropped rest of the bulk IOC order is not a fill, "
+			+ std::to_string(m_fills[BULK + 1]) + " reported");
+		check(m_orders.empty(), name() + ": no order is left to track");
+	}
+};
+
+static const char* const CONFIGURATION = R"(
+<Simulation start="0" duration="20">
+	<ExchangeAgent name="MARKET1" algorithm="PriceTime"/>
+	<ScriptedTrackingAgent name="TRACKING_AGENT" exchange="MARKET1"/>
+</Simulation>
+)";
+
+int main() {
+	AgentFactory::instance().registerAgent<ScriptedTrackingAgent>("ScriptedTrackingAgent");
+
+	return runChecks([] {
+		runConfiguration(CONFIGURATION);
+	});
+}
@@ -0,0 +1,110 @@
+#include "AgentFactory.h"
+#include "ExchangeAgent.h"
+#include "ExchangeAgentMessagePayloads.h"
+#include "Simulation.h"
+#include "AngusAgents/MarketMakerPopulation.h"
+#include "AngusAgents/MomentumPopulation.h"
+#include "AngusAgents/NoisePopulation.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+// The trading agents subscribe to the trade events of each of their limit orders, the fills have to reach their order
+// trackers: an order the exchange does not hold anymore leaves the tracker as soon as the event of its last fill, or the
+// response to its cancellation, has arrived. That includes the fills before the subscription and those arriving before
+// the response to it.
+
+// A population checking its tracker against the book on every pass; the momentum traders place too few limit orders in
+// a short run for any of them to be sure to fill
+template<class Population>
+class CheckedPopulation : public Population {
+public:
+	CheckedPopulation(const Simulation* simulation)
+		: Population(simulation), m_staleLimit(0), m_isFilling(false), m_fillCount(0), m_checkCount(0) { }
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override {
+		Population::configure(node, configurationPath);
+		m_staleLimit = node.attribute("staleLimit").as_ullong();
+		m_isFilling = node.attribute("fills").as_bool();
+	}
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		if (messagePtr->type == "EVENT_TRADE") {
+			auto pptr = std::dynamic_pointer_cast<EventTradePayload>(messagePtr->payload);
+			OrderID id;
+			TraderIndex trader;
+			bool isAggressor;
+			if (this->orders.attribute(pptr->trade, id, trader, isAggressor)) {
+				++m_fillCount;
+			}
+		} else if (messagePtr->type == "RESPONSE_RETRIEVE_L1") {
+			checkTracker();
+		} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+			std::cout << this->name() << ": " << m_fillCount << " fills of tracked orders, " << m_checkCount << " orders checked" << std::endl;
+			check(!m_isFilling || m_fillCount > 0, this->name() + ": fills reached the tracker");
+		}
+		Population::receiveMessage(messagePtr);
+	}
+private:
+	Timestamp m_staleLimit;
+	bool m_isFilling;
+	size_t m_fillCount;
+	size_t m_checkCount;
+	// the tracked orders the book does not hold, by when that was first seen
+	std::unordered_map<OrderID, Timestamp> m_goneSince;
+
+	void checkTracker() {
+		const Timestamp now = this->simulation()->currentTimestamp();
+		const BookPtr book = dynamic_cast<ExchangeAgent*>(this->simulation()->findAgent(this->exchange_1))->book();
+		for (OrderID id : this->orders.ids()) {
+			++m_checkCount;
+			LimitOrderPtr order;
+			if (book->tryGetOrder(id, order) && order->volume() + order->hiddenVolume() > 0) {
+				continue;
+			}
+			const Timestamp since = m_goneSince.emplace(id, now).first->second;
+			check(now - since <= m_staleLimit, this->name() + ": order " + std::to_string(id) + " has left the book at "
+				+ std::to_string(since) + ", it is still tracked at " + std::to_string(now));
+		}
+	}
+};
+
+// the market makers quote wider than the noise traders, the market orders reach the limit orders of both
+static const char* const CONFIGURATION = R"(
+<Simulation start="0" duration="3000">
+	<ExchangeAgent name="MARKET1" algorithm="PriceTime" processingDelay="%DELAY%"/>
+	<CheckedMomentumPopulation name="MOMENTUM_POPULATION" exchange_1="MARKET1" population_size="10" cancel_probability="0.3"
+		market_to_limit_ratio="5.0" num_momentum_traders="10" demand_saturation="9.0" alpha="0.7" beta="0.02"
+		staleLimit="%STALE%" fills="false"/>
+	<CheckedMarketMakerPopulation name="MARKET_MAKER_POPULATION" exchange_1="MARKET1" population_size="10" limit_order_probability="0.6"
+		cancel_probability="0.2" restart_interval="20" spread="1.5" max_risk="300" staleLimit="%STALE%" fills="true"/>
+	<CheckedNoisePopulation name="NOISE_POPULATION" exchange_1="MARKET1" population_size="10" cancel_probability="0.3"
+		market_to_limit_ratio="5.0" num_noise_traders="10" sigma="0.6" staleLimit="%STALE%" fills="true"/>
+	<ExchangePopulator name="EXCHANGE_POPULATOR" exchange="MARKET1" initial_price="50.0" quantity_per_level="100"
+		num_levels_both_sides="1000" level_spacing="0.5"/>
+</Simulation>
+)";
+
+static void runPopulations(Timestamp delay) {
+	// the orders are sent with a delay of 1, and so are the cancellations; the last fill's event or the response to the
+	// cancellation is in at most the way there and back plus the exchange's processing
+	std::string text = CONFIGURATION;
+	replaceAll(text, "%DELAY%", std::to_string(delay));
+	replaceAll(text, "%STALE%", std::to_string(2 + delay));
+
+	std::cout << "processing delay " << delay << std::endl;
+	runConfiguration(text);
+}
+
+int main() {
+	AgentFactory::instance().registerAgent<CheckedPopulation<MomentumPopulationAgent>>("CheckedMomentumPopulation");
+	AgentFactory::instance().registerAgent<CheckedPopulation<MarketMakerPopulationAgent>>("CheckedMarketMakerPopulation");
+	AgentFactory::instance().registerAgent<CheckedPopulation<NoisePopulationAgent>>("CheckedNoisePopulation");
+
+	return runChecks([] {
+		runPopulations(0);
+		runPopulations(3);
+	});
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ExpandedConfiguration.h"
+#include "ParameterStorage.h"
+#include "Simulation.h"
+#include "SimulationException.h"
+
+#include <iostream>
+#include <string>
+
+// The checks of a test are counted rather than aborting it, a test fails as a whole if any of them did; only the first
+// failures are printed, one broken invariant tends to fail the same check over and over again.
+
+inline int failureCount = 0;
+
+inline void check(bool condition, const std::string& what) {
+	if (!condition) {
+		if (failureCount < 20) {
+			std::cerr << "FAILED: " << what << std::endl;
+		}
+		++failureCount;
+	}
+}
+
+// fills in the %PLACEHOLDERS% of a configuration template
+inline void replaceAll(std::string& text, const std::string& from, const std::string& to) {
+	for (size_t position = text.find(from); position != std::string::npos; position = text.find(from, position + to.size())) {
+		text.replace(position, from.size(), to);
+	}
+}
+
+// runs the simulation of the configuration text to its end
+inline void runConfiguration(const std::string& text, const std::string& seed = "5") {
+	pugi::xml_document document;
+	document.load_string(text.c_str());
+	ExpandedConfiguration configuration;
+	configuration.configure(document.child("Simulation"), "");
+
+	ParameterStorage parameters;
+	parameters.set("seed", seed);
+	Simulation simulation(&parameters);
+	simulation.configure(configuration);
+	simulation.simulate();
+}
+
+// runs the checks of a test, returns the exit code of the test: 0 if every check passed
+template<class Checks>
+int runChecks(Checks checks) {
+	try {
+		checks();
+	} catch (const SimulationException& ex) {
+		std::cerr << "FAILED: " << ex.what() << std::endl;
+		return 1;
+	}
+
+	if (failureCount > 0) {
+		std::cerr << failureCount << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "Agent.h"
+#include "AgentFactory.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// How the events of a topic reach its subscribers: all of them in sequence, or for a conflating subscriber one at a time,
+// each the latest published while the one before was on its way. A publisher faster than the delivery does not starve a
+// conflating subscriber, and no event reaches it before its delay has passed. Over a link with a latency model, each
+// event's latency is a sample of its own, yet none arrives before the one published before it.
+
+static const char* const TOPIC = "TICKER";
+static const Timestamp PUBLISH_DELAY = 3;
+static const Timestamp LAST_PUBLISHING = 19;
+
+// publishes an event every time unit, each taking PUBLISH_DELAY to arrive
+class TickerAgent : public Agent {
+public:
+	TickerAgent(const Simulation* simulation)
+		: Agent(simulation), m_topic(TOPICID_INVALID) { }
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		if (messagePtr->type == "EVENT_SIMULATION_START") {
+			m_topic = simulation()->registerTopic(TOPIC);
+			simulation()->scheduleWakeup(this, simulation()->currentTimestamp());
+		}
+	}
+
+	void receiveWakeup(WakeupTag /*tag*/) override {
+		const Timestamp now = simulation()->currentTimestamp();
+		simulation()->publish(now, PUBLISH_DELAY, name(), m_topic, "EVENT_TICK", std::make_shared<EmptyPayload>());
+		if (now < LAST_PUBLISHING) {
+			simulation()->scheduleWakeup(this, now + 1);
+		}
+	}
+private:
+	TopicID m_topic;
+};
+
+class TickerSubscriberAgent : public Agent {
+public:
+	TickerSubscriberAgent(const Simulation* simulation)
+		: Agent(simulation), m_isConflating(false) { }
+
+	void configure(const pugi::xml_node& node, const std::string& configurationPath) override {
+		Agent::configure(node, configurationPath);
+		m_isConflating = node.attribute("conflate").as_bool();
+	}
+
+	void receiveMessage(const MessagePtr& messagePtr) override {
+		if (messagePtr->type == "EVENT_SIMULATION_START") {
+			simulation()->subscribeToTopic(simulation()->registerTopic(TOPIC), handle(), m_isConflating);
+		} else if (messagePtr->type == "EVENT_TICK") {
+			check(messagePtr->arrival == simulation()->currentTimestamp() && messagePtr->arrival >= messagePtr->occurrence + PUBLISH_DELAY,
+				name() + ": event " + std::to_string(messagePtr->topicSequence) + " arrives no earlier than its delay");
+			m_sequences.push_back(messagePtr->topicSequence);
+			m_arrivals.push_back(messagePtr->arrival);
+			m_arrivalsBySequence.emplace(messagePtr->topicSequence, messagePtr->arrival);
+		} else if (messagePtr->type == "EVENT_SIMULATION_STOP") {
+			m_isConflating ? checkConflated() : checkAll();
+		}
+	}
+private:
+	bool m_isConflating;
+	std::vector<uint64_t> m_sequences;
+	std::vector<Timestamp> m_arrivals;
+	std::map<uint64_t, Timestamp> m_arrivalsBySequence;
+
+	void checkAll() {
+		// the events arriving at the same time come in any order
+		check(m_sequences.size() == LAST_PUBLISHING + 1 && m_arrivalsBySequence.size() == LAST_PUBLISHING + 1
+			&& m_arrivalsBySequence.begin()->first == 1, name() + ": every event arrives once");
+		Timestamp previousArrival = 0;
+		for (const auto& [sequence, arrival] : m_arrivalsBySequence) {
+			check(arrival >= previousArrival, name() + ": event " + std::to_string(sequence) + " arrives at "
+				+ std::to_string(arrival) + ", before the one published before it");
+			previousArrival = arrival;
+		}
+	}
+
+	void checkConflated() {
+		// one on its way at a time: event 1 arrives at 3, then the latest published by then, event 3 published at 2, at 6
+		check(m_sequences == std::vector<uint64_t>{ 1, 3, 6, 9, 12, 15, 18, 20 }, name() + ": the events arrive one at a time, "
+			+ std::to_string(m_sequences.size()) + " arrived");
+		check(m_arrivals == std::vector<Timestamp>{ 3, 6, 9, 12, 15, 18, 21, 24 }, name() + ": each event goes out as the one before arrives");
+	}
+};
+
+static const char* const CONFIGURATION = R"(
+<Simulation start="0" duration="30">
+	<TickerAgent name="TICKER"/>
+	<TickerSubscriberAgent name="SUBSCRIBER_ALL" conflate="false"/>
+	<TickerSubscriberAgent name="SUBSCRIBER_CONFLATING" conflate="true"/>
+</Simulation>
+)";
+
+// the far subscriber's link adds up to 10 to the delay of each event, far more than the time between two of them
+static const char* const LATENCY_CONFIGURATION = R"(
+<Simulation start="0" duration="40">
+	<Latency>
+		<Link source="TickerAgent" target="FAR" model="uniform" min="0" max="10"/>
+	</Latency>
+	<TickerAgent name="TICKER"/>
+	<TickerSubscriberAgent name="SUBSCRIBER_FAR" latencyGroup="FAR" conflate="false"/>
+	<TickerSubscriberAgent name="SUBSCRIBER_NEAR" conflate="false"/>
+</Simulation>
+)";
+
+int main() {
+	AgentFactory::instance().registerAgent<TickerAgent>("TickerAgent");
+	AgentFactory::instance().registerAgent<TickerSubscriberAgent>("TickerSubscriberAgent");
+
+	return runChecks([] {
+		runConfiguration(CONFIGURATION);
+		runConfiguration(LATENCY_CONFIGURATION);
+	});
+}
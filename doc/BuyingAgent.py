@@ -1,26 +1,31 @@
+import numpy as np
 from thesimulator import *
 
 class BuyingAgent:
     def configure(self, params):
         # save locally the configuration params passed so that they are properly typed
-        self.exchange = str(params['exchange'])
         self.quantity = int(params['quantity'])
     
-    def receiveMessage(self, simulation, type, payload):
-        currentTimestamp = simulation.currentTimestamp()
+    def receiveMessages(self, timestamp, messages):
+        types = messages['type']
 
-        if type == "EVENT_SIMULATION_START":
-            # Subscribe to receive a message of type "EVENT_ORDER_LIMIT" whenever a limit order is submitted to the exchange `self.exchange`
-            simulation.dispatchMessage(currentTimestamp, 0, self.name(), self.exchange, "SUBSCRIBE_EVENT_ORDER_LIMIT", EmptyPayload())
-            return
-        elif type != "EVENT_ORDER_LIMIT":
-            # Ignore all messages that should not trigger buying (i.e. order placement confirmations, etc.
-            return
+        if (types == MESSAGE_SIMULATION_START).any():
+            # Subscribe to receive a message of type MESSAGE_LIMIT_ORDER_EVENT whenever a limit order is submitted to the configured exchange
+            requests = np.zeros(1, dtype=REQUEST_DTYPE)
+            requests[0]['type'] = REQUEST_SUBSCRIBE_LIMIT_ORDERS
+            return requests
+
+        # Ignore all messages that should not trigger buying (i.e. order placement confirmations, etc.)
+        orderCount = np.count_nonzero(types == MESSAGE_LIMIT_ORDER_EVENT)
+        if orderCount == 0:
+            return None
         
         # Announce our intentions in the standard output
         print("%s:   Buying %d units, then going to sleep to wait for the next order to be submitted" % (self.name(), self.quantity))
 
-        # Place a limit order to buy `self.quantity` units of an instrument at the price `self.price`
-        marketOrderPayload = PlaceOrderMarketPayload(OrderDirection.Buy, self.quantity)
-        simulation.dispatchMessage(currentTimestamp, 0, self.name(), self.exchange, "PLACE_ORDER_MARKET", marketOrderPayload)
-    
\ No newline at end of file
+        # Place one market order to buy `self.quantity` units of an instrument for every limit order seen
+        requests = np.zeros(orderCount, dtype=REQUEST_DTYPE)
+        requests['type'] = REQUEST_PLACE_MARKET_ORDER
+        requests['direction'] = BUY
+        requests['volume'] = self.quantity
+        return requests
@@ -6,7 +6,7 @@ class PrintingAgent:
         print(params)
         print(" ------------------------------------------------- ")
     
-    def receiveMessage(self, simulation, type, payload):
-        currentTimestamp = simulation.currentTimestamp()
-        print("Received a message of type '%s' at time %d, payload %s " % (type, currentTimestamp, payload))
-    
\ No newline at end of file
+    def receiveMessages(self, timestamp, messages):
+        # `messages` is a NumPy structured array of MESSAGE_DTYPE holding everything received at `timestamp`
+        for message in messages:
+            print("Received a message of type %d at time %d" % (message['type'], timestamp))
@@ -1,26 +1,27 @@
+import numpy as np
 from thesimulator import *
 
 class SellingAgent:
     def configure(self, params):
         # save locally the configuration params passed so that they are properly typed
-        self.exchange = str(params['exchange'])
-        self.price = Money(float(params['price']))
+        self.price = float(params['price'])
         self.quantity = int(params['quantity'])
         self.interval = int(params['interval'])
     
-    def receiveMessage(self, simulation, type, payload):
+    def receiveMessages(self, timestamp, messages):
         # Firstly, ignore all messages that should not trigger selling (i.e. order placement confirmations, etc.)
-        if type != "EVENT_SIMULATION_START" and type != "WAKE_UP":
-            return
+        if not np.isin(messages['type'], [MESSAGE_SIMULATION_START, MESSAGE_WAKEUP]).any():
+            return None
         
         # Announce our intentions in the standard output
-        currentTimestamp = simulation.currentTimestamp()
-        print("%s:  Selling %d units for %s, then going to sleep until %d" % (self.name(), self.quantity, self.price.toCentString(), currentTimestamp+self.interval))
+        print("%s:  Selling %d units for %.2f, then going to sleep until %d" % (self.name(), self.quantity, self.price, timestamp+self.interval))
+
+        requests = np.zeros(2, dtype=REQUEST_DTYPE)
+
+        # Place a limit order to sell `self.quantity` units of an instrument at the price `self.price` at the configured exchange
+        requests[0] = (REQUEST_PLACE_LIMIT_ORDER, SELL, 0, self.quantity, self.price, 1)
 
         # Schedule the (first/next) wakeup message `self.interval` time units later
-        simulation.dispatchGenericMessage(currentTimestamp, self.interval, self.name(), self.name(), "WAKE_UP", {})
+        requests[1] = (REQUEST_WAKEUP, 0, 0, 0, 0.0, self.interval)
 
-        # Place a limit order to buy `self.quantity` units of an instrument at the price `self.price`
-        limitOrderPayload = PlaceOrderLimitPayload(OrderDirection.Sell, self.quantity, self.price)
-        simulation.dispatchMessage(currentTimestamp, 0, self.name(), self.exchange, "PLACE_ORDER_LIMIT", limitOrderPayload)
-    
\ No newline at end of file
+        return requests